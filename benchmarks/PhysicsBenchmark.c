@@ -0,0 +1,367 @@
+#include "RJGlobal.h"
+
+#include "systems/Physics.h"
+#include "tools/Entity.h"
+#include "utilities/Maths.h"
+#include "utilities/ThreadPool.h"
+#include "utilities/Timer.h"
+
+#include <math.h>
+
+#pragma region Source Only
+
+/// @brief Fixed step of every benchmark step in seconds.
+#define BENCHMARK_DELTA_TIME (1.0f / 60.0f)
+/// @brief Steps run before measuring so the scenes settle into their typical state.
+#define BENCHMARK_WARMUP_STEPS 10
+/// @brief Measured steps of every run if not given as an argument.
+#define BENCHMARK_DEFAULT_STEPS 120
+/// @brief Seed of every scene, scenes are the same on every run.
+#define BENCHMARK_SEED 0x5eed
+/// @brief Number of boxes in every column of the stack scene.
+#define BENCHMARK_STACK_HEIGHT 32
+
+/// @brief Creates the components of a scene with the given body count.
+typedef void (*BENCHMARK_SCENE_SETUP)(RJ_Size bodyCount);
+
+/// @brief Scenario that is run for every body count.
+typedef struct BENCHMARK_SCENE
+{
+    const char *name;
+    BENCHMARK_SCENE_SETUP setup;
+} BENCHMARK_SCENE;
+
+/// @brief Measured values of a single run.
+typedef struct BENCHMARK_RESULT
+{
+    const char *scene;
+    RJ_Size bodyCount;
+    RJ_Size stepCount;
+    double p50Milliseconds;
+    double p90Milliseconds;
+    double p99Milliseconds;
+    double maxMilliseconds;
+    double bodiesPerSecond;
+    double averageCandidatePairs;
+    double averageContacts;
+} BENCHMARK_RESULT;
+
+/// @brief Creates a dynamic box.
+/// @param position Center of the box.
+/// @param velocity Initial velocity of the box.
+/// @param gravityScale Gravity scale of the box material.
+static void Benchmark_CreateBox(Vector3 position, Vector3 velocity, float gravityScale)
+{
+    Entity entity = Entity_Create(position, Vector3_Zero, Vector3_One);
+
+    Physics_ComponentCreate(entity, Vector3_One, 1.0f, false);
+    Physics_ComponentSetVelocity(entity, velocity);
+
+    PhysicsMaterial material = Physics_ComponentGetMaterial(entity);
+    material.gravityScale = gravityScale;
+    Physics_ComponentSetMaterial(entity, material);
+}
+
+/// @brief Creates a static floor whose top face is at zero height.
+/// @param width Width of the floor on the x and z axes.
+static void Benchmark_CreateFloor(float width)
+{
+    Entity entity = Entity_Create(Vector3_New(0.0f, -0.5f, 0.0f), Vector3_Zero, Vector3_One);
+
+    Physics_ComponentCreate(entity, Vector3_New(width, 1.0f, width), 1.0f, true);
+}
+
+/// @brief Boxes falling onto a floor from random heights, the contact count grows while they land.
+static void Benchmark_SetupRain(RJ_Size bodyCount)
+{
+    float width = sqrtf((float)bodyCount) * 1.5f;
+
+    Benchmark_CreateFloor(width);
+
+    for (RJ_Size body = 1; body < bodyCount; body++)
+    {
+        Vector3 position = Vector3_New(Maths_RandomRangeF(-width * 0.5f, width * 0.5f), Maths_RandomRangeF(2.0f, 42.0f), Maths_RandomRangeF(-width * 0.5f, width * 0.5f));
+        Benchmark_CreateBox(position, Vector3_Zero, 1.0f);
+    }
+}
+
+/// @brief Columns of boxes resting on each other on a floor, every box is in contact from the first step.
+static void Benchmark_SetupStack(RJ_Size bodyCount)
+{
+    RJ_Size columnCount = (bodyCount - 1 + BENCHMARK_STACK_HEIGHT - 1) / BENCHMARK_STACK_HEIGHT;
+    RJ_Size rowLength = (RJ_Size)ceilf(sqrtf((float)columnCount));
+    float width = (float)rowLength * 2.0f;
+
+    Benchmark_CreateFloor(width);
+
+    for (RJ_Size body = 1; body < bodyCount; body++)
+    {
+        RJ_Size column = (body - 1) / BENCHMARK_STACK_HEIGHT;
+        RJ_Size level = (body - 1) % BENCHMARK_STACK_HEIGHT;
+
+        Vector3 position = Vector3_New((float)(column % rowLength) * 2.0f - width * 0.5f, 0.5f + (float)level, (float)(column / rowLength) * 2.0f - width * 0.5f);
+        Benchmark_CreateBox(position, Vector3_Zero, 1.0f);
+    }
+}
+
+/// @brief Weightless boxes drifting in a large volume, mostly broadphase work with few contacts.
+static void Benchmark_SetupSparse(RJ_Size bodyCount)
+{
+    float width = cbrtf((float)bodyCount) * 8.0f;
+
+    for (RJ_Size body = 0; body < bodyCount; body++)
+    {
+        Vector3 position = Vector3_New(Maths_RandomRangeF(-width * 0.5f, width * 0.5f), Maths_RandomRangeF(-width * 0.5f, width * 0.5f), Maths_RandomRangeF(-width * 0.5f, width * 0.5f));
+        Vector3 velocity = Vector3_New(Maths_RandomRangeF(-2.0f, 2.0f), Maths_RandomRangeF(-2.0f, 2.0f), Maths_RandomRangeF(-2.0f, 2.0f));
+        Benchmark_CreateBox(position, velocity, 0.0f);
+    }
+}
+
+/// @brief Weightless boxes packed into a volume smaller than their total size, every box starts penetrating several others.
+static void Benchmark_SetupDense(RJ_Size bodyCount)
+{
+    float width = cbrtf((float)bodyCount) * 0.9f;
+
+    for (RJ_Size body = 0; body < bodyCount; body++)
+    {
+        Vector3 position = Vector3_New(Maths_RandomRangeF(-width * 0.5f, width * 0.5f), Maths_RandomRangeF(-width * 0.5f, width * 0.5f), Maths_RandomRangeF(-width * 0.5f, width * 0.5f));
+        Benchmark_CreateBox(position, Vector3_Zero, 0.0f);
+    }
+}
+
+static const BENCHMARK_SCENE BENCHMARK_SCENES[] = {
+    {"rain", Benchmark_SetupRain},
+    {"stack", Benchmark_SetupStack},
+    {"sparse", Benchmark_SetupSparse},
+    {"dense", Benchmark_SetupDense},
+};
+
+static const RJ_Size BENCHMARK_BODY_COUNTS[] = {1000, 10000, 100000};
+
+/// @brief Compares two step durations for sorting.
+static int Benchmark_CompareDurations(const void *first, const void *second)
+{
+    double a = *(const double *)first;
+    double b = *(const double *)second;
+
+    return (a > b) - (a < b);
+}
+
+/// @brief Gets a percentile of sorted durations with the nearest rank method.
+/// @param sortedDurations Durations sorted in ascending order.
+/// @param count Number of durations.
+/// @param percentile Percentile in [0, 100].
+/// @return Duration at the percentile.
+static double Benchmark_GetPercentile(const double *sortedDurations, RJ_Size count, double percentile)
+{
+    RJ_Size rank = (RJ_Size)ceil(percentile / 100.0 * (double)count);
+
+    return sortedDurations[rank == 0 ? 0 : rank - 1];
+}
+
+/// @brief Creates the scene from scratch and measures its steps.
+/// @param scene Scene to run.
+/// @param bodyCount Number of bodies to create.
+/// @param stepCount Number of steps to measure.
+/// @param threadCount Number of physics threads.
+/// @param broadphase Broadphase to use.
+/// @param retResult Result to fill.
+/// @return RJ_OK / RJ_ERROR_ALLOCATION
+static RJ_Result Benchmark_Run(const BENCHMARK_SCENE *scene, RJ_Size bodyCount, RJ_Size stepCount, RJ_Size threadCount, PhysicsBroadphase broadphase, BENCHMARK_RESULT *retResult)
+{
+    double *durations = NULL;
+    RJ_ReturnAllocate(double, durations, stepCount);
+
+    RJ_Result result = Entity_Initialize(bodyCount);
+
+    if (result == RJ_OK)
+    {
+        result = Physics_Initialize(bodyCount, broadphase, 0.0f, -9.81f, 0.2f);
+
+        if (result == RJ_OK)
+        {
+            result = Physics_SetThreadCount(threadCount);
+
+            if (result != RJ_OK)
+            {
+                Physics_Terminate();
+            }
+        }
+
+        if (result != RJ_OK)
+        {
+            Entity_Terminate();
+        }
+    }
+
+    if (result != RJ_OK)
+    {
+        free(durations);
+        return result;
+    }
+
+    srand(BENCHMARK_SEED);
+    scene->setup(bodyCount);
+
+    for (RJ_Size step = 0; step < BENCHMARK_WARMUP_STEPS; step++)
+    {
+        Physics_UpdateComponents(BENCHMARK_DELTA_TIME);
+        Physics_ResolveCollisions();
+    }
+
+    double totalMilliseconds = 0.0;
+    double totalCandidatePairs = 0.0;
+    double totalContacts = 0.0;
+    Timer timer = Timer_Create("Physics Step");
+
+    for (RJ_Size step = 0; step < stepCount; step++)
+    {
+        Timer_Start(&timer);
+        Physics_UpdateComponents(BENCHMARK_DELTA_TIME);
+        Physics_ResolveCollisions();
+        Timer_Stop(&timer);
+
+        RJ_Size candidatePairCount = 0;
+        RJ_Size contactCount = 0;
+        Physics_GetPairCounts(&candidatePairCount, &contactCount);
+
+        durations[step] = (double)Timer_GetElapsedNanoseconds(&timer) / 1000000.0;
+        totalMilliseconds += durations[step];
+        totalCandidatePairs += (double)candidatePairCount;
+        totalContacts += (double)contactCount;
+    }
+
+    Physics_Terminate();
+    Entity_Terminate();
+
+    qsort(durations, stepCount, sizeof(double), Benchmark_CompareDurations);
+
+    *retResult = (BENCHMARK_RESULT){
+        .scene = scene->name,
+        .bodyCount = bodyCount,
+        .stepCount = stepCount,
+        .p50Milliseconds = Benchmark_GetPercentile(durations, stepCount, 50.0),
+        .p90Milliseconds = Benchmark_GetPercentile(durations, stepCount, 90.0),
+        .p99Milliseconds = Benchmark_GetPercentile(durations, stepCount, 99.0),
+        .maxMilliseconds = durations[stepCount - 1],
+        .bodiesPerSecond = totalMilliseconds > 0.0 ? (double)bodyCount * (double)stepCount / (totalMilliseconds / 1000.0) : 0.0,
+        .averageCandidatePairs = totalCandidatePairs / (double)stepCount,
+        .averageContacts = totalContacts / (double)stepCount,
+    };
+
+    free(durations);
+    return RJ_OK;
+}
+
+/// @brief Prints a result as a table row or as a CSV line.
+/// @param result Result to print.
+/// @param isCsv True to print a CSV line.
+static void Benchmark_Print(const BENCHMARK_RESULT *result, bool isCsv)
+{
+    const char *format = isCsv
+                             ? "%s,%u,%u,%.4f,%.4f,%.4f,%.4f,%.0f,%.1f,%.1f\n"
+                             : "%-8s %8u %6u %10.3f %10.3f %10.3f %10.3f %14.0f %14.1f %12.1f\n";
+
+    printf(format, result->scene, result->bodyCount, result->stepCount,
+           result->p50Milliseconds, result->p90Milliseconds, result->p99Milliseconds, result->maxMilliseconds,
+           result->bodiesPerSecond, result->averageCandidatePairs, result->averageContacts);
+}
+
+#pragma endregion Source Only
+
+int main(int argc, char **argv)
+{
+    RJ_Size threadCount = 1;
+    RJ_Size stepCount = BENCHMARK_DEFAULT_STEPS;
+    RJ_Size maxBodyCount = BENCHMARK_BODY_COUNTS[sizeof(BENCHMARK_BODY_COUNTS) / sizeof(BENCHMARK_BODY_COUNTS[0]) - 1];
+    PhysicsBroadphase broadphase = PhysicsBroadphase_SpatialHash;
+    const char *sceneFilter = NULL;
+    bool isCsv = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *const arg = argv[i];
+
+        if (strcmp(arg, "csv") == 0)
+        {
+            isCsv = true;
+        }
+        else if (strncmp(arg, "threads=", 8) == 0)
+        {
+            threadCount = (RJ_Size)strtoul(arg + 8, NULL, 10);
+        }
+        else if (strncmp(arg, "steps=", 6) == 0)
+        {
+            stepCount = (RJ_Size)strtoul(arg + 6, NULL, 10);
+        }
+        else if (strncmp(arg, "bodies=", 7) == 0)
+        {
+            maxBodyCount = (RJ_Size)strtoul(arg + 7, NULL, 10);
+        }
+        else if (strncmp(arg, "scene=", 6) == 0)
+        {
+            sceneFilter = arg + 6;
+        }
+        else if (strcmp(arg, "broadphase=brute") == 0)
+        {
+            broadphase = PhysicsBroadphase_BruteForce;
+        }
+        else if (strcmp(arg, "broadphase=hash") == 0)
+        {
+            broadphase = PhysicsBroadphase_SpatialHash;
+        }
+        else if (strcmp(arg, "broadphase=sap") == 0)
+        {
+            broadphase = PhysicsBroadphase_SweepAndPrune;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown argument '%s'. Usage is [csv] [threads=<n>] [steps=<n>] [bodies=<max>] [scene=<rain/stack/sparse/dense>] [broadphase=<brute/hash/sap>]\n", arg);
+            return 1;
+        }
+    }
+
+    if (threadCount == 0 || threadCount > THREAD_POOL_MAX_THREAD_COUNT || stepCount == 0)
+    {
+        fprintf(stderr, "Thread count must be in [1, %u] and step count can not be 0.\n", THREAD_POOL_MAX_THREAD_COUNT);
+        return 1;
+    }
+
+    printf(isCsv
+               ? "scene,bodies,steps,p50_ms,p90_ms,p99_ms,max_ms,bodies_per_second,candidate_pairs,contacts\n"
+               : "%-8s %8s %6s %10s %10s %10s %10s %14s %14s %12s\n",
+           "scene", "bodies", "steps", "p50 ms", "p90 ms", "p99 ms", "max ms", "bodies/s", "candidates", "contacts");
+
+    for (RJ_Size sceneIndex = 0; sceneIndex < sizeof(BENCHMARK_SCENES) / sizeof(BENCHMARK_SCENES[0]); sceneIndex++)
+    {
+        const BENCHMARK_SCENE *scene = &BENCHMARK_SCENES[sceneIndex];
+
+        if (sceneFilter != NULL && strcmp(sceneFilter, scene->name) != 0)
+        {
+            continue;
+        }
+
+        for (RJ_Size countIndex = 0; countIndex < sizeof(BENCHMARK_BODY_COUNTS) / sizeof(BENCHMARK_BODY_COUNTS[0]); countIndex++)
+        {
+            RJ_Size bodyCount = BENCHMARK_BODY_COUNTS[countIndex];
+
+            if (bodyCount > maxBodyCount)
+            {
+                continue;
+            }
+
+            BENCHMARK_RESULT result;
+
+            if (Benchmark_Run(scene, bodyCount, stepCount, threadCount, broadphase, &result) != RJ_OK)
+            {
+                fprintf(stderr, "Scene '%s' with %u bodies could not be created.\n", scene->name, bodyCount);
+                return 1;
+            }
+
+            Benchmark_Print(&result, isCsv);
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
@@ -86,6 +86,35 @@
 
 #pragma endregion Compiler Detection
 
+#pragma region Architecture Detection
+
+#define RJ_ARCHITECTURE_X64 0
+#define RJ_ARCHITECTURE_ARM64 1
+#define RJ_ARCHITECTURE_OTHER 2
+
+#if defined(__x86_64__) || defined(_M_X64)
+
+/// @brief Current architecture specifier. Use it with RJ_ARCHITECTURE_<...> macros.
+#define RJ_ARCHITECTURE RJ_ARCHITECTURE_X64
+/// @brief Architecture name string.
+#define RJ_ARCHITECTURE_STRING "X64"
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+
+/// @brief Current architecture specifier. Use it with RJ_ARCHITECTURE_<...> macros.
+#define RJ_ARCHITECTURE RJ_ARCHITECTURE_ARM64
+/// @brief Architecture name string.
+#define RJ_ARCHITECTURE_STRING "ARM64"
+
+#else
+
+/// @brief Current architecture specifier. Use it with RJ_ARCHITECTURE_<...> macros.
+#define RJ_ARCHITECTURE RJ_ARCHITECTURE_OTHER
+/// @brief Architecture name string.
+#define RJ_ARCHITECTURE_STRING "OTHER"
+
+#endif
+
 #define _POSIX_C_SOURCE 200809L
 #define _CRT_SECURE_NO_WARNINGS
 
@@ -109,6 +138,11 @@
 /// @brief Invalid index constant for RJ_Size type.
 #define RJ_INDEX_INVALID ((RJ_Size)UINT32_MAX)
 
+/// @brief Default number of fixed loop callback calls per second.
+#define RJ_FIXED_STEP_DEFAULT_RATE 60.0f
+/// @brief Default maximum number of fixed loop callback calls in a single frame.
+#define RJ_FIXED_STEP_DEFAULT_MAX_SUBSTEPS 5
+
 /// @brief Macro wrapper for file opening to use it in if statements.
 #define RJ_FileOpen(filePointer, fileName, mode) (((filePointer) = fopen(fileName, mode)) != NULL)
 /// @brief Macro wrapper for memory allocation operation. Pass char if the pointer type os void.
@@ -116,6 +150,9 @@
 /// @brief Macro wrapper for memory reallocation operation. Pass char if the pointer type os void.
 #define RJ_Reallocate(type, pointer, newCount) (((pointer) = (type *)realloc((pointer), sizeof(type) * (newCount))) != NULL)
 
+/// @brief Macro wrapper for aligned memory allocation operation. Memory is zero initialized and must be freed with RJ_FreeAligned.
+#define RJ_AllocateAligned(type, pointer, count, alignment) (((pointer) = (type *)RJ_AllocateAlignedMemory(sizeof(type) * (count), (alignment))) != NULL)
+
 /// @brief Macro wrapper for returning error code directly for file open. Use in functions that return RJ_Result. Variadic parameter is for cleanup commands if failed.
 #define RJ_ReturnFileOpen(filePointer, fileName, mode, ...)                               \
     do                                                                                    \
@@ -140,6 +177,18 @@
         }                                                                                                                     \
     } while (0)
 
+/// @brief Macro wrapper for returning error code directly for aligned memory allocation. Use in functions that return RJ_Result. Variadic parameter is for cleanup commands if failed.
+#define RJ_ReturnAllocateAligned(type, pointer, count, alignment, ...)                                                                \
+    do                                                                                                                                \
+    {                                                                                                                                 \
+        if (!RJ_AllocateAligned(type, pointer, count, alignment))                                                                     \
+        {                                                                                                                             \
+            RJ_DebugWarning("Aligned memory allocation failed for %zu bytes for type '%s'.", (RJ_Size)(count) * sizeof(type), #type); \
+            __VA_ARGS__                                                                                                               \
+            return RJ_ERROR_ALLOCATION;                                                                                               \
+        }                                                                                                                             \
+    } while (0)
+
 /// @brief Macro wrapper for returning error code directly for memory reallocation. Use in functions that return RJ_Result. Variadic parameter is for cleanup commands if failed.
 #define RJ_ReturnReallocate(type, pointer, newCount, ...)                                                                          \
     do                                                                                                                             \
@@ -152,6 +201,24 @@
         }                                                                                                                          \
     } while (0)
 
+/// @brief Macro wrapper for resizing a buffer that keeps it untouched if reallocation fails. Items added by growing are filled with the fill byte. Use in functions that return RJ_Result. Variadic parameter is for cleanup commands if failed.
+#define RJ_ReturnResize(type, pointer, oldCount, newCount, fillByte, ...)                                                      \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        type *resized = (type *)realloc((pointer), sizeof(type) * (newCount));                                                 \
+        if (resized == NULL)                                                                                                   \
+        {                                                                                                                      \
+            RJ_DebugWarning("Memory resize failed for %zu bytes for type '%s'.", (RJ_Size)(newCount) * sizeof(type), #type); \
+            __VA_ARGS__                                                                                                        \
+            return RJ_ERROR_ALLOCATION;                                                                                        \
+        }                                                                                                                      \
+        if ((RJ_Size)(newCount) > (RJ_Size)(oldCount))                                                                         \
+        {                                                                                                                      \
+            memset(resized + (oldCount), (fillByte), sizeof(type) * ((newCount) - (oldCount)));                                \
+        }                                                                                                                      \
+        (pointer) = resized;                                                                                                   \
+    } while (0)
+
 #pragma region Typedefs
 
 /// @brief Function pointer type used in setup callback function.
@@ -199,6 +266,16 @@ typedef enum RJ_Result
 /// @note The log message is written to a file named 'RJ_DEBUG_FILE_NAME' macro which is defined in the header. Directory and name can be changed by modifying the macro.
 RJ_Result RJ_Log(RJ_Result terminate, const char *header, const char *file, int line, const char *function, const char *format, ...);
 
+/// @brief Allocates zero initialized memory aligned to the given boundary. Use RJ_AllocateAligned wrapper for ease of use.
+/// @param size Size of the memory in bytes. Rounded up to a multiple of the alignment internally.
+/// @param alignment Alignment of the memory in bytes. Must be a power of two.
+/// @return Pointer to the allocated memory, NULL on failure.
+void *RJ_AllocateAlignedMemory(size_t size, size_t alignment);
+
+/// @brief Frees memory allocated with RJ_AllocateAlignedMemory.
+/// @param pointer Pointer to free. Can be NULL.
+void RJ_FreeAligned(void *pointer);
+
 /// @brief Gets the executable file directory.
 /// @return The null terminated C string : "path/to/exe/"
 const char *RJ_GetExecutablePath(void);
@@ -207,6 +284,7 @@ const char *RJ_GetExecutablePath(void);
 /// @param argc Command line argument count
 /// @param argv Command line argument values
 /// @note This function will run indefinitely until the loop callback is set to NULL. if the setup callback is NULL it returns normally.
+/// @note Delta times are measured with the monotonic clock and are never negative. If a fixed loop callback is set, elapsed time is accumulated every frame and the fixed callback is called once per whole fixed step before the loop callback. At most the maximum substep count of steps run in a frame, the rest of a slow frame is dropped so the fixed work can not spiral.
 void RJ_Run(int argc, char **argv);
 
 /// @brief Terminates and cleans up the internals, terminates after calling the terminate callback .
@@ -222,6 +300,19 @@ void RJ_SetSetupCallback(RJ_VoidFunIntCharPtrPtr setupCallback);
 /// @param loopCallback Function to call every frame, receives deltatime in seconds as parameter
 void RJ_SetLoopCallback(RJ_VoidFunFloat loopCallback);
 
+/// @brief Sets the fixed loop callback function that gets called with a constant delta time, like physics steps. NULL disables the fixed loop.
+/// @param fixedLoopCallback Function to call every fixed step, receives the fixed step in seconds as parameter. Call Entity_StorePreviousPositions at its start so entities can be interpolated.
+void RJ_SetFixedLoopCallback(RJ_VoidFunFloat fixedLoopCallback);
+
+/// @brief Sets the rate of the fixed loop. Defaults are RJ_FIXED_STEP_DEFAULT_RATE and RJ_FIXED_STEP_DEFAULT_MAX_SUBSTEPS.
+/// @param stepRate Number of fixed steps per second, must be positive.
+/// @param maxSubsteps Maximum number of fixed steps in a single frame, must be positive.
+void RJ_SetFixedStepRate(float stepRate, RJ_Size maxSubsteps);
+
+/// @brief Gets how far the current frame is between the last two fixed steps, to interpolate what they moved.
+/// @return Time accumulated since the last fixed step divided by the fixed step, clamped to [0, 1]. 1 if there is no fixed loop callback.
+float RJ_GetFixedStepAlpha(void);
+
 /// @brief Sets the callback function for the global application terminate function. After setting, terminate function calls the callback function before its own instructions.
 /// @param terminateCallback Function to call when terminate is called. Should not exit the program. Receives exit code and exit message as parameters.
 void RJ_SetTerminateCallback(RJ_VoidFunIntCharPtr terminateCallback);
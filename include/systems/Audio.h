@@ -22,7 +22,7 @@ typedef struct AudioListener
     (AudioListener) { .position = Vector3_Zero, .rotation = Vector3_Zero /*, .range = 10.0f, .sensitivity = 1.0f*/ }
 
 /// @brief Initialize the audio system with the specified component capacity.
-/// @param initialComponentCapacity The initial capacity for audio components.
+/// @param initialComponentCapacity The initial capacity for audio components, it grows when it is reached.
 /// @return RJ_OK / RJ_ERROR_DEPENDENCY / RJ_ERROR_ALLOCATION
 RJ_ResultWarn Audio_Initialize(RJ_Size initialComponentCapacity);
 
@@ -42,17 +42,18 @@ const AudioListener *Audio_GetListenerData(void);
 /// @param listenerData Pointer to the data to assign to internal listener.
 void Audio_SetListenerData(const AudioListener *listenerData);
 
-/// @brief Reconfigure the audio system's position references and component capacity.
-/// @param newComponentCapacity The new capacity for audio components.
-//! RJ_ResultWarn Audio_Resize(RJ_Size newComponentCapacity);
+/// @brief Changes the component capacity of the audio system. Audio_ComponentCreate grows it on its own when it is full.
+/// @param newComponentCapacity The new capacity, can not be below the component count.
+/// @return RJ_OK on success, RJ_ERROR_CAPACITY if the components do not fit or RJ_ERROR_ALLOCATION if internal allocation fails, the previous capacity stays usable then.
+RJ_ResultWarn Audio_Resize(RJ_Size newComponentCapacity);
 
-/// @brief Update the audio system. Should be called every frame.
+/// @brief Update the audio system. Should be called every frame. Sounds are placed at the world positions of their entities, pending transform changes are propagated first and only sounds of entities whose world transform changed are moved.
 void Audio_Update(void);
 
 /// @brief Creates an audio component.
 /// @param entity The entity to associate the component with.
 /// @param audioFile The audio file to be used by the component. Relative to resources folder.
-/// @return RJ_OK / RJ_ERROR_DEPENDENCY
+/// @return RJ_OK / RJ_ERROR_ALLOCATION / RJ_ERROR_DEPENDENCY
 RJ_ResultWarn Audio_ComponentCreate(Entity entity, StringView audioFile);
 // todo maybe add sound files to resource and make reference counted resources
 
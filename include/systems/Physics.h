@@ -8,19 +8,122 @@
 
 #pragma region Typedefs
 
-/// @brief Number of iterations to perform when resolving collisions in a physics scene.
+/// @brief Maximum number of iterations to perform when resolving collisions in a physics scene. Iterations stop early once no contact is penetrating.
 #define PHYSICS_COLLISION_RESOLVE_ITERATIONS 2
 
+/// @brief Algorithms the physics system can use to collect candidate collision pairs.
+typedef enum PhysicsBroadphase
+{
+    PhysicsBroadphase_BruteForce = 0, // Tests the bounds of every pair of components
+    PhysicsBroadphase_SpatialHash,    // Uniform spatial hash grid, cell size is derived from collider sizes
+    PhysicsBroadphase_SweepAndPrune   // Per axis sorted endpoints kept across frames and re-sorted with insertion sort, best for slow moving scenes
+} PhysicsBroadphase;
+
+/// @brief Material of a physics component, stored per component next to the other dense columns.
+typedef struct PhysicsMaterial
+{
+    float drag;         // Fraction of the velocity lost every step (0-1)
+    float gravityScale; // Multiplier of the gravity of the system
+    float restitution;  // Elasticity of collisions (0-1), the larger one of a pair is used
+    float friction;     // Coulomb friction coefficient, the geometric mean of a pair is used
+} PhysicsMaterial;
+
+/// @brief Collision shape of a physics component, fitted into its collider size. The collider size stays the bounding box, which the broadphase, queries and continuous collision use for every shape.
+typedef enum PhysicsShape
+{
+    PhysicsShape_Box = 0, // Axis aligned box of the collider size
+    PhysicsShape_Sphere,  // Sphere with half the smallest axis of the collider size as radius
+    PhysicsShape_Capsule  // Capsule along the y axis, its radius is half the smaller one of the x and z axes
+} PhysicsShape;
+
+/// @brief Layer of a newly created physics component.
+#define PHYSICS_LAYER_DEFAULT (1u << 0)
+/// @brief Mask of a newly created physics component, collides with every layer.
+#define PHYSICS_MASK_ALL UINT32_MAX
+
+/// @brief Overlap of a trigger component with another component, reported instead of being resolved.
+typedef struct PhysicsTriggerOverlap
+{
+    Entity trigger; // If both are triggers, the one that was the first of the pair
+    Entity other;
+} PhysicsTriggerOverlap;
+
+/// @brief Default number of contact events kept for a collision resolve, see Physics_SetContactEventCapacity.
+#define PHYSICS_CONTACT_EVENT_DEFAULT_CAPACITY 4096
+
+/// @brief Types of contact events reported by the collision resolve.
+typedef enum PhysicsContactEventType
+{
+    PhysicsContactEvent_Begin = 0, // The pair started touching in this resolve
+    PhysicsContactEvent_Stay,      // The pair was touching in the previous resolve too
+    PhysicsContactEvent_End        // The pair stopped touching or one of its components was destroyed
+} PhysicsContactEventType;
+
+/// @brief Contact event of a pair of components. Pairs count as touching while they are closer than the contact distance, so resting pairs keep staying.
+typedef struct PhysicsContactEvent
+{
+    Entity first; // Smaller entity of the pair
+    Entity second;
+    Vector3 overlap; // Overlap on every axis when the pair was first found in the resolve, negative axes are gaps. Normal from first to second scaled by the penetration depth if the pair has a sphere or capsule. Zero for end events
+    RJ_Size frame;   // Number of the collision resolve that reported the event, starting from 1
+    PhysicsContactEventType type;
+} PhysicsContactEvent;
+
+/// @brief Phase timings and counters of the last step, see Physics_GetStats. All zero if the physics system is compiled with PHYSICS_ENABLE_STATS set to 0.
+typedef struct PhysicsStats
+{
+    uint64_t integrateNanoseconds;   // Physics_UpdateComponents, warm starting and integrating the awake components
+    uint64_t broadphaseNanoseconds;  // Collecting candidate pairs, including the static and sleeping grid rebuilds
+    uint64_t narrowphaseNanoseconds; // Continuous clamping and testing the candidate pairs in every iteration
+    uint64_t resolveNanoseconds;     // Coloring and resolving the contacts in every iteration, then sleeping and the contact cache
+    RJ_Size pairsConsidered;         // Candidate pairs the broadphase found
+    RJ_Size pairsOverlapping;        // Candidate pairs the narrowphase kept as contacts in the first iteration
+    RJ_Size staticSkips;             // Static and sleeping components the step skipped
+    RJ_Size iterations;              // Resolve iterations run, at most PHYSICS_COLLISION_RESOLVE_ITERATIONS
+} PhysicsStats;
+
+/// @brief Independent physics world with its own components, broadphase, caches and thread pool. Internal structure is hidden.
+typedef struct PhysicsWorld PhysicsWorld;
+
+/// @brief Closest hit of a ray found by Physics_Raycast.
+typedef struct PhysicsRaycastHit
+{
+    Entity entity;
+    float distance; // Distance from the origin along the normalized direction
+    Vector3 point;
+    Vector3 normal; // Normal of the hit collider face, always axis aligned
+} PhysicsRaycastHit;
+
 #pragma endregion Typedefs
 
+/// @brief Creates an empty physics world. Bind it with Physics_SetWorld, then initialize and use it through the Physics_ functions.
+/// @param retWorld Pointer to fill with the created world.
+/// @return RJ_OK / RJ_ERROR_ALLOCATION
+RJ_ResultWarn PhysicsWorld_Create(PhysicsWorld **retWorld);
+
+/// @brief Terminates the world if it is initialized and frees it. If the calling thread had it bound, the default world is bound instead.
+/// @param world World to destroy. Can be NULL.
+/// @note The world must not be bound by any other thread.
+void PhysicsWorld_Destroy(PhysicsWorld *world);
+
+/// @brief Binds a world to the calling thread, every Physics_ function called from the thread works on it. Threads start with the default world bound, which is the only world of programs that never call this.
+/// @param world World to bind, NULL binds the default world.
+/// @return The previously bound world, NULL for the default world.
+/// @note Different worlds can be used from different threads at the same time as long as they do not share entities and entities are not created or destroyed meanwhile. A world must only be used by one thread at a time.
+PhysicsWorld *Physics_SetWorld(PhysicsWorld *world);
+
+/// @brief Gets the world bound to the calling thread.
+/// @return The bound world, NULL for the default world.
+PhysicsWorld *Physics_GetWorld(void);
+
 /// @brief Creates a new physics scene. Try keeping entities that have physics component in sequence for best cpu cache performance.
-/// @param initialComponentCapacity The initial capacity for physics components.
-/// @param drag The drag to be applied to components (0-1).
+/// @param initialComponentCapacity The initial capacity for physics components, it grows when it is reached.
+/// @param broadphase The algorithm to collect candidate collision pairs with.
+/// @param drag The drag of new components (0-1), see PhysicsMaterial.
 /// @param gravity The gravity force to be applied to components.
-/// @param elasticity The elasticity to be applied to components (0-1).
+/// @param elasticity The restitution of new components (0-1), see PhysicsMaterial.
 /// @return RJ_OK / RJ_ERROR_ALLOCATION
-RJ_ResultWarn Physics_Initialize(RJ_Size initialComponentCapacity, float drag, float gravity, float elasticity);
-// todo more properties or move to component data
+RJ_ResultWarn Physics_Initialize(RJ_Size initialComponentCapacity, PhysicsBroadphase broadphase, float drag, float gravity, float elasticity);
 
 /// @brief Terminates the physics system and all its components.
 void Physics_Terminate(void);
@@ -29,30 +132,133 @@ void Physics_Terminate(void);
 /// @return True if the system is initialized previously and not terminated, false otherwise.
 bool Physics_IsInitialized(void);
 
-/// @brief Changes the position references for all physics components in the scene.
-/// @param newCapacity The maximum number of position vectors available.
-/// @return RJ_OK on success, or RJ_ERROR_ALLOCATION if internal allocation fails.
-//! RJ_ResultWarn Physics_Resize(RJ_Size newCapacity);
+/// @brief Sets the number of threads the physics step runs on. Integration, narrowphase and contact resolution are split between them. Single threaded by default.
+/// @param threadCount Number of threads including the calling thread, 1 disables the worker threads. Must be in [1, THREAD_POOL_MAX_THREAD_COUNT].
+/// @return RJ_OK / RJ_ERROR_ALLOCATION, the step stays single threaded on failure.
+/// @note Results are bit identical for every thread count. Contacts are resolved in graph colored batches in every configuration, so no two threads touch the same component.
+RJ_ResultWarn Physics_SetThreadCount(RJ_Size threadCount);
+
+/// @brief Changes the component capacity of the current world. Physics_ComponentCreate grows it on its own when it is full.
+/// @param newCapacity The new capacity, can not be below the component count.
+/// @return RJ_OK on success, RJ_ERROR_CAPACITY if the components do not fit or RJ_ERROR_ALLOCATION if internal allocation fails, the previous capacity stays usable then.
+RJ_ResultWarn Physics_Resize(RJ_Size newCapacity);
 
 /// @brief Checks for collision between two colliders.
 /// @param component1 The first component.
 /// @param component2 The second component.
-/// @param overlapRet If not NULL, will be filled with the overlap vector on each axis.
+/// @param overlapRet If not NULL, will be filled with the overlap vector on each axis, or with the normal from the first to the second scaled by the penetration depth if one of them is a sphere or capsule.
 /// @return True if the components are colliding, false otherwise.
+/// @note Meant for single queries, the collision resolve uses a batched narrowphase instead. Positions are read like the step reads them, attached entities from the world transform cache.
 bool Physics_IsColliding(Entity entity1, Entity entity2, Vector3 *overlapRet);
 
-/// @brief Updates the positions of all non-static components in the scene based on their velocity, gravity, and drag.
+/// @brief Finds the closest collider hit by a ray.
+/// @param origin Origin of the ray. Colliders containing the origin are not hit, so a ray can start from the center of a component.
+/// @param direction Direction of the ray, does not need to be normalized.
+/// @param maxDistance Only hits closer than this are found.
+/// @param layerMask Only components with a layer in the mask are hit.
+/// @param retHit Filled with the closest hit, untouched if nothing is hit.
+/// @return True if a collider is hit, false otherwise.
+/// @note Queries walk the same hash grids the broadphase uses for static, sleeping and awake components. The first query after a step or a component change rebuilds the awake grid once, later queries are read only and can run on multiple threads until the next physics call. Positions are the ones of the last physics call, entities moved directly are seen after the next step.
+bool Physics_Raycast(Vector3 origin, Vector3 direction, float maxDistance, uint32_t layerMask, PhysicsRaycastHit *retHit);
+
+/// @brief Finds every collider overlapping a box.
+/// @param center Center of the box.
+/// @param size Size of the box.
+/// @param layerMask Only components with a layer in the mask are found.
+/// @param retEntities Buffer to fill with the found entities, nothing is allocated.
+/// @param entityCapacity Capacity of the buffer, only this many entities are written.
+/// @return Number of overlapping colliders, can be larger than the capacity if the buffer was too small.
+/// @note See Physics_Raycast for the query structures.
+RJ_Size Physics_QueryAABB(Vector3 center, Vector3 size, uint32_t layerMask, Entity *retEntities, RJ_Size entityCapacity);
+
+/// @brief Finds the collider nearest to a point.
+/// @param point Point to search around. Colliders containing it are at distance 0.
+/// @param maxDistance Only colliders closer than this are found, a smaller distance searches fewer grid cells.
+/// @param layerMask Only components with a layer in the mask are found.
+/// @param ignoredEntity Entity to skip, usually the one searching. RJ_INDEX_INVALID for none.
+/// @param retDistance If not NULL and a collider is found, filled with the distance to its closest point.
+/// @return The nearest entity, RJ_INDEX_INVALID if nothing is closer than the maximum distance.
+/// @note See Physics_Raycast for the query structures.
+Entity Physics_QueryNearest(Vector3 point, float maxDistance, uint32_t layerMask, Entity ignoredEntity, float *retDistance);
+
+/// @brief Sets how many contact events a collision resolve can report. Events are written to a preallocated buffer that is rewound by every resolve, events past the capacity are dropped.
+/// @param capacity Maximum number of events, 0 disables events. Defaults to PHYSICS_CONTACT_EVENT_DEFAULT_CAPACITY.
+/// @return RJ_OK / RJ_ERROR_ALLOCATION, events are disabled on failure.
+RJ_ResultWarn Physics_SetContactEventCapacity(RJ_Size capacity);
+
+/// @brief Gets the contact events of the last Physics_ResolveCollisions call. Begin and stay events are reported the first time the narrowphase finds a pair in the resolve, end events after the resolve.
+/// @param retEvents Pointer to fill with the event array, valid until the next Physics_ResolveCollisions or Physics_SetContactEventCapacity call.
+/// @return Number of events.
+/// @note Pairs of sleeping components neither stay nor end, they stay again once woken if they still touch. Trigger pairs are reported too.
+RJ_Size Physics_GetContactEvents(const PhysicsContactEvent **retEvents);
+
+/// @brief Gets how many events the last collision resolve dropped because the event buffer was full.
+/// @return Number of dropped events.
+RJ_Size Physics_GetDroppedContactEventCount(void);
+
+/// @brief Gets how many candidate pairs, contacts, trigger overlaps and grid components the last collision resolve left out because an internal buffer could not grow.
+/// @return Number of dropped items, 0 unless memory ran out.
+RJ_Size Physics_GetDroppedCollisionCount(void);
+
+/// @brief Gets the pair counts of the last collision resolve.
+/// @param retCandidatePairCount Pointer to fill with the number of candidate pairs the broadphase found. Can be NULL.
+/// @param retContactCount Pointer to fill with the number of overlapping pairs the narrowphase kept in the last iteration. Can be NULL.
+void Physics_GetPairCounts(RJ_Size *retCandidatePairCount, RJ_Size *retContactCount);
+
+/// @brief Gets the phase timings and counters of the last step of the bound world. Physics_UpdateComponents resets the integration timing, Physics_ResolveCollisions resets the rest.
+/// @param retStats Pointer to fill with the stats.
+void Physics_GetStats(PhysicsStats *retStats);
+
+/// @brief Gets the size of a snapshot of the current state. It changes with the component count and the contact cache size, so check it before every save.
+/// @return Size of the snapshot in bytes.
+RJ_Size Physics_SnapshotGetSize(void);
+
+/// @brief Saves the physics state to a caller owned buffer. Velocities, collider sizes, positions, materials, masses, flags, layers, the component maps, the sleep state and the contact cache are copied section by section with memcpy, so restoring and stepping again gives bit identical results.
+/// @param retBuffer Buffer to write the snapshot to.
+/// @param bufferSize Size of the buffer, must be at least Physics_SnapshotGetSize.
+/// @param base Optional base snapshot, NULL for a full snapshot. If given, every byte is XORed with the base byte at the same offset, so bytes that did not change are zero and the delta compresses well.
+/// @param baseSize Size of the base snapshot, ignored if base is NULL.
+/// @return RJ_OK / RJ_ERROR_CAPACITY if the buffer is too small.
+/// @note Call between steps. Entity positions are saved through the position lanes of the components, positions of entities without a physics component and the interpolation state are not saved.
+RJ_ResultWarn Physics_SnapshotSave(void *retBuffer, RJ_Size bufferSize, const void *base, RJ_Size baseSize);
+
+/// @brief Restores the physics state from a snapshot and writes the positions back to the entities.
+/// @param buffer Snapshot to restore.
+/// @param bufferSize Size of the snapshot.
+/// @param base Base snapshot the delta was saved against, NULL for a full snapshot. Must be the same base given to Physics_SnapshotSave.
+/// @param baseSize Size of the base snapshot, ignored if base is NULL.
+/// @return RJ_OK / RJ_ERROR_CAPACITY if the buffer is smaller than a header / RJ_ERROR_INTERNAL if the snapshot does not match the system capacities / RJ_ERROR_ALLOCATION, in which case only the contact cache may be lost.
+/// @note The entities of the saved components must still exist. Contact events and trigger overlaps of the last step are cleared.
+RJ_ResultWarn Physics_SnapshotRestore(const void *buffer, RJ_Size bufferSize, const void *base, RJ_Size baseSize);
+
+/// @brief Marks the static acceleration structure to be rebuilt on the next collision resolve. Static components are indexed only when the static set changes, call this after moving static entities through the Entity module.
+void Physics_InvalidateStatics(void);
+
+/// @brief Checks whether a component is sleeping. Components fall asleep with their island after resting for PHYSICS_SLEEP_STEP_COUNT steps and are not integrated or collided until woken.
+/// @param entity The entity to check.
+/// @return True if the component is sleeping, false otherwise.
+bool Physics_ComponentIsSleeping(Entity entity);
+
+/// @brief Wakes a sleeping component together with its island. Does nothing for awake and static components.
+/// @param entity The entity to wake.
+/// @note Sleeping components are woken automatically when an awake component touches them, when their velocity or collider size is set and when the static set changes. Call this after moving a sleeping entity directly.
+void Physics_ComponentWake(Entity entity);
+
+/// @brief Updates the positions of all awake non-static components in the scene based on their velocity, gravity, and drag. Drag and gravity scale are read from the material of every component.
 /// @param deltaTime The time elapsed since the last frame.
+/// @note Integration runs on structure of arrays lanes with the widest vector kernel the CPU supports (AVX2, SSE or scalar). All kernels give bit identical results. Resting impulses cached by the last resolve are applied first, so supported components do not sink.
 void Physics_UpdateComponents(float deltaTime);
 
 /// @brief Detects and resolves collisions between components in the system.
+/// @note Dynamic pairs are collected once per call with the broadphase selected at initialization, dynamic vs static pairs from a static grid. Static pairs are never enumerated. Sleeping islands are skipped until touched. Pairs are then resolved PHYSICS_COLLISION_RESOLVE_ITERATIONS times, every iteration tests all pairs with a batched SIMD narrowphase first and resolves the packed contacts in graph colored batches. Contacts are cached by entity pair between steps, keeping their separation axis and resting impulse for warm starting.
 void Physics_ResolveCollisions(void);
 
 /// @brief Creates a new physics component.
 /// @param entity The entity associated with the physics component.
 /// @param colliderSize The size of the AABB collider.
 /// @param mass The mass of the object.
-/// @param isStatic Whether the object is static.
+/// @param isStatic Whether the object is static. Static components are never integrated and are indexed once in a read only structure.
+/// @note Components of root entities move their entity. Components of attached entities are placed at the world position cached by Entity_UpdateTransforms and follow their parent instead of being moved by the simulation.
 void Physics_ComponentCreate(Entity entity, Vector3 colliderSize, float mass, bool isStatic);
 
 /// @brief Destroys a physics component.
@@ -94,12 +300,76 @@ float Physics_ComponentGetMass(Entity entity);
 /// @param newMass The new mass to set.
 void Physics_ComponentSetMass(Entity entity, float newMass);
 
+/// @brief Gets the material of a physics component. New components use the drag and elasticity given to Physics_Initialize, a gravity scale of 1 and no friction.
+/// @param entity The component to query.
+/// @return The material of the component.
+PhysicsMaterial Physics_ComponentGetMaterial(Entity entity);
+
+/// @brief Sets the material of a physics component.
+/// @param entity The component to update.
+/// @param newMaterial The new material to set.
+void Physics_ComponentSetMaterial(Entity entity, PhysicsMaterial newMaterial);
+
 /// @brief Checks if a physics component is static.
 /// @param entity The component to query.
 /// @return True if the component is static, false otherwise.
 bool Physics_ComponentIsStatic(Entity entity);
 
-/// @brief Sets whether a physics component is static.
+/// @brief Sets whether a physics component is static. Velocity of the component is reset when the state changes.
 /// @param entity The component to update.
 /// @param newIsStatic The new static state to set.
-void Physics_ComponentSetStatic(Entity component, bool newIsStatic);
+void Physics_ComponentSetStatic(Entity entity, bool newIsStatic);
+
+/// @brief Gets the layer bits of a physics component.
+/// @param entity The component to query.
+/// @return The layer of the component.
+uint32_t Physics_ComponentGetLayer(Entity entity);
+
+/// @brief Gets the mask of a physics component, the layers it collides with.
+/// @param entity The component to query.
+/// @return The mask of the component.
+uint32_t Physics_ComponentGetMask(Entity entity);
+
+/// @brief Sets the layer and mask of a physics component. Two components are only paired if the layer of each one is in the mask of the other one, filtered pairs are dropped in the broadphase before their bounds are tested.
+/// @param entity The component to update.
+/// @param newLayer The new layer bits.
+/// @param newMask The new mask, the layers to collide with.
+void Physics_ComponentSetLayer(Entity entity, uint32_t newLayer, uint32_t newMask);
+
+/// @brief Checks if a physics component is a trigger.
+/// @param entity The component to query.
+/// @return True if the component is a trigger, false otherwise.
+bool Physics_ComponentIsTrigger(Entity entity);
+
+/// @brief Sets whether a physics component is a trigger. Overlaps of triggers are reported by Physics_GetTriggerOverlaps and never resolved, triggers do not push, support or wake anything.
+/// @param entity The component to update.
+/// @param newIsTrigger The new trigger state to set.
+void Physics_ComponentSetTrigger(Entity entity, bool newIsTrigger);
+
+/// @brief Gets the collision shape of a physics component. New components are boxes.
+/// @param entity The component to query.
+/// @return The shape of the component.
+PhysicsShape Physics_ComponentGetShape(Entity entity);
+
+/// @brief Sets the collision shape of a physics component, fitted into its collider size.
+/// @param entity The component to update.
+/// @param newShape The new shape to set.
+/// @note Pairs are grouped by shape pair before the narrowphase so every specialized kernel runs over a continuous range. Contacts with a sphere or capsule are resolved along their normal and are not warm started.
+void Physics_ComponentSetShape(Entity entity, PhysicsShape newShape);
+
+/// @brief Gets the trigger overlaps found by the last Physics_ResolveCollisions call.
+/// @param retOverlaps Pointer to fill with the overlap array, valid until the next Physics_ResolveCollisions call.
+/// @return Number of overlaps.
+/// @note Sleeping components are not tested, so a trigger does not report components sleeping inside it.
+RJ_Size Physics_GetTriggerOverlaps(const PhysicsTriggerOverlap **retOverlaps);
+
+/// @brief Checks if a physics component uses continuous collision.
+/// @param entity The component to query.
+/// @return True if the component is swept, false otherwise.
+bool Physics_ComponentIsContinuous(Entity entity);
+
+/// @brief Sets whether a physics component uses continuous collision. The whole motion of a continuous component is swept against the broadphase and it is stopped at the first impact, so fast components can not tunnel through thin ones.
+/// @param entity The component to update.
+/// @param newIsContinuous The new continuous state to set.
+/// @note Meant for a few fast components like projectiles, every continuous component is tested against all of its swept pairs each step. The motion is recovered from the velocity, so set velocities before Physics_UpdateComponents.
+void Physics_ComponentSetContinuous(Entity entity, bool newIsContinuous);
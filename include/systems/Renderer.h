@@ -56,7 +56,7 @@ typedef struct RendererCamera
 #pragma region Renderer
 
 /// @brief Initializes the renderer system.
-/// @param initialBatchCapacity The initial capacity for renderer batches.
+/// @param initialBatchCapacity The initial capacity for renderer batches, it grows when it is reached.
 /// @return RJ_OK / RJ_ERROR_DEPENDENCY / RJ_ERROR_ALLOCATION
 RJ_ResultWarn Renderer_Initialize(RJ_Size initialBatchCapacity);
 
@@ -87,12 +87,13 @@ void Renderer_SetCameraData(const RendererCamera *cameraData);
 /// @return World space position of the converted coordinate.
 Vector3 Renderer_ScreenToWorldSpace(Vector2Int screenPosition, float depth);
 
-/// @brief Resizes the renderer's batch capacity.
-/// @param newBatchCapacity The new capacity for renderer batches.
-/// @return RJ_OK on success, RJ_ERROR_ALLOCATION if internal allocation fails.
-//! RJ_ResultWarn Renderer_Resize(RJ_Size newBatchCapacity);
+/// @brief Resizes the renderer's batch capacity. Renderer_BatchCreate grows it on its own when it is full.
+/// @param newBatchCapacity The new capacity for renderer batches, can not be below the batch count.
+/// @return RJ_OK on success, RJ_ERROR_CAPACITY if the batches do not fit or RJ_ERROR_ALLOCATION if internal allocation fails.
+RJ_ResultWarn Renderer_Resize(RJ_Size newBatchCapacity);
 
 /// @brief Updates the renderer system. Call before using any renderer function in during the frame.
+/// @note Pending entity transform changes are propagated first and the world matrices are read from the entity transform cache. World positions are interpolated between the last two fixed steps with RJ_GetFixedStepAlpha, so rendering stays smooth when the fixed loop runs slower than the frame rate. Only object matrices of entities whose world transform changed, or that are still interpolating, are rewritten.
 void Renderer_Update(void);
 
 /// @brief Renders the current frame.
@@ -101,7 +102,7 @@ void Renderer_Render(void);
 /// @brief Creates a renderer batch.
 /// @param modelFile The file path to the .glb or .gltf model file.
 /// @param retBatch The handle to the created renderer batch.
-/// @param initialComponentCapacity The initial capacity for components in the batch.
+/// @param initialComponentCapacity The initial capacity for components in the batch, it grows when it is reached.
 /// @return RJ_OK / RJ_ERROR_ALLOCATION / RJ_ERROR_FILE
 RJ_ResultWarn Renderer_BatchCreate(RendererBatch *retBatch, StringView modelFile, RJ_Size initialComponentCapacity);
 
@@ -114,18 +115,16 @@ void Renderer_BatchDestroy(RendererBatch batch);
 /// @return
 bool Renderer_BatchValidate(RendererBatch batch);
 
-// todo maybe remove resizing
-
-/// @brief Configures the references for a renderer batch.
+/// @brief Resizes the component capacity of a renderer batch. Renderer_ComponentCreate grows it on its own when it is full.
 /// @param batch The handle to the renderer batch.
-/// @param newComponentCapacity The new capacity for components in the batch.
-/// @return RJ_OK on success, RJ_ERROR_ALLOCATION if internal allocation fails.
-//! RJ_ResultWarn Renderer_BatchResize(RendererBatch batch, RJ_Size newComponentCapacity);
+/// @param newComponentCapacity The new capacity for components in the batch, can not be below the component count.
+/// @return RJ_OK on success, RJ_ERROR_CAPACITY if the components do not fit or RJ_ERROR_ALLOCATION if internal allocation fails, the previous capacity stays usable then.
+RJ_ResultWarn Renderer_BatchResize(RendererBatch batch, RJ_Size newComponentCapacity);
 
 /// @brief Creates a renderer component within a specified batch.
 /// @param batch Batch to create component on.
 /// @param entity The entity associated with the renderer component.
-/// @return RJ_OK / RJ_ERROR_CAPACITY
+/// @return RJ_OK / RJ_ERROR_ALLOCATION
 RJ_ResultWarn Renderer_ComponentCreate(RendererBatch batch, Entity entity);
 
 /// @brief Destroys a renderer component.
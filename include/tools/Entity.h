@@ -9,13 +9,71 @@
 /// @brief Capacity of free indices array of the entity array and other component systems.
 #define ENTITY_INITIAL_FREE_INDEX_ARRAY_SIZE 4
 
+/// @brief Maximum number of entity change listeners that can exist at the same time.
+#define ENTITY_MAX_CHANGE_LISTENER_COUNT 8
+
+/// @brief Maximum number of entity remap callbacks that can be registered at the same time.
+#define ENTITY_MAX_REMAP_CALLBACK_COUNT 16
+
 /// @brief Entity type used for all of the component systems.
 typedef RJ_Size Entity;
 
+/// @brief Called by Entity_Compact after entities moved, systems patch every entity they store with it.
+/// @param userData Pointer given at registration.
+/// @param remap New entity of every old entity, RJ_INDEX_INVALID for destroyed ones. Relative order is kept, so old entities a < b always map to new entities a < b.
+/// @param slotCount Number of old entities in remap.
+typedef void (*EntityRemapCallback)(void *userData, const Entity *remap, RJ_Size slotCount);
+
+/// @brief Handle of a list of entities whose world transform changed, one per consuming system.
+typedef uint8_t EntityChangeListener;
+
+/// @brief Entities are stored in chunks of this many entities. Chunks are added as entities are created and never move, so pointers into them stay valid until Entity_Compact releases them.
+#define ENTITY_CHUNK_SHIFT 14
+#define ENTITY_CHUNK_SIZE (1u << ENTITY_CHUNK_SHIFT)
+#define ENTITY_CHUNK_MASK (ENTITY_CHUNK_SIZE - 1)
+/// @brief Maximum number of chunks, the entity count can not grow above ENTITY_MAX_CHUNK_COUNT * ENTITY_CHUNK_SIZE.
+#define ENTITY_MAX_CHUNK_COUNT 256
+
+/// @brief Chunk an entity is stored in.
+#define Entity_Chunk(entity) ((entity) >> ENTITY_CHUNK_SHIFT)
+/// @brief Index of an entity in the arrays of its chunk.
+#define Entity_ChunkIndex(entity) ((entity) & ENTITY_CHUNK_MASK)
+
+/// @brief Raw transform arrays of the entities of one chunk, indexed by Entity_ChunkIndex. For hot loops that would otherwise call the per entity getters and setters.
+typedef struct EntitySpan
+{
+    Vector3 *positions;               // Local transforms, relative to the parent. Set isDirty of an entity after writing any of them
+    Vector3 *rotations;
+    Vector3 *scales;
+    bool *isDirty;
+    const Entity *parents;            // RJ_INDEX_INVALID for root entities, whose local transform is their world transform
+    const Vector3 *worldPositions;    // World transform cache, see Entity_UpdateTransforms
+    const Matrix4 *worldMatrices;     // Translation * rotation x * rotation y * rotation z * scale, multiplied by the world matrix of the parent
+    const Vector3 *previousPositions; // World positions at the start of the last fixed step, see Entity_StorePreviousPositions
+} EntitySpan;
+
+/// @brief Reads a field of an entity from the spans of Entity_GetSpans.
+#define EntitySpan_At(spans, field, entity) ((spans)[Entity_Chunk(entity)].field[Entity_ChunkIndex(entity)])
+
+/// @brief Sparse map from entities to values of a component system, grown chunk by chunk like the entities so memory follows the highest entity that has a value.
+/// @note Chunks are always a prefix, an entity below chunkCount * ENTITY_CHUNK_SIZE can be read and written with EntityMap_At.
+typedef struct EntityMap
+{
+    RJ_Size sizeOfItem;
+    uint8_t fillByte; // every byte of entities without a value
+    RJ_Size chunkCount;
+    void *chunks[ENTITY_MAX_CHUNK_COUNT];
+} EntityMap;
+
+/// @brief Checks if the chunk of an entity is allocated in a map.
+#define EntityMap_Has(map, entity) (Entity_Chunk(entity) < (map).chunkCount)
+/// @brief Value of an entity in a map, the entity must be in an allocated chunk.
+#define EntityMap_At(map, type, entity) (((type *)(map).chunks[Entity_Chunk(entity)])[Entity_ChunkIndex(entity)])
+
 #pragma endregion Typedefs
 
 /// @brief Initialize the entity data with the specified capacity.
-/// @param initialEntityCapacity The initial capacity for entities.
+/// @param initialEntityCapacity The initial capacity for entities, rounded up to whole chunks. More chunks are added when it is reached.
 /// @return RJ_OK on success or RJ_ERROR_ALLOCATION if internal allocation fails.
 RJ_ResultWarn Entity_Initialize(RJ_Size initialEntityCapacity);
 
@@ -31,19 +89,134 @@ bool Entity_IsInitialized(void);
 /// @return
 Entity Entity_Create(Vector3 position, Vector3 rotation, Vector3 scale);
 
+/// @brief Creates many root entities at once. A contiguous range after the last used slot is reserved when the allocated chunks allow so the transform arrays are written in bulk, otherwise the most recently freed slots are filled first and chunks are added only for the rest.
+/// @param retEntities Created entities, must hold count entities.
+/// @param count Number of entities to create.
+/// @param positions Local positions of the entities, NULL for zero.
+/// @param rotations Local rotations of the entities, NULL for zero.
+/// @param scales Local scales of the entities, NULL for one.
+/// @return RJ_OK on success, RJ_ERROR_CAPACITY if the entities do not fit in ENTITY_MAX_CHUNK_COUNT chunks or RJ_ERROR_ALLOCATION if a chunk can not be allocated, nothing is created then.
+RJ_ResultWarn Entity_CreateBatch(Entity *retEntities, RJ_Size count, const Vector3 *positions, const Vector3 *rotations, const Vector3 *scales);
+
 /// @brief
 /// @param entity
+/// @note Children of the entity are detached and keep their world position, their local rotation and scale are used as world ones from then on.
 void Entity_Destroy(Entity entity);
 
+/// @brief Destroys many entities at once, like calling Entity_Destroy for each of them.
+/// @param entities Entities to destroy, every one must be alive and listed once.
+/// @param count Number of entities.
+/// @note Freed slots are reused in the given order by the next Entity_CreateBatch that does not fit after the last used slot.
+void Entity_DestroyBatch(const Entity *entities, RJ_Size count);
+
+/// @brief Attaches an entity to a parent, its transform then becomes local to the world transform of the parent.
+/// @param entity Entity to attach.
+/// @param parent New parent, RJ_INDEX_INVALID detaches the entity. Must not be the entity itself or one of its descendants.
+/// @note The local transform is kept as it is, so the entity moves with the change of its reference.
+void Entity_SetParent(Entity entity, Entity parent);
+
+/// @brief Gets the parent of an entity.
+/// @param entity Entity to get.
+/// @return The parent, RJ_INDEX_INVALID for root entities.
+Entity Entity_GetParent(Entity entity);
+
+/// @brief Recomputes the world transforms of the entities changed since the last call, together with their descendants. Entities are visited in depth order so parents are always ready before their children, clean subtrees are skipped.
+/// @note Cheap while nothing changed. Called by Entity_StorePreviousPositions, Renderer_Update and Audio_Update, call it before stepping physics if attached entities moved since the last fixed step.
+void Entity_UpdateTransforms(void);
+
+/// @brief Creates a change listener. Every entity whose world transform is computed from then on, by Entity_Create or Entity_UpdateTransforms, is added once to its list until the list is cleared.
+/// @param retListener Created listener.
+/// @return RJ_OK on success, RJ_ERROR_CAPACITY if ENTITY_MAX_CHANGE_LISTENER_COUNT listeners exist or RJ_ERROR_ALLOCATION if internal allocation fails.
+RJ_ResultWarn Entity_ChangeListenerCreate(EntityChangeListener *retListener);
+
+/// @brief Destroys a change listener. Destroying a listener that does not exist, also after Entity_Terminate, does nothing.
+/// @param listener Listener to destroy.
+void Entity_ChangeListenerDestroy(EntityChangeListener listener);
+
+/// @brief Gets the entities whose world transform changed since the listener was created or last cleared.
+/// @param listener Listener to get.
+/// @param retCount Number of entities in the list.
+/// @return The list, valid until the listener is cleared or destroyed or an entity chunk is added.
+/// @note Destroyed entities are not removed from the list, consumers skip entities they have no component of.
+const Entity *Entity_GetChangedEntities(EntityChangeListener listener, RJ_Size *retCount);
+
+/// @brief Empties the change list of a listener, call after consuming it.
+/// @param listener Listener to clear.
+void Entity_ClearChangedEntities(EntityChangeListener listener);
+
+/// @brief Registers a callback Entity_Compact calls after moving entities.
+/// @param callback Callback to call.
+/// @param userData Pointer passed to the callback, also identifies the registration together with the callback.
+/// @return RJ_OK on success or RJ_ERROR_CAPACITY if ENTITY_MAX_REMAP_CALLBACK_COUNT callbacks are registered.
+RJ_ResultWarn Entity_RemapCallbackAdd(EntityRemapCallback callback, void *userData);
+
+/// @brief Unregisters a remap callback. Removing a callback that is not registered, also after Entity_Terminate, does nothing.
+/// @param callback Callback given at registration.
+/// @param userData Pointer given at registration.
+void Entity_RemapCallbackRemove(EntityRemapCallback callback, void *userData);
+
+/// @brief Moves the live entities into a dense prefix, keeping their relative order, and clears the free slots. Every registered remap callback is then called so the systems patch their maps.
+/// @return RJ_OK on success or RJ_ERROR_ALLOCATION if the remap table can not be allocated, nothing is moved then.
+/// @note Opt in and not cheap, call it between frames after heavy churn. Chunks left without live entities are released, except the first one. Entity handles held outside of the registered systems are invalidated, as are physics snapshots saved before it. Components must be destroyed together with their entities.
+RJ_ResultWarn Entity_Compact(void);
+
+/// @brief Gets the world position of an entity from the world transform cache.
+/// @param entity Entity to get.
+/// @return The world position as of the last Entity_UpdateTransforms.
+Vector3 Entity_GetWorldPosition(Entity entity);
+
+/// @brief Gets the world matrix of an entity from the world transform cache.
+/// @param entity Entity to get.
+/// @return The world matrix as of the last Entity_UpdateTransforms.
+Matrix4 Entity_GetWorldMatrix(Entity entity);
+
 // todo add callbacks
 
 void Entity_GetInternalData(RJ_Size *retCapacity, RJ_Size *retCount);
 
+/// @brief Gets the transform arrays of every chunk for bulk reading and writing, index them with EntitySpan_At. Entities are not checked, callers must only index entities they know are alive.
+/// @param retSlotCount Every entity is below it. Slots of destroyed entities are included and can be written but are never read. Can be NULL.
+/// @return Span of every chunk, indexed by Entity_Chunk.
+/// @note The table and the arrays stay valid while entities are created, Entity_Compact may release the chunks above the live entities.
+const EntitySpan *Entity_GetSpans(RJ_Size *retSlotCount);
+
+/// @brief Creates an empty map.
+/// @param retMap Map to create.
+/// @param sizeOfItem Size of a value.
+/// @param fillByte Every byte of the values of entities that were never set.
+void EntityMap_Create(EntityMap *retMap, RJ_Size sizeOfItem, uint8_t fillByte);
+
+/// @brief Frees every chunk of a map.
+/// @param map Map to destroy.
+void EntityMap_Destroy(EntityMap *map);
+
+/// @brief Allocates the chunks up to the chunk of an entity, filled with the fill byte.
+/// @param map Map to grow.
+/// @param entity Entity that must be stored.
+/// @return RJ_OK on success or RJ_ERROR_ALLOCATION if internal allocation fails, the chunks allocated before the failure are kept.
+RJ_ResultWarn EntityMap_Reserve(EntityMap *map, Entity entity);
+
+/// @brief Moves the values of a map like Entity_Compact moved the entities and releases the chunks above the live entities. Meant for remap callbacks.
+/// @param map Map to remap.
+/// @param remap Remap table of the callback.
+/// @param slotCount Slot count of the callback.
+void EntityMap_Remap(EntityMap *map, const Entity *remap, RJ_Size slotCount);
+
 /// @brief
 /// @param entity
 /// @return
 Vector3 Entity_GetPosition(Entity entity);
 
+/// @brief Gets the world position of an entity between its world position at the start of the last fixed step and its cached one.
+/// @param entity Entity to get.
+/// @param alpha Interpolation factor, usually RJ_GetFixedStepAlpha. 0 is the previous position, 1 is the current one.
+/// @return The interpolated world position.
+/// @note Entity_SetPosition does not change the previous position, so a teleported entity slides there for one fixed step.
+Vector3 Entity_GetInterpolatedPosition(Entity entity, float alpha);
+
+/// @brief Updates the world transforms and stores the world position of every entity as its previous position. Call at the start of every fixed step, before anything moves the entities.
+void Entity_StorePreviousPositions(void);
+
 /// @brief
 /// @param entity
 /// @return
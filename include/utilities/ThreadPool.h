@@ -0,0 +1,43 @@
+#pragma once
+
+#include "RJGlobal.h"
+
+#define THREAD_POOL_MAX_THREAD_COUNT 64
+
+#pragma region typedefs
+
+/// @brief Range task run by the thread pool.
+/// @param userData User data passed to ThreadPool_ParallelFor.
+/// @param taskIndex Index of the task in [0, ThreadPool_GetThreadCount). The same range is always given to the same task index.
+/// @param first First item of the range.
+/// @param count Number of items in the range, can be 0.
+typedef void (*ThreadPoolTask)(void *userData, RJ_Size taskIndex, RJ_Size first, RJ_Size count);
+
+/// @brief Fixed size pool of worker threads that runs range tasks. Internal structure is hidden.
+typedef struct ThreadPool ThreadPool;
+
+#pragma endregion typedefs
+
+/// @brief Creates a thread pool and starts its workers.
+/// @param retPool Pointer to fill with the created pool.
+/// @param threadCount Number of threads running the tasks including the calling thread, so threadCount - 1 workers are started. Must be in [1, THREAD_POOL_MAX_THREAD_COUNT].
+/// @return RJ_OK on success, RJ_ERROR_ALLOCATION if memory or a thread could not be created.
+RJ_Result ThreadPool_Create(ThreadPool **retPool, RJ_Size threadCount);
+
+/// @brief Stops and joins the workers and frees the pool.
+/// @param pool Pool to destroy. Can be NULL.
+void ThreadPool_Destroy(ThreadPool *pool);
+
+/// @brief Gets the number of threads running the tasks including the calling thread.
+/// @param pool Pool to query. NULL means no pool, which runs everything on the calling thread.
+/// @return Thread count of the pool, 1 if pool is NULL.
+RJ_Size ThreadPool_GetThreadCount(const ThreadPool *pool);
+
+/// @brief Splits [0, itemCount) to one continuous range per thread and runs the task on all of them, the calling thread runs task 0. Returns after every range is done.
+/// @param pool Pool to run on. NULL runs the whole range as task 0 on the calling thread.
+/// @param itemCount Number of items to split.
+/// @param granularity Ranges are multiples of this many items except the last one. If itemCount is not larger than it, every task is run on the calling thread and task 0 gets the whole range.
+/// @param task Task to run for every range.
+/// @param userData User data passed to the task.
+/// @note Splitting only depends on itemCount, granularity and thread count, so a task can rely on its task index and range for deterministic output. Every task index is called, possibly with an empty range. Not reentrant, tasks must not call it.
+void ThreadPool_ParallelFor(ThreadPool *pool, RJ_Size itemCount, RJ_Size granularity, ThreadPoolTask task, void *userData);
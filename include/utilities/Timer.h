@@ -28,6 +28,10 @@ typedef struct Timer
 /// @param timePoint Time Point to update with the current time.
 void TimePoint_Update(TimePoint *timePoint);
 
+/// @brief Gets a monotonic time that is not affected by system clock changes, for measuring short intervals cheaply.
+/// @return Nanoseconds since an unspecified starting point.
+uint64_t TimePoint_GetMonotonicNanoseconds(void);
+
 /// @brief Converts a TimePoint to milliseconds.
 /// @param timePoint Pointer to the TimePoint to convert.
 float TimePoint_ToMilliseconds(const TimePoint *timePoint);
@@ -26,12 +26,13 @@ int main(int argc, char **argv)
 {
     if (argc < 3)
     {
-        SHU_LogError(1, "Usage is <compiler> <r/d/dsa/dst/dsu/dsm> [dynamic] [clean]");
+        SHU_LogError(1, "Usage is <compiler> <r/d/dsa/dst/dsu/dsm> [dynamic] [clean] [benchmark]");
     }
 
     char isDebug = 0;
     char isClean = 0;
     char isDynamic = 0;
+    char isBenchmark = 0;
 
     const char *const compilerStr = argv[1];
     const char *const buildOptStr = argv[2];
@@ -84,9 +85,13 @@ int main(int argc, char **argv)
         {
             isDynamic = 1;
         }
+        else if (isBenchmark == 0 && strcmp(optionalArg, "benchmark") == 0)
+        {
+            isBenchmark = 1;
+        }
         else
         {
-            SHU_LogError(1, "Unknown argument '%s', try [dynamic] [clean].", optionalArg);
+            SHU_LogError(1, "Unknown argument '%s', try [dynamic] [clean] [benchmark].", optionalArg);
         }
     }
 
@@ -197,5 +202,27 @@ int main(int argc, char **argv)
 
     SHU_ModuleCompile(strBuffer, isDynamic ? SHUM_MODULE_LIBRARY_DYNAMIC : SHUM_MODULE_LIBRARY_STATIC);
 
+    if (isBenchmark)
+    {
+        // headless, only the modules the physics step needs are compiled so no window or GL library is linked
+#if SHUM_HOST_PLATFORM != SHUM_PLATFORM_WINDOWS
+        SHU_CompilerAddFlags("-pthread -lm");
+#endif
+
+        ShowBuildConfig(SHUM_COLOR_BLUE("Romeo Benchmarks"), compilerStr, isDebug);
+
+        SHU_ModuleBegin("PhysicsBenchmark", NULL);
+
+        SHU_ModuleAddIncludeDirectory("include/");
+
+        SHU_ModuleAddSourceFile("benchmarks/PhysicsBenchmark.c");
+        SHU_ModuleAddSourceFile("src/RJGlobal.c");
+        SHU_ModuleAddSourceFile("src/utilities/");
+        SHU_ModuleAddSourceFile("src/tools/Entity.c");
+        SHU_ModuleAddSourceFile("src/systems/Physics.c");
+
+        SHU_ModuleCompile(strBuffer, SHUM_MODULE_EXECUTABLE);
+    }
+
     return 0;
 }
@@ -1,7 +1,10 @@
 #include "RJGlobal.h"
 
+#include "utilities/Timer.h"
+
 #if RJ_PLATFORM == RJ_PLATFORM_WINDOWS
 #include <windows.h>
+#include <malloc.h>
 #define RJ_GetExePath(buffer, bufferSize) GetModuleFileName(NULL, buffer, bufferSize)
 
 #elif RJ_PLATFORM == RJ_PLATFORM_UNIX
@@ -14,7 +17,7 @@
 
 #endif
 
-// #pragma message("Build info: " RJ_PLATFORM " | " RJ_COMPILER_NAME " | " RJ_ARCHITECTURE)
+// #pragma message("Build info: " RJ_PLATFORM_STRING " | " RJ_COMPILER_NAME " | " RJ_ARCHITECTURE_STRING)
 
 #pragma region Source Only
 
@@ -24,8 +27,13 @@ char RJ_GLOBAL_EXECUTABLE_DIRECTORY_PATH[RJ_TEMP_BUFFER_SIZE * 2] = {0};
 
 RJ_VoidFunIntCharPtrPtr RJ_SETUP_CALLBACK = NULL;
 RJ_VoidFunFloat RJ_LOOP_CALLBACK = NULL;
+RJ_VoidFunFloat RJ_FIXED_LOOP_CALLBACK = NULL;
 RJ_VoidFunIntCharPtr RJ_TERMINATE_CALLBACK = NULL;
 
+float RJ_FIXED_STEP = 1.0f / RJ_FIXED_STEP_DEFAULT_RATE;
+RJ_Size RJ_FIXED_MAX_SUBSTEPS = RJ_FIXED_STEP_DEFAULT_MAX_SUBSTEPS;
+float RJ_FIXED_STEP_ALPHA = 1.0f;
+
 #pragma endregion Source Only
 
 RJ_Result RJ_Log(RJ_Result terminate, const char *header, const char *file, int line, const char *function, const char *format, ...)
@@ -83,6 +91,33 @@ RJ_Result RJ_Log(RJ_Result terminate, const char *header, const char *file, int
     return RJ_OK;
 }
 
+void *RJ_AllocateAlignedMemory(size_t size, size_t alignment)
+{
+    size = (size + alignment - 1) & ~(alignment - 1);
+
+#if RJ_PLATFORM == RJ_PLATFORM_WINDOWS
+    void *memory = _aligned_malloc(size, alignment);
+#else
+    void *memory = aligned_alloc(alignment, size);
+#endif
+
+    if (memory != NULL)
+    {
+        memset(memory, 0, size);
+    }
+
+    return memory;
+}
+
+void RJ_FreeAligned(void *pointer)
+{
+#if RJ_PLATFORM == RJ_PLATFORM_WINDOWS
+    _aligned_free(pointer);
+#else
+    free(pointer);
+#endif
+}
+
 const char *RJ_GetExecutablePath(void)
 {
     if (RJ_GLOBAL_EXECUTABLE_DIRECTORY_PATH[0] == '\0')
@@ -112,29 +147,49 @@ void RJ_Run(int argc, char **argv)
         RJ_SETUP_CALLBACK(argc, argv);
     }
 
-    struct timespec currentTime = {0, 0};
-    struct timespec lastTime = {0, 0};
-    struct timespec elapsedTime = {0, 0};
+    // wall clock time can step back or jump when it is adjusted, the loop runs on the monotonic clock
+    uint64_t currentTime = 0;
+    uint64_t lastTime = TimePoint_GetMonotonicNanoseconds();
     float DT = 0.0f;
-
-    timespec_get(&lastTime, TIME_UTC);
+    float fixedAccumulator = 0.0f;
 
     while (RJ_LOOP_CALLBACK != NULL)
     {
-        timespec_get(&currentTime, TIME_UTC);
+        currentTime = TimePoint_GetMonotonicNanoseconds();
 
-        elapsedTime.tv_sec = currentTime.tv_sec - lastTime.tv_sec;
-        elapsedTime.tv_nsec = currentTime.tv_nsec - lastTime.tv_nsec;
+        // never negative, so the accumulator never runs backwards
+        DT = currentTime > lastTime ? (float)(currentTime - lastTime) / 1000000000.0f : 0.0f;
 
-        if (elapsedTime.tv_nsec < 0)
+        if (RJ_FIXED_LOOP_CALLBACK != NULL)
         {
-            elapsedTime.tv_sec -= 1;
-            elapsedTime.tv_nsec += 1000000000;
+            fixedAccumulator += DT;
+
+            for (RJ_Size substep = 0; substep < RJ_FIXED_MAX_SUBSTEPS && fixedAccumulator >= RJ_FIXED_STEP; substep++)
+            {
+                RJ_FIXED_LOOP_CALLBACK(RJ_FIXED_STEP);
+                fixedAccumulator -= RJ_FIXED_STEP;
+            }
+
+            if (fixedAccumulator >= RJ_FIXED_STEP)
+            {
+                // drop the whole steps that did not fit, keep the fraction so interpolation stays continuous
+                fixedAccumulator -= RJ_FIXED_STEP * (float)(RJ_Size)(fixedAccumulator / RJ_FIXED_STEP);
+            }
+
+            // float rounding of the step dropping can leave the fraction just outside [0, 1]
+            float alpha = fixedAccumulator / RJ_FIXED_STEP;
+            RJ_FIXED_STEP_ALPHA = alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+        }
+        else
+        {
+            fixedAccumulator = 0.0f;
+            RJ_FIXED_STEP_ALPHA = 1.0f;
         }
 
-        DT = (float)elapsedTime.tv_sec + (float)elapsedTime.tv_nsec / 1000000000.0f;
-
-        RJ_LOOP_CALLBACK(DT);
+        if (RJ_LOOP_CALLBACK != NULL)
+        {
+            RJ_LOOP_CALLBACK(DT);
+        }
 
         lastTime = currentTime;
     }
@@ -174,6 +229,24 @@ void RJ_SetLoopCallback(RJ_VoidFunFloat loopCallback)
     RJ_LOOP_CALLBACK = loopCallback;
 }
 
+void RJ_SetFixedLoopCallback(RJ_VoidFunFloat fixedLoopCallback)
+{
+    RJ_FIXED_LOOP_CALLBACK = fixedLoopCallback;
+}
+
+void RJ_SetFixedStepRate(float stepRate, RJ_Size maxSubsteps)
+{
+    RJ_DebugAssert(stepRate > 0.0f && maxSubsteps > 0, "Fixed step rate %f and maximum substep count %u must be positive.", (double)stepRate, maxSubsteps);
+
+    RJ_FIXED_STEP = 1.0f / stepRate;
+    RJ_FIXED_MAX_SUBSTEPS = maxSubsteps;
+}
+
+float RJ_GetFixedStepAlpha(void)
+{
+    return RJ_FIXED_STEP_ALPHA;
+}
+
 void RJ_SetTerminateCallback(RJ_VoidFunIntCharPtr terminateCallback)
 {
     RJ_TERMINATE_CALLBACK = terminateCallback;
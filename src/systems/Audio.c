@@ -8,37 +8,61 @@
 
 #include "miniaudio/miniaudio.h"
 
+/// @brief Growth factor of the component capacity when a component is created on a full system.
+#define AUDIO_RESIZE_MULTIPLIER 2
+
 #pragma region Source Only
 
 struct AUDIO
 {
     ma_engine engine;
     AudioListener listener;
+    EntityChangeListener changes; // entities whose sound position must be pushed to miniaudio
 
     struct AUDIO_DATA
     {
         RJ_Size capacity;
         RJ_Size count;
 
-        Entity *entityToCompMap; // sparse, accessing the component from entity, to access internal component data etc.
+        EntityMap entityToCompMap; // Entity, sparse, accessing the component from entity, to access internal component data etc.
         Entity *compToEntityMap; // dense, accessing entity from component, access entity data like positions etc.
 
-        ma_sound *sounds; // dense, indexed by component, the actual miniaudio sound objects
+        ma_sound **sounds; // dense, indexed by component, the actual miniaudio sound objects. Allocated one by one since miniaudio keeps their addresses, so the table can grow
     } data;
 } AUDIO = {0};
 
-#define aComponent(entity) (AUDIO.data.entityToCompMap[entity])
+#define aComponent(entity) (EntityMap_At(AUDIO.data.entityToCompMap, Entity, entity))
 #define aEntity(component) (AUDIO.data.compToEntityMap[component])
 
-#define aSound(component) (AUDIO.data.sounds[component])
+#define aSound(component) (*AUDIO.data.sounds[component])
 
 #define aAssertEntity(entity) RJ_DebugAssert((entity) != RJ_INDEX_INVALID &&                                                            \
+                                                 EntityMap_Has(AUDIO.data.entityToCompMap, entity) &&                                   \
                                                  aComponent(entity) != RJ_INDEX_INVALID &&                                              \
                                                  aEntity(aComponent(entity)) == entity &&                                               \
                                                  aComponent(entity) < AUDIO.data.count,                                                 \
                                              "Audio component %u or Entity %u either exceeds maximum possible index %u or is invalid.", \
                                              aComponent(entity), entity, AUDIO.data.count)
 
+/// @brief Patches every entity the audio system stores after Entity_Compact moved them.
+/// @param userData Unused.
+/// @param remap New entity of every old entity, RJ_INDEX_INVALID for destroyed ones.
+/// @param slotCount Number of old entities in remap.
+static void Audio_RemapEntities(void *userData, const Entity *remap, RJ_Size slotCount)
+{
+    (void)userData;
+
+    EntityMap_Remap(&AUDIO.data.entityToCompMap, remap, slotCount);
+
+    for (Entity component = 0; component < AUDIO.data.count; component++)
+    {
+        if (aEntity(component) != RJ_INDEX_INVALID)
+        {
+            aEntity(component) = remap[aEntity(component)];
+        }
+    }
+}
+
 #pragma endregion Source Only
 
 RJ_ResultWarn Audio_Initialize(RJ_Size initialComponentCapacity)
@@ -54,31 +78,48 @@ RJ_ResultWarn Audio_Initialize(RJ_Size initialComponentCapacity)
     AUDIO.data.capacity = initialComponentCapacity;
     AUDIO.data.count = 0;
 
-    RJ_Size entityCapacity = 0;
-    Entity_GetInternalData(&entityCapacity, NULL);
-
-    RJ_ReturnAllocate(RJ_Size, AUDIO.data.entityToCompMap, entityCapacity,
-                      ma_engine_uninit(&AUDIO.engine);
-
-                      AUDIO.data.capacity = 0;
-                      AUDIO.data.count = 0;);
+    EntityMap_Create(&AUDIO.data.entityToCompMap, sizeof(Entity), 0xff);
 
     RJ_ReturnAllocate(Entity, AUDIO.data.compToEntityMap, initialComponentCapacity,
                       ma_engine_uninit(&AUDIO.engine);
-                      free(AUDIO.data.entityToCompMap);
 
                       AUDIO.data.capacity = 0;
                       AUDIO.data.count = 0;);
 
-    RJ_ReturnAllocate(ma_sound, AUDIO.data.sounds, initialComponentCapacity,
+    RJ_ReturnAllocate(ma_sound *, AUDIO.data.sounds, initialComponentCapacity,
                       ma_engine_uninit(&AUDIO.engine);
-                      free(AUDIO.data.entityToCompMap);
                       free(AUDIO.data.compToEntityMap);
 
                       AUDIO.data.capacity = 0;
                       AUDIO.data.count = 0;);
 
-    memset(AUDIO.data.entityToCompMap, 0xff, sizeof(Entity) * entityCapacity);
+    RJ_Result changeResult = Entity_ChangeListenerCreate(&AUDIO.changes);
+    if (changeResult != RJ_OK)
+    {
+        ma_engine_uninit(&AUDIO.engine);
+        free(AUDIO.data.compToEntityMap);
+        free(AUDIO.data.sounds);
+
+        AUDIO.data.capacity = 0;
+        AUDIO.data.count = 0;
+        RJ_DebugWarning("Failed to create audio entity change listener.");
+        return changeResult;
+    }
+
+    changeResult = Entity_RemapCallbackAdd(Audio_RemapEntities, NULL);
+    if (changeResult != RJ_OK)
+    {
+        Entity_ChangeListenerDestroy(AUDIO.changes);
+        ma_engine_uninit(&AUDIO.engine);
+        free(AUDIO.data.compToEntityMap);
+        free(AUDIO.data.sounds);
+
+        AUDIO.data.capacity = 0;
+        AUDIO.data.count = 0;
+        RJ_DebugWarning("Failed to register audio entity remap callback.");
+        return changeResult;
+    }
+
     memset(AUDIO.data.compToEntityMap, 0xff, sizeof(Entity) * initialComponentCapacity);
 
     RJ_DebugInfo("Audio system initialized with component capacity %u.", initialComponentCapacity);
@@ -89,12 +130,18 @@ void Audio_Terminate(void)
 {
     for (RJ_Size component = AUDIO.data.count; component > 0; component--)
     {
-        ma_sound_uninit(&AUDIO.data.sounds[component - 1]);
+        if (AUDIO.data.sounds[component - 1] != NULL)
+        {
+            ma_sound_uninit(AUDIO.data.sounds[component - 1]);
+            free(AUDIO.data.sounds[component - 1]);
+        }
     }
 
     ma_engine_uninit(&AUDIO.engine);
+    Entity_ChangeListenerDestroy(AUDIO.changes);
+    Entity_RemapCallbackRemove(Audio_RemapEntities, NULL);
 
-    free(AUDIO.data.entityToCompMap);
+    EntityMap_Destroy(&AUDIO.data.entityToCompMap);
     free(AUDIO.data.compToEntityMap);
     free(AUDIO.data.sounds);
 
@@ -118,45 +165,81 @@ void Audio_SetListenerData(const AudioListener *listenerData)
     AUDIO.listener = *listenerData;
 }
 
-/*
-!RJ_ResultWarn Audio_Resize(RJ_Size newComponentCapacity)
+RJ_ResultWarn Audio_Resize(RJ_Size newComponentCapacity)
 {
-    RJ_DebugAssert(newComponentCapacity > AUDIO.data.count, "New component capacity must be greater than current audio component count");
+    if (newComponentCapacity < AUDIO.data.count || newComponentCapacity == 0)
+    {
+        RJ_DebugWarning("New audio component capacity %u can not hold the %u components.", newComponentCapacity, AUDIO.data.count);
+        return RJ_ERROR_CAPACITY;
+    }
 
-    RJ_ReturnReallocate(RJ_Size, AUDIO.data.entityToCompMap, AUDIO.data.capacity); // todo proper failing
+    RJ_Size oldCapacity = AUDIO.data.capacity;
 
-    RJ_ReturnReallocate(Entity, AUDIO.data.compToEntityMap, AUDIO.data.capacity,
-                        free(AUDIO.data.entityToCompMap););
+    // a failure below leaves every buffer holding at least the smaller capacity, so that one stays usable
+    AUDIO.data.capacity = Maths_Min(oldCapacity, newComponentCapacity);
 
-    RJ_ReturnReallocate(ma_sound, AUDIO.data.sounds, AUDIO.data.capacity,
-                        free(AUDIO.data.compToEntityMap);
-                        free(AUDIO.data.entityToCompMap););
+    RJ_ReturnResize(Entity, AUDIO.data.compToEntityMap, oldCapacity, newComponentCapacity, 0xff);
+    RJ_ReturnResize(ma_sound *, AUDIO.data.sounds, oldCapacity, newComponentCapacity, 0);
 
     AUDIO.data.capacity = newComponentCapacity;
 
-    RJ_DebugInfo("Audio position references reconfigured with new capacity %u.", AUDIO.data.capacity);
+    RJ_DebugInfo("Audio system resized to component capacity %u.", AUDIO.data.capacity);
     return RJ_OK;
 }
-*/
 
 void Audio_Update(void)
 {
-    for (Entity component = 0; component < AUDIO.data.count; component++)
+    Entity_UpdateTransforms();
+    const EntitySpan *spans = Entity_GetSpans(NULL);
+
+    RJ_Size changedCount = 0;
+    const Entity *changed = Entity_GetChangedEntities(AUDIO.changes, &changedCount);
+
+    for (RJ_Size index = 0; index < changedCount; index++)
     {
-        Vector3 componentPos = Entity_GetPosition(aEntity(component));
-        ma_sound_set_position(&aSound(component), componentPos.x, componentPos.y, componentPos.z);
+        if (!EntityMap_Has(AUDIO.data.entityToCompMap, changed[index]))
+        {
+            continue;
+        }
+
+        Entity component = aComponent(changed[index]);
+
+        if (component < AUDIO.data.count && aEntity(component) == changed[index])
+        {
+            Vector3 componentPos = EntitySpan_At(spans, worldPositions, changed[index]);
+            ma_sound_set_position(&aSound(component), componentPos.x, componentPos.y, componentPos.z);
+        }
     }
 
+    Entity_ClearChangedEntities(AUDIO.changes);
+
     ma_engine_listener_set_position(&AUDIO.engine, 0, AUDIO.listener.position.x, AUDIO.listener.position.y, AUDIO.listener.position.z);
     ma_engine_listener_set_direction(&AUDIO.engine, 0, AUDIO.listener.rotation.x, AUDIO.listener.rotation.y, AUDIO.listener.rotation.z); // todo forward rotation
 }
 
 RJ_ResultWarn Audio_ComponentCreate(Entity entity, StringView audioFile)
 {
-    RJ_DebugAssert(AUDIO.data.count < AUDIO.data.capacity, "Maximum audio component capacity of %u reached.", AUDIO.data.capacity);
+    if (AUDIO.data.count == AUDIO.data.capacity)
+    {
+        RJ_Result resizeResult = Audio_Resize(Maths_Max(AUDIO.data.capacity * AUDIO_RESIZE_MULTIPLIER, 1));
+
+        if (resizeResult != RJ_OK)
+        {
+            RJ_DebugWarning("Audio component capacity of %u could not grow.", AUDIO.data.capacity);
+            return resizeResult;
+        }
+    }
+
+    if (EntityMap_Reserve(&AUDIO.data.entityToCompMap, entity) != RJ_OK)
+    {
+        RJ_DebugWarning("Audio entity map could not grow to Entity %u.", entity);
+        return RJ_ERROR_ALLOCATION;
+    }
 
     Entity component = AUDIO.data.count;
 
+    RJ_ReturnAllocate(ma_sound, AUDIO.data.sounds[component], 1);
+
     aComponent(entity) = component;
     aEntity(component) = entity;
 
@@ -174,6 +257,8 @@ RJ_ResultWarn Audio_ComponentCreate(Entity entity, StringView audioFile)
 
     if (result != MA_SUCCESS)
     {
+        free(AUDIO.data.sounds[component]);
+        AUDIO.data.sounds[component] = NULL;
         aComponent(entity) = RJ_INDEX_INVALID;
         aEntity(component) = RJ_INDEX_INVALID;
         RJ_DebugWarning("Failed to create audio component : %zu", result);
@@ -182,6 +267,11 @@ RJ_ResultWarn Audio_ComponentCreate(Entity entity, StringView audioFile)
 
     String_Destroy(&fullPath);
 
+    // static entities never show up as changed, so the position is set once here
+    Entity_UpdateTransforms();
+    Vector3 componentPos = Entity_GetWorldPosition(entity);
+    ma_sound_set_position(&aSound(component), componentPos.x, componentPos.y, componentPos.z);
+
     AUDIO.data.count++;
 
     return RJ_OK;
@@ -192,6 +282,8 @@ void Audio_ComponentDestroy(Entity entity)
     aAssertEntity(entity);
 
     ma_sound_uninit(&aSound(aComponent(entity)));
+    free(AUDIO.data.sounds[aComponent(entity)]);
+    AUDIO.data.sounds[aComponent(entity)] = NULL;
 
     // todo swap with last component
     aEntity(aComponent(entity)) = RJ_INDEX_INVALID;
@@ -202,7 +294,7 @@ void Audio_ComponentDestroy(Entity entity)
 
 bool Audio_ComponentValidate(Entity entity)
 {
-    return (aComponent(entity) < AUDIO.data.count);
+    return (EntityMap_Has(AUDIO.data.entityToCompMap, entity) && aComponent(entity) < AUDIO.data.count);
 }
 
 void Audio_ComponentRewind(Entity entity, float interval)
@@ -2,421 +2,4251 @@
 
 #include "utilities/Maths.h"
 #include "utilities/ListArray.h"
+#include "utilities/ThreadPool.h"
+#include "utilities/Timer.h"
+
+#include <math.h>
+
+#if RJ_ARCHITECTURE == RJ_ARCHITECTURE_X64
+#include <immintrin.h>
+#endif
 
 #pragma region Source Only
 
 #define PHYSICS_FLAG_STATIC (1 << 0)
+#define PHYSICS_FLAG_CONTINUOUS (1 << 1)
+#define PHYSICS_FLAG_TRIGGER (1 << 2)
+#define PHYSICS_FLAG_SHAPE_SHIFT 3
+#define PHYSICS_FLAG_SHAPE_MASK (3 << PHYSICS_FLAG_SHAPE_SHIFT)
 #define PHYSICS_SEPARATION_EPSILON 0.001f
 
-struct PHYSICS
+/// @brief Cell size of the broadphase grid relative to the average largest extent of the colliders.
+#define PHYSICS_GRID_CELL_SIZE_MULTIPLIER 2.0f
+/// @brief Components covering more grid cells than this are tested against every other component instead of being inserted to the grid.
+#define PHYSICS_GRID_MAX_CELLS_PER_COMPONENT 64
+/// @brief Grid cell coordinates are clamped to this magnitude, so components far from the origin share the border cells instead of overflowing the conversion, and the difference of two cells and the loops over cells stay in int32 range.
+#define PHYSICS_GRID_MAX_CELL (1 << 29)
+/// @brief Margin added to the broadphase bounds so pairs pushed into contact during the resolve iterations are not missed.
+#define PHYSICS_BROADPHASE_MARGIN 0.01f
+/// @brief The resize multiplier used when an internal physics buffer is full.
+#define PHYSICS_BUFFER_RESIZE_MULTIPLIER 2
+/// @brief Number of floats processed together by the widest integration kernel. Lane columns are padded to a multiple of it.
+#define PHYSICS_LANE_WIDTH 8
+/// @brief Byte alignment of every lane column, enough for aligned AVX loads and stores.
+#define PHYSICS_LANE_ALIGNMENT 32
+/// @brief Number of float columns in the lane block : velocity, collider size and position, three axes each, then the four material columns.
+#define PHYSICS_LANE_COLUMN_COUNT 13
+/// @brief Minimum number of components integrated by a single thread.
+#define PHYSICS_PARALLEL_COMPONENT_GRANULARITY 256
+/// @brief Minimum number of pairs tested by a single thread in the narrowphase.
+#define PHYSICS_PARALLEL_PAIR_GRANULARITY 256
+/// @brief Minimum number of contacts of a color resolved by a single thread.
+#define PHYSICS_PARALLEL_CONTACT_GRANULARITY 64
+/// @brief Components slower than this are considered resting.
+#define PHYSICS_SLEEP_VELOCITY_THRESHOLD 0.2f
+/// @brief Number of consecutive resting steps after which an island whose components are all resting falls asleep.
+#define PHYSICS_SLEEP_STEP_COUNT 30
+/// @brief Number of contact colors. The last color collects the contacts that could not be colored and is resolved on a single thread.
+#define PHYSICS_SOLVER_COLOR_COUNT 64
+/// @brief Minimum slot count of a contact cache table. Tables are powers of two kept below half load.
+#define PHYSICS_CACHE_MIN_CAPACITY 256
+/// @brief Marks an unused contact cache slot, never a valid key since it would pair the invalid entity with itself.
+#define PHYSICS_CACHE_EMPTY_KEY UINT64_MAX
+/// @brief Multiplier of the fibonacci hashing of contact cache keys.
+#define PHYSICS_CACHE_HASH_MULTIPLIER 0x9E3779B97F4A7C15ull
+/// @brief Cached separation axis of a contact that has not been resolved yet.
+#define PHYSICS_CACHE_AXIS_NONE 3
+/// @brief Cached separation axis of a contact resolved along its normal, which is not cached.
+#define PHYSICS_CACHE_AXIS_NORMAL 4
+/// @brief Cached separation axis of a pair whose component was destroyed since the last step. The pair ends even if a new component reuses the entity.
+#define PHYSICS_CACHE_AXIS_DESTROYED 5
+/// @brief The cached separation axis of a contact is kept while its overlap is at most this many times the smallest overlap.
+#define PHYSICS_CACHE_AXIS_HYSTERESIS 1.5f
+/// @brief Pairs closer than this are contacts even if they do not overlap, so resting contacts and their cached impulses are kept. Must be below twice the broadphase margin.
+#define PHYSICS_CONTACT_DISTANCE 0.005f
+/// @brief Contacts approaching slower than this are stopped instead of bounced and their velocity change is cached as a resting impulse.
+#define PHYSICS_CONTACT_RESTING_VELOCITY 0.5f
+/// @brief Number of collision shapes. Pairs are grouped by first shape * PHYSICS_SHAPE_COUNT + second shape.
+#define PHYSICS_SHAPE_COUNT 3
+#define PHYSICS_SHAPE_PAIR_COUNT (PHYSICS_SHAPE_COUNT * PHYSICS_SHAPE_COUNT)
+
+#ifndef PHYSICS_FORCE_SCALAR
+/// @brief Set to 1 to always use the portable scalar integration kernel, e.g. to compare results against the vector kernels.
+#define PHYSICS_FORCE_SCALAR 0
+#endif
+
+#ifndef PHYSICS_ENABLE_STATS
+/// @brief Set to 0 to compile the phase timers and counters of Physics_GetStats out of the step.
+#define PHYSICS_ENABLE_STATS 1
+#endif
+
+#pragma region Typedefs
+
+/// @brief World space bounds of a collider, expanded with the broadphase margin.
+typedef struct PHYSICS_BOUNDS
+{
+    Vector3 min;
+    Vector3 max;
+} PHYSICS_BOUNDS;
+
+/// @brief A candidate pair of components emitted by the broadphase.
+typedef struct PHYSICS_PAIR
+{
+    Entity first;
+    Entity second;
+} PHYSICS_PAIR;
+
+/// @brief Growable list of candidate pairs.
+typedef struct PHYSICS_PAIR_LIST
+{
+    RJ_Size count;
+    RJ_Size capacity;
+    PHYSICS_PAIR *pairs;
+    RJ_Size groupStarts[PHYSICS_SHAPE_PAIR_COUNT + 1]; // prefix sums into the pairs grouped by shape pair, set by PhysicsNarrowphase_GroupPairs
+} PHYSICS_PAIR_LIST;
+
+/// @brief A component inserted to a single grid cell.
+typedef struct PHYSICS_GRID_ENTRY
+{
+    int32_t cellX;
+    int32_t cellY;
+    int32_t cellZ;
+    Entity component;
+} PHYSICS_GRID_ENTRY;
+
+/// @brief Uniform spatial hash grid. Entries are counting sorted by their bucket so every bucket is a continuous run.
+typedef struct PHYSICS_GRID
+{
+    float cellSize;
+    float inverseCellSize;
+
+    RJ_Size bucketCount;
+    RJ_Size bucketCapacity;
+    RJ_Size *bucketStarts; // bucketCount + 1 prefix sums into entries
+
+    RJ_Size entryCount;
+    RJ_Size entryCapacity;
+    PHYSICS_GRID_ENTRY *entries;
+
+    RJ_Size oversizedCount;
+    RJ_Size oversizedCapacity;
+    Entity *oversized; // components that are not inserted to the grid
+
+    PHYSICS_BOUNDS extent; // union of the bounds of the inserted components, queries are clipped to it
+} PHYSICS_GRID;
+
+/// @brief Minimum or maximum end of a collider on a single axis.
+typedef struct PHYSICS_ENDPOINT
+{
+    float value;
+    RJ_Size data; // component << 1 | isMax
+} PHYSICS_ENDPOINT;
+
+/// @brief Sorted endpoints of the colliders on all axes. Kept across frames and re-sorted with insertion sort, so the order barely changes for coherent scenes.
+typedef struct PHYSICS_SWEEP
+{
+    bool isDirty;
+
+    RJ_Size endpointCount;
+    RJ_Size endpointCapacity;
+    PHYSICS_ENDPOINT *endpoints[3];
+
+    RJ_Size activeCount;
+    RJ_Size activeCapacity;
+    Entity *active; // components whose range is open during the sweep
+
+    RJ_Size activeIndexCapacity;
+    RJ_Size *activeIndices; // indexed by component, position in active array
+} PHYSICS_SWEEP;
+
+/// @brief Partitions of the component array, in their order in the array.
+typedef enum PHYSICS_PARTITION
+{
+    PHYSICS_PARTITION_STATIC = 0,
+    PHYSICS_PARTITION_SLEEPING,
+    PHYSICS_PARTITION_AWAKE,
+} PHYSICS_PARTITION;
+
+/// @brief Structure of arrays storage of a vector attribute. Every axis is a separate aligned float column indexed by component.
+typedef struct PHYSICS_LANES
+{
+    float *x;
+    float *y;
+    float *z;
+} PHYSICS_LANES;
+
+/// @brief Overlapping pair found by the narrowphase.
+typedef struct PHYSICS_CONTACT
+{
+    Entity first;
+    Entity second;
+    Vector3 overlap;    // overlap on every axis, or the unit normal from first to second if the pair has a round shape
+    float depth;        // penetration depth, the smallest overlap of a box pair, negative if the pair only touches
+    RJ_Size cacheEntry; // slot in the current contact cache table, set by PhysicsCache_Attach
+} PHYSICS_CONTACT;
+
+/// @brief Growable packed list of contacts, only overlapping pairs are written.
+typedef struct PHYSICS_CONTACT_LIST
+{
+    RJ_Size count;
+    RJ_Size capacity;
+    PHYSICS_CONTACT *contacts;
+} PHYSICS_CONTACT_LIST;
+
+/// @brief Persistent data of a contact, kept from one step to the next while the pair keeps touching.
+typedef struct PHYSICS_CACHE_ENTRY
+{
+    uint64_t key; // lower entity << 32 | higher entity, PHYSICS_CACHE_EMPTY_KEY if unused
+    uint8_t axis;  // separation axis, PHYSICS_CACHE_AXIS_NONE before the first resolve, PHYSICS_CACHE_AXIS_NORMAL for round pairs, PHYSICS_CACHE_AXIS_DESTROYED after a destroy
+    int8_t sign;   // direction of the normal on the axis, from the lower entity to the higher one
+    float impulse; // accumulated relative normal velocity change that keeps the pair resting, never negative
+} PHYSICS_CACHE_ENTRY;
+
+/// @brief Open addressing hash table of contact cache entries with linear probing.
+typedef struct PHYSICS_CACHE_TABLE
+{
+    RJ_Size count;
+    RJ_Size capacity; // power of two
+    PHYSICS_CACHE_ENTRY *entries;
+} PHYSICS_CACHE_TABLE;
+
+/// @brief Narrowphase kernel, tests every pair of a range and appends the overlapping ones to a contact list with enough capacity.
+typedef void (*PHYSICS_NARROWPHASE_KERNEL)(const PHYSICS_PAIR *pairs, RJ_Size pairCount, PHYSICS_CONTACT_LIST *contacts);
+
+/// @brief Integration kernel, advances the velocities and positions of a component range by one step.
+typedef void (*PHYSICS_INTEGRATE_KERNEL)(RJ_Size firstComponent, RJ_Size componentCount, float gravityStep, float deltaTime);
+
+/// @brief Task given to the thread pool of a world, binds the world on the running thread before the wrapped task.
+typedef struct PHYSICS_TASK
+{
+    PhysicsWorld *world;
+    ThreadPoolTask task;
+    void *userData;
+} PHYSICS_TASK;
+
+#pragma endregion Typedefs
+
+struct PhysicsWorld
 {
     struct PHYSICS_PROPERTIES
-    { // todo move as a struct to header and share through getters/setters or directly move logic to components instead of entire system
-        float drag;
-        float gravity;
-        float elasticity;
+    {
+        float drag;       // drag of new components
+        float gravity;    // scaled by the gravity scale of every component
+        float elasticity; // restitution of new components
     } properties;
 
     struct PHYSICS_DATA
     {
         RJ_Size capacity;
         RJ_Size count;
+        RJ_Size staticCount; // static components are kept in [0, staticCount), dynamic ones in [staticCount, count)
+        RJ_Size awakeStart;  // sleeping dynamic components are kept in [staticCount, awakeStart), awake ones in [awakeStart, count)
 
-        Entity *entityToCompMap;
+        EntityMap entityToCompMap; // Entity, RJ_INDEX_INVALID for entities without a component
         Entity *compToEntityMap;
 
-        Vector3 *velocities;
-        Vector3 *colliderSizes;
+        RJ_Size laneCapacity; // capacity rounded up to PHYSICS_LANE_WIDTH, length of every lane column
+        float *laneMemory;    // single aligned block every lane column points into
+
+        PHYSICS_LANES velocities;
+        PHYSICS_LANES colliderSizes;
+        PHYSICS_LANES positions; // copy of the entity positions, dynamics are gathered every step and statics when the static set changes
+        float *drags; // material columns, kept in the lane block so the integration kernels load them aligned
+        float *gravityScales;
+        float *restitutions;
+        float *frictions;
         float *masses;
         uint8_t *flags;
+        uint32_t *layers; // layer bits of every component
+        uint32_t *masks;  // layers every component collides with, a pair is kept only if each layer is in the other mask
     } data;
-} PHYSICS = {0};
+
+    struct PHYSICS_KERNELS
+    {
+        PHYSICS_INTEGRATE_KERNEL integrate;
+        PHYSICS_NARROWPHASE_KERNEL narrowphase;
+        const char *name;
+    } kernels;
+
+    struct PHYSICS_BROADPHASE
+    {
+        PhysicsBroadphase type;
+
+        PHYSICS_BOUNDS *bounds; // dense, indexed by component
+        uint8_t *isOversized;   // dense, indexed by component
+
+        PHYSICS_GRID grid;
+        PHYSICS_SWEEP sweep;
+
+        bool isStaticDirty;
+        PHYSICS_GRID staticGrid;      // read only between static set changes
+        RJ_Size staticGridVersion;    // identifies the static set the grid was built from
+        RJ_Size staticGridBuildCount; // never restored, so every build gets a new version
+
+        PHYSICS_PAIR_LIST dynamicPairs; // dynamic vs dynamic
+        PHYSICS_PAIR_LIST staticPairs;  // first is static, second is dynamic
+    } broadphase;
+
+    struct PHYSICS_NARROWPHASE
+    {
+        PHYSICS_CONTACT_LIST dynamicContacts;
+        PHYSICS_CONTACT_LIST staticContacts;
+
+        RJ_Size taskFirstContacts[THREAD_POOL_MAX_THREAD_COUNT]; // where every task started writing its contacts
+        RJ_Size taskContactCounts[THREAD_POOL_MAX_THREAD_COUNT];
+
+        RJ_Size roundCount;        // number of sphere and capsule components, pairs are not grouped while 0
+        PHYSICS_PAIR_LIST grouped; // scratch the pairs are grouped into, swapped with the grouped list
+    } narrowphase;
+
+    struct PHYSICS_SOLVER
+    {
+        uint64_t *bodyColors; // dense, indexed by component, colors already used by the contacts of the body
+
+        RJ_Size contactColorCapacity;
+        uint8_t *contactColors;
+
+        PHYSICS_CONTACT_LIST sortedContacts;                // scratch for sorting contacts by color
+        RJ_Size colorStarts[PHYSICS_SOLVER_COLOR_COUNT + 1]; // prefix sums into the contacts sorted by color
+        bool taskIsPenetrating[THREAD_POOL_MAX_THREAD_COUNT]; // set if a task resolved a penetrating contact in the current iteration
+    } solver;
+
+    struct PHYSICS_CACHE
+    {
+        PHYSICS_CACHE_TABLE tables[2]; // contacts of the current and the previous step
+        RJ_Size current;
+        bool isWarmStarted; // impulses of the current table were applied by the last integration
+    } cache;
+
+    struct PHYSICS_SLEEP
+    {
+        uint16_t *restSteps; // dense, indexed by component, consecutive steps the component was resting
+        RJ_Size *islandIds;  // dense, indexed by component, island of a sleeping component
+        RJ_Size nextIslandId;
+
+        RJ_Size *islandParents;      // scratch union find forest over the awake components, indexed by component - awakeStart
+        uint16_t *islandRestSteps;   // scratch, minimum rest steps of the island rooted at an index
+        Entity *transitions;         // scratch, entities falling asleep or island ids waking up
+
+        bool isSleepingDirty;
+        PHYSICS_GRID sleepingGrid; // read only between sleeping set changes
+        PHYSICS_PAIR_LIST wakePairs;
+    } sleep;
+
+    struct PHYSICS_TRIGGER
+    {
+        RJ_Size count; // number of components with the trigger flag, contacts are not filtered while 0
+
+        RJ_Size overlapCount;
+        RJ_Size overlapCapacity;
+        PhysicsTriggerOverlap *overlaps; // overlaps of the last resolve
+    } trigger;
+
+    struct PHYSICS_EVENTS
+    {
+        RJ_Size frame; // incremented by every collision resolve
+
+        RJ_Size count;
+        RJ_Size capacity;
+        RJ_Size droppedCount;
+        PhysicsContactEvent *events; // preallocated, rewound at the start of every resolve
+    } events;
+
+    struct PHYSICS_CONTINUOUS
+    {
+        RJ_Size count;       // number of components with the continuous flag, nothing is swept while 0
+        float deltaTime;     // step of the last integration, 0 after the collisions of the step are resolved
+        float *impactTimes;  // scratch, indexed by component - awakeStart, earliest impact as a fraction of the motion
+    } continuous;
+
+    struct PHYSICS_QUERY
+    {
+        bool isDirty; // positions or the component set changed since the query structures were refreshed
+    } query;
+
+    RJ_Size droppedCount; // pairs, contacts and components left out since the last resolve started because a buffer could not grow
+
+    PhysicsStats stats; // stays zero if PHYSICS_ENABLE_STATS is 0
+
+    ThreadPool *threadPool; // NULL if the step runs on a single thread
+};
+
+/// @brief World of the threads that did not bind another one, backs the single world API.
+static PhysicsWorld PHYSICS_DEFAULT_WORLD = {0};
+/// @brief World the calling thread works on. Worker threads bind the world of the task they run.
+static _Thread_local PhysicsWorld *PHYSICS_WORLD = &PHYSICS_DEFAULT_WORLD;
+
+#define PHYSICS (*PHYSICS_WORLD)
+
+#if PHYSICS_ENABLE_STATS
+#define pStatsNow() TimePoint_GetMonotonicNanoseconds()
+#define pStatsSet(field, value) (PHYSICS.stats.field = (value))
+#define pStatsLap(field, lapStart)                  \
+    do                                              \
+    {                                               \
+        uint64_t lapEnd = pStatsNow();              \
+        PHYSICS.stats.field += lapEnd - (lapStart); \
+        (lapStart) = lapEnd;                        \
+    } while (0)
+#else
+#define pStatsNow() 0ull
+#define pStatsSet(field, value) ((void)0)
+#define pStatsLap(field, lapStart) ((void)(lapStart))
+#endif
 
 #define rEntity(component) (PHYSICS.data.compToEntityMap[component])
-#define rComponent(entity) (PHYSICS.data.entityToCompMap[entity])
+#define rComponent(entity) (EntityMap_At(PHYSICS.data.entityToCompMap, Entity, entity))
+
+#define pLanesGet(lanes, index) Vector3_New((lanes).x[index], (lanes).y[index], (lanes).z[index])
+#define pLanesSet(lanes, index, vector) \
+    do                                  \
+    {                                   \
+        Vector3 laneValue = (vector);   \
+        (lanes).x[index] = laneValue.x; \
+        (lanes).y[index] = laneValue.y; \
+        (lanes).z[index] = laneValue.z; \
+    } while (false)
+
+#define pVelocityX(component) (PHYSICS.data.velocities.x[component])
+#define pVelocityY(component) (PHYSICS.data.velocities.y[component])
+#define pVelocityZ(component) (PHYSICS.data.velocities.z[component])
+#define pVelocity(component) pLanesGet(PHYSICS.data.velocities, component)
+#define pSetVelocity(component, velocity) pLanesSet(PHYSICS.data.velocities, component, velocity)
 
-#define pVelocity(component) (PHYSICS.data.velocities[component])
-#define pColliderSize(component) (PHYSICS.data.colliderSizes[component])
+#define pPositionX(component) (PHYSICS.data.positions.x[component])
+#define pPositionY(component) (PHYSICS.data.positions.y[component])
+#define pPositionZ(component) (PHYSICS.data.positions.z[component])
+#define pPosition(component) pLanesGet(PHYSICS.data.positions, component)
+#define pSetPosition(component, position) pLanesSet(PHYSICS.data.positions, component, position)
+
+#define pColliderSizeX(component) (PHYSICS.data.colliderSizes.x[component])
+#define pColliderSizeY(component) (PHYSICS.data.colliderSizes.y[component])
+#define pColliderSizeZ(component) (PHYSICS.data.colliderSizes.z[component])
+#define pColliderSize(component) pLanesGet(PHYSICS.data.colliderSizes, component)
+#define pSetColliderSize(component, colliderSize) pLanesSet(PHYSICS.data.colliderSizes, component, colliderSize)
+
+#define pDrag(component) (PHYSICS.data.drags[component])
+#define pGravityScale(component) (PHYSICS.data.gravityScales[component])
+#define pRestitution(component) (PHYSICS.data.restitutions[component])
+#define pFriction(component) (PHYSICS.data.frictions[component])
 #define pMass(component) (PHYSICS.data.masses[component])
 #define pFlag(component) (PHYSICS.data.flags[component])
+#define pLayer(component) (PHYSICS.data.layers[component])
+#define pMask(component) (PHYSICS.data.masks[component])
+
+#define pBounds(component) (PHYSICS.broadphase.bounds[component])
+
+#define pLanesAxis(lanes, axis) ((axis) == 0 ? (lanes).x : ((axis) == 1 ? (lanes).y : (lanes).z))
+#define pCacheEntry(slot) (PHYSICS.cache.tables[PHYSICS.cache.current].entries[slot])
 
 #define pIsStatic(component) (pFlag(component) & PHYSICS_FLAG_STATIC)
+#define pIsSleeping(component) ((component) >= PHYSICS.data.staticCount && (component) < PHYSICS.data.awakeStart)
 #define pSetStatic(component, isStatic) (pFlag(component) = ((isStatic) ? (pFlag(component) | PHYSICS_FLAG_STATIC) : (pFlag(component) & (uint8_t)~PHYSICS_FLAG_STATIC)))
+#define pIsTrigger(component) (pFlag(component) & PHYSICS_FLAG_TRIGGER)
+#define pSetTrigger(component, isTrigger) (pFlag(component) = ((isTrigger) ? (pFlag(component) | PHYSICS_FLAG_TRIGGER) : (pFlag(component) & (uint8_t)~PHYSICS_FLAG_TRIGGER)))
+#define pIsContinuous(component) (pFlag(component) & PHYSICS_FLAG_CONTINUOUS)
+#define pShape(component) ((PhysicsShape)((pFlag(component) & PHYSICS_FLAG_SHAPE_MASK) >> PHYSICS_FLAG_SHAPE_SHIFT))
+#define pSetShape(component, shape) (pFlag(component) = (uint8_t)((pFlag(component) & ~PHYSICS_FLAG_SHAPE_MASK) | ((shape) << PHYSICS_FLAG_SHAPE_SHIFT)))
+#define pIsRoundPair(firstComponent, secondComponent) ((pFlag(firstComponent) | pFlag(secondComponent)) & PHYSICS_FLAG_SHAPE_MASK)
+#define pSetContinuous(component, isContinuous) (pFlag(component) = ((isContinuous) ? (pFlag(component) | PHYSICS_FLAG_CONTINUOUS) : (pFlag(component) & (uint8_t)~PHYSICS_FLAG_CONTINUOUS)))
 
 #define pAssertEntity(entity) RJ_DebugAssert((entity) != RJ_INDEX_INVALID &&                                                              \
+                                                 EntityMap_Has(PHYSICS.data.entityToCompMap, entity) &&                                   \
                                                  rComponent(entity) != RJ_INDEX_INVALID &&                                                \
                                                  rEntity(rComponent(entity)) == entity &&                                                 \
                                                  rComponent(entity) < PHYSICS.data.count,                                                 \
                                              "Physics component %u or Entity %u either exceeds maximum possible index %u or is invalid.", \
                                              rComponent(entity), entity, PHYSICS.data.count)
 
-/// @brief Resolve a collision between a static and dynamic physics component.
-/// @param staticComponent Static physics component.
-/// @param dynamicComponent Dynamic physics component.
-/// @param overlap Overlap vector indicating the penetration depth.
-static void PhysicsScene_ResolveStaticVsDynamic(Entity staticComponent, Entity dynamicComponent, Vector3 overlap)
-{
-    Vector3 staticPos = Entity_GetPosition(rEntity(staticComponent));
-    Vector3 dynamicPos = Entity_GetPosition(rEntity(dynamicComponent));
+/// @brief Grows an internal buffer to hold at least the required count of items. Existing items are kept, and so are the buffer and its capacity if the allocation fails.
+/// @return True if the buffer holds the required count of items.
+#define pReserve(type, pointer, capacity, requiredCount)                                                                        \
+    ((pointer) = (type *)PhysicsBuffer_Reserve((pointer), &(capacity), (RJ_Size)(requiredCount), sizeof(type), #type), \
+     (capacity) >= (RJ_Size)(requiredCount))
 
-    if (overlap.x < overlap.y && overlap.x < overlap.z)
+/// @brief Grows a buffer for pReserve.
+/// @param buffer Buffer to grow, can be NULL.
+/// @param capacity Pointer to the item capacity of the buffer, only updated if the buffer grows.
+/// @param requiredCount Number of items the buffer must hold.
+/// @param itemSize Size of an item in bytes.
+/// @param typeName Name of the item type for the warning.
+/// @return The grown buffer, or the given one if it is large enough or could not grow.
+static void *PhysicsBuffer_Reserve(void *buffer, RJ_Size *capacity, RJ_Size requiredCount, size_t itemSize, const char *typeName)
+{
+    if (requiredCount <= *capacity)
     {
-        dynamicPos.x += dynamicPos.x < staticPos.x
-                            ? -(overlap.x + PHYSICS_SEPARATION_EPSILON)
-                            : (overlap.x + PHYSICS_SEPARATION_EPSILON);
-
-        pVelocity(dynamicComponent).x *= -PHYSICS.properties.elasticity;
+        return buffer;
     }
-    else if (overlap.y < overlap.z)
-    {
-        dynamicPos.y += dynamicPos.y < staticPos.y
-                            ? -(overlap.y + PHYSICS_SEPARATION_EPSILON)
-                            : (overlap.y + PHYSICS_SEPARATION_EPSILON);
 
-        pVelocity(dynamicComponent).y *= -PHYSICS.properties.elasticity;
-    }
-    else
+    RJ_Size grownCapacity = Maths_Max(requiredCount, *capacity * PHYSICS_BUFFER_RESIZE_MULTIPLIER);
+    void *grown = realloc(buffer, itemSize * grownCapacity);
+
+    if (grown == NULL)
     {
-        dynamicPos.z += dynamicPos.z < staticPos.z
-                            ? -(overlap.z + PHYSICS_SEPARATION_EPSILON)
-                            : (overlap.z + PHYSICS_SEPARATION_EPSILON);
+        RJ_DebugWarning("Physics buffer reallocation failed for %u items of type '%s'.", grownCapacity, typeName);
+        return buffer;
+    }
+
+    *capacity = grownCapacity;
+    return grown;
+}
+
+#pragma region Contact Events
 
-        pVelocity(dynamicComponent).z *= -PHYSICS.properties.elasticity;
+/// @brief Appends a contact event of the current frame, or counts it as dropped if the buffer is full.
+/// @param type Type of the event.
+/// @param key Cache key of the pair.
+/// @param overlap Overlap of the pair.
+static inline void PhysicsEvents_Push(PhysicsContactEventType type, uint64_t key, Vector3 overlap)
+{
+    if (PHYSICS.events.count == PHYSICS.events.capacity)
+    {
+        PHYSICS.events.droppedCount++;
+        return;
     }
 
-    Entity_SetPosition(rEntity(dynamicComponent), dynamicPos);
+    PHYSICS.events.events[PHYSICS.events.count++] = (PhysicsContactEvent){
+        .first = (Entity)(key >> 32),
+        .second = (Entity)key,
+        .overlap = overlap,
+        .frame = PHYSICS.events.frame,
+        .type = type,
+    };
 }
 
-/// @brief Resolve a collision between two dynamic physics components.
-/// @param firstComponent First dynamic physics component.
-/// @param secondComponent Second dynamic physics component.
-/// @param overlap Overlap vector indicating the penetration depth.
-static void PhysicsScene_ResolveDynamicVsDynamic(Entity firstComponent, Entity secondComponent, Vector3 overlap)
+/// @brief Gets the overlap of a contact as it is reported, round pairs report their normal scaled by the depth.
+/// @param contact Contact to report.
+static inline Vector3 PhysicsEvents_Overlap(const PHYSICS_CONTACT *contact)
 {
-    float totalInvMass = 1.0f / pMass(firstComponent) + 1.0f / pMass(secondComponent);
-    float move1 = 0.0f;
-    float move2 = 0.0f;
+    return pIsRoundPair(contact->first, contact->second) ? Vector3G_Scale(contact->overlap, contact->depth) : contact->overlap;
+}
 
-    Vector3 firstPos = Entity_GetPosition(rEntity(firstComponent));
-    Vector3 secondPos = Entity_GetPosition(rEntity(secondComponent));
+#pragma endregion Contact Events
 
-    if (overlap.x < overlap.y && overlap.x < overlap.z)
-    {
-        move1 = (1.0f / pMass(firstComponent)) / totalInvMass * overlap.x;
-        move2 = (1.0f / pMass(secondComponent)) / totalInvMass * overlap.x;
+#pragma region Contact Cache
 
-        if (firstPos.x < secondPos.x)
-        {
-            firstPos.x -= move1;
-            secondPos.x += move2;
-        }
-        else
-        {
-            firstPos.x += move1;
-            secondPos.x -= move2;
-        }
-    }
-    else if (overlap.y < overlap.z)
-    {
-        move1 = (1.0f / pMass(firstComponent)) / totalInvMass * overlap.y;
-        move2 = (1.0f / pMass(secondComponent)) / totalInvMass * overlap.y;
+/// @brief Orders an entity pair into a cache key. Entities do not move when components are swapped between partitions, so the key stays the same across steps.
+static inline uint64_t PhysicsCache_Key(Entity first, Entity second)
+{
+    return first < second ? ((uint64_t)first << 32 | second) : ((uint64_t)second << 32 | first);
+}
 
-        if (firstPos.y < secondPos.y)
-        {
-            firstPos.y -= move1;
-            secondPos.y += move2;
-        }
-        else
-        {
-            firstPos.y += move1;
-            secondPos.y -= move2;
-        }
-    }
-    else
+/// @brief Finds the slot of a key with linear probing, either the slot holding it or the empty slot it would be inserted to.
+/// @param table Table to search, must have a non zero capacity.
+/// @param key Key to find.
+static inline RJ_Size PhysicsCache_FindSlot(const PHYSICS_CACHE_TABLE *table, uint64_t key)
+{
+    RJ_Size mask = table->capacity - 1;
+    RJ_Size slot = (RJ_Size)((key * PHYSICS_CACHE_HASH_MULTIPLIER) >> 32) & mask;
+
+    while (table->entries[slot].key != PHYSICS_CACHE_EMPTY_KEY && table->entries[slot].key != key)
     {
-        move1 = (1.0f / pMass(firstComponent)) / totalInvMass * overlap.z;
-        move2 = (1.0f / pMass(secondComponent)) / totalInvMass * overlap.z;
+        slot = (slot + 1) & mask;
+    }
 
-        if (firstPos.z < secondPos.z)
-        {
-            firstPos.z -= move1;
-            secondPos.z += move2;
-        }
-        else
-        {
-            firstPos.z += move1;
-            secondPos.z -= move2;
-        }
+    return slot;
+}
+
+/// @brief Grows a table so it holds the required count of entries below half load. Existing entries are rehashed, so slot indices change.
+/// @param table Table to grow.
+/// @param requiredCount Number of entries the table must be able to hold.
+/// @return True if the table holds the required count, the table is left as it is otherwise.
+static bool PhysicsCache_Reserve(PHYSICS_CACHE_TABLE *table, RJ_Size requiredCount)
+{
+    if (requiredCount * 2 <= table->capacity)
+    {
+        return true;
     }
 
-    Entity_SetPosition(rEntity(firstComponent), firstPos);
-    Entity_SetPosition(rEntity(secondComponent), secondPos);
+    RJ_Size capacity = Maths_Max(table->capacity, (RJ_Size)PHYSICS_CACHE_MIN_CAPACITY);
 
-    // v1' = ( (m1 - e*m2)*v1 + (1+e)*m2*v2 ) / (m1+m2)
-    // v2' = ( (m2 - e*m1)*v2 + (1+e)*m1*v1 ) / (m1+m2)
+    while (capacity < requiredCount * 2)
+    {
+        capacity *= 2;
+    }
 
-    float m1 = pMass(firstComponent);
-    float m2 = pMass(secondComponent);
-    float oneOverMassSum = 1.0f / (pMass(firstComponent) + pMass(secondComponent));
+    PHYSICS_CACHE_TABLE grown = {.count = table->count, .capacity = capacity, .entries = NULL};
 
-    if (overlap.x < overlap.y && overlap.x < overlap.z)
+    if (!RJ_Allocate(PHYSICS_CACHE_ENTRY, grown.entries, capacity))
     {
-        float v1 = pVelocity(firstComponent).x;
-        float v2 = pVelocity(secondComponent).x;
-        pVelocity(firstComponent).x = ((m1 - PHYSICS.properties.elasticity * m2) * v1 + (1.0f + PHYSICS.properties.elasticity) * m2 * v2) * oneOverMassSum;
-        pVelocity(secondComponent).x = ((m2 - PHYSICS.properties.elasticity * m1) * v2 + (1.0f + PHYSICS.properties.elasticity) * m1 * v1) * oneOverMassSum;
+        RJ_DebugWarning("Physics contact cache allocation failed for %u entries.", capacity);
+        return false;
     }
-    else if (overlap.y < overlap.z)
+
+    for (RJ_Size slot = 0; slot < capacity; slot++)
     {
-        float v1 = pVelocity(firstComponent).y;
-        float v2 = pVelocity(secondComponent).y;
-        pVelocity(firstComponent).y = ((m1 - PHYSICS.properties.elasticity * m2) * v1 + (1.0f + PHYSICS.properties.elasticity) * m2 * v2) * oneOverMassSum;
-        pVelocity(secondComponent).y = ((m2 - PHYSICS.properties.elasticity * m1) * v2 + (1.0f + PHYSICS.properties.elasticity) * m1 * v1) * oneOverMassSum;
+        grown.entries[slot].key = PHYSICS_CACHE_EMPTY_KEY;
     }
-    else
+
+    for (RJ_Size slot = 0; slot < table->capacity; slot++)
     {
-        float v1 = pVelocity(firstComponent).z;
-        float v2 = pVelocity(secondComponent).z;
-        pVelocity(firstComponent).z = ((m1 - PHYSICS.properties.elasticity * m2) * v1 + (1.0f + PHYSICS.properties.elasticity) * m2 * v2) * oneOverMassSum;
-        pVelocity(secondComponent).z = ((m2 - PHYSICS.properties.elasticity * m1) * v2 + (1.0f + PHYSICS.properties.elasticity) * m1 * v1) * oneOverMassSum;
+        if (table->entries[slot].key != PHYSICS_CACHE_EMPTY_KEY)
+        {
+            grown.entries[PhysicsCache_FindSlot(&grown, table->entries[slot].key)] = table->entries[slot];
+        }
     }
+
+    free(table->entries);
+    *table = grown;
+    return true;
 }
 
-/// @brief Resolve a collision between two physics components. Which resolution method to use is determined by whether components are static or dynamic.
-/// @param firstComponent First physics component.
-/// @param secondComponent Second physics component.
-static void PhysicsScene_ResolveCollision(Entity firstComponent, Entity secondComponent)
+/// @brief Rekeys a table after Entity_Compact moved the entities. Pairs with a destroyed entity are dropped. Entities keep their relative order, so the lower entity of a key stays the lower one and the cached signs stay valid.
+/// @param table Table to rekey, emptied if the rekeyed table can not be allocated.
+/// @param remap New entity of every old entity.
+static void PhysicsCache_Remap(PHYSICS_CACHE_TABLE *table, const Entity *remap)
 {
-    if (pIsStatic(firstComponent) && pIsStatic(secondComponent))
+    if (table->count == 0)
     {
         return;
     }
 
-    Vector3 overlap;
+    PHYSICS_CACHE_TABLE remapped = {.count = 0, .capacity = table->capacity, .entries = NULL};
 
-    if (!Physics_IsColliding(rEntity(firstComponent), rEntity(secondComponent), &overlap))
+    if (!RJ_Allocate(PHYSICS_CACHE_ENTRY, remapped.entries, remapped.capacity))
     {
+        RJ_DebugWarning("Physics contact cache allocation failed for %u entries, the cached contacts are forgotten.", remapped.capacity);
+
+        // old keys name moved entities, so the pairs can only be forgotten
+        for (RJ_Size slot = 0; slot < table->capacity; slot++)
+        {
+            table->entries[slot].key = PHYSICS_CACHE_EMPTY_KEY;
+        }
+
+        table->count = 0;
         return;
     }
 
-    // todo separate arrays to avoid branching
-    if (pIsStatic(firstComponent))
+    for (RJ_Size slot = 0; slot < remapped.capacity; slot++)
     {
-        PhysicsScene_ResolveStaticVsDynamic(firstComponent, secondComponent, overlap);
+        remapped.entries[slot].key = PHYSICS_CACHE_EMPTY_KEY;
     }
-    else if (pIsStatic(secondComponent))
-    {
-        PhysicsScene_ResolveStaticVsDynamic(secondComponent, firstComponent, overlap);
-    }
-    else
+
+    for (RJ_Size slot = 0; slot < table->capacity; slot++)
     {
-        PhysicsScene_ResolveDynamicVsDynamic(firstComponent, secondComponent, overlap);
+        PHYSICS_CACHE_ENTRY entry = table->entries[slot];
+
+        if (entry.key == PHYSICS_CACHE_EMPTY_KEY)
+        {
+            continue;
+        }
+
+        Entity lower = remap[(Entity)(entry.key >> 32)];
+        Entity higher = remap[(Entity)entry.key];
+
+        if (lower == RJ_INDEX_INVALID || higher == RJ_INDEX_INVALID)
+        {
+            continue;
+        }
+
+        entry.key = PhysicsCache_Key(lower, higher);
+        remapped.entries[PhysicsCache_FindSlot(&remapped, entry.key)] = entry;
+        remapped.count++;
     }
-}
 
-#pragma endregion Source Only
+    free(table->entries);
+    *table = remapped;
+}
 
-RJ_ResultWarn Physics_Initialize(RJ_Size initialComponentCapacity, float drag, float gravity, float elasticity)
+/// @brief Starts a new step, the current table becomes the previous one and the new current table is emptied.
+static void PhysicsCache_BeginStep(void)
 {
-    PHYSICS.data.capacity = initialComponentCapacity;
-    PHYSICS.data.count = 0;
+    PHYSICS.cache.current ^= 1;
 
-    PHYSICS.properties.drag = drag;
-    PHYSICS.properties.gravity = gravity;
-    PHYSICS.properties.elasticity = elasticity;
-    RJ_Size entityCapacity = 0;
-    Entity_GetInternalData(&entityCapacity, NULL);
+    PHYSICS_CACHE_TABLE *table = &PHYSICS.cache.tables[PHYSICS.cache.current];
 
-    RJ_ReturnAllocate(Entity, PHYSICS.data.entityToCompMap, entityCapacity);
+    for (RJ_Size slot = 0; slot < table->capacity; slot++)
+    {
+        table->entries[slot].key = PHYSICS_CACHE_EMPTY_KEY;
+    }
 
-    RJ_ReturnAllocate(Entity, PHYSICS.data.compToEntityMap, PHYSICS.data.capacity,
-                      free(PHYSICS.data.entityToCompMap););
+    table->count = 0;
+}
 
-    RJ_ReturnAllocate(Vector3, PHYSICS.data.velocities, PHYSICS.data.capacity,
-                      free(PHYSICS.data.compToEntityMap);
-                      free(PHYSICS.data.entityToCompMap););
+/// @brief Links every contact of a list to its entry in the current table. Contacts seen for the first time in this step take the axis and sign of the previous step, and its impulse if that was warm started. Their begin or stay event is reported here, so events cost nothing more than the lookup the cache does anyway.
+/// @param contacts Contacts to link, their cacheEntry is set.
+/// @note Runs serially before the contacts are resolved, resolving only writes the entries of its own contacts so the threads never share an entry.
+static void PhysicsCache_Attach(PHYSICS_CONTACT_LIST *contacts)
+{
+    PHYSICS_CACHE_TABLE *table = &PHYSICS.cache.tables[PHYSICS.cache.current];
+    const PHYSICS_CACHE_TABLE *previous = &PHYSICS.cache.tables[PHYSICS.cache.current ^ 1];
 
-    RJ_ReturnAllocate(Vector3, PHYSICS.data.colliderSizes, PHYSICS.data.capacity,
-                      free(PHYSICS.data.velocities);
-                      free(PHYSICS.data.compToEntityMap);
-                      free(PHYSICS.data.entityToCompMap););
+    if (!PhysicsCache_Reserve(table, table->count + contacts->count))
+    {
+        // every contact needs an entry, the ones that do not fit below half load are not resolved
+        RJ_Size fittingCount = table->capacity / 2 > table->count ? table->capacity / 2 - table->count : 0;
 
-    RJ_ReturnAllocate(float, PHYSICS.data.masses, PHYSICS.data.capacity,
-                      free(PHYSICS.data.velocities);
-                      free(PHYSICS.data.colliderSizes);
-                      free(PHYSICS.data.compToEntityMap);
-                      free(PHYSICS.data.entityToCompMap););
+        PHYSICS.droppedCount += contacts->count - fittingCount;
+        contacts->count = fittingCount;
+    }
 
-    RJ_ReturnAllocate(uint8_t, PHYSICS.data.flags, PHYSICS.data.capacity,
-                      free(PHYSICS.data.masses);
-                      free(PHYSICS.data.colliderSizes);
-                      free(PHYSICS.data.velocities);
-                      free(PHYSICS.data.compToEntityMap);
-                      free(PHYSICS.data.entityToCompMap););
+    for (RJ_Size contact = 0; contact < contacts->count; contact++)
+    {
+        uint64_t key = PhysicsCache_Key(rEntity(contacts->contacts[contact].first), rEntity(contacts->contacts[contact].second));
+        RJ_Size slot = PhysicsCache_FindSlot(table, key);
+        PHYSICS_CACHE_ENTRY *entry = &table->entries[slot];
 
-    memset(PHYSICS.data.entityToCompMap, 0xff, sizeof(Entity) * entityCapacity);
-    memset(PHYSICS.data.compToEntityMap, 0xff, sizeof(Entity) * initialComponentCapacity);
+        contacts->contacts[contact].cacheEntry = slot;
 
-    RJ_DebugInfo("Physics initialized with component capacity %u.", PHYSICS.data.capacity);
+        if (entry->key == key)
+        {
+            continue;
+        }
 
-    return RJ_OK;
-}
+        *entry = (PHYSICS_CACHE_ENTRY){.key = key, .axis = PHYSICS_CACHE_AXIS_NONE};
+        table->count++;
 
-void Physics_Terminate(void)
-{
-    free(PHYSICS.data.entityToCompMap);
-    free(PHYSICS.data.compToEntityMap);
-    free(PHYSICS.data.velocities);
-    free(PHYSICS.data.colliderSizes);
-    free(PHYSICS.data.masses);
-    free(PHYSICS.data.flags);
+        const PHYSICS_CACHE_ENTRY *last = previous->count > 0 ? &previous->entries[PhysicsCache_FindSlot(previous, key)] : NULL;
 
-    memset(&PHYSICS, 0, sizeof(PHYSICS));
+        if (last == NULL || last->key != key || last->axis == PHYSICS_CACHE_AXIS_DESTROYED)
+        {
+            PhysicsEvents_Push(PhysicsContactEvent_Begin, key, PhysicsEvents_Overlap(&contacts->contacts[contact]));
+            continue;
+        }
 
-    RJ_DebugInfo("Physics terminated successfully.");
-}
+        PhysicsEvents_Push(PhysicsContactEvent_Stay, key, PhysicsEvents_Overlap(&contacts->contacts[contact]));
 
-bool Physics_IsInitialized(void)
-{
-    return PHYSICS.data.capacity > 0;
+        entry->axis = last->axis;
+        entry->sign = last->sign;
+        entry->impulse = PHYSICS.cache.isWarmStarted ? last->impulse : 0.0f;
+    }
 }
 
-/*
-!RJ_ResultWarn Physics_Resize(RJ_Size newCapacity)
+/// @brief Finishes a step by comparing the previous table to the current one. Pairs missing from the current table or with a destroyed component end, except the ones with a sleeping component, which are not collected but still touch. Those are carried over to the current table so they neither end nor begin again when woken.
+/// @note Carried entries lose their impulse since it is not applied while sleeping.
+static void PhysicsCache_EndStep(void)
 {
-    RJ_DebugAssert(newCapacity > PHYSICS.data.count, "New component capacity must be greater than current physics component count.");
+    PHYSICS_CACHE_TABLE *table = &PHYSICS.cache.tables[PHYSICS.cache.current];
+    const PHYSICS_CACHE_TABLE *previous = &PHYSICS.cache.tables[PHYSICS.cache.current ^ 1];
+
+    if (previous->count == 0)
+    {
+        return;
+    }
 
-    RJ_ReturnReallocate(Entity, PHYSICS.data.entityToCompMap, PHYSICS.data.capacity);
+    for (RJ_Size slot = 0; slot < previous->capacity; slot++)
+    {
+        const PHYSICS_CACHE_ENTRY *last = &previous->entries[slot];
 
-    RJ_ReturnReallocate(Entity, PHYSICS.data.compToEntityMap, PHYSICS.data.capacity,
-                        free(PHYSICS.data.entityToCompMap););
+        if (last->key == PHYSICS_CACHE_EMPTY_KEY)
+        {
+            continue;
+        }
 
-    RJ_ReturnReallocate(Vector3, PHYSICS.data.velocities, PHYSICS.data.capacity,
-                        free(PHYSICS.data.compToEntityMap);
-                        free(PHYSICS.data.entityToCompMap););
+        bool isDestroyed = last->axis == PHYSICS_CACHE_AXIS_DESTROYED;
 
-    RJ_ReturnReallocate(Vector3, PHYSICS.data.colliderSizes, PHYSICS.data.capacity,
-                        free(PHYSICS.data.velocities);
-                        free(PHYSICS.data.compToEntityMap);
-                        free(PHYSICS.data.entityToCompMap););
+        if (!isDestroyed && table->count > 0 && table->entries[PhysicsCache_FindSlot(table, last->key)].key == last->key)
+        {
+            continue;
+        }
 
-    RJ_ReturnReallocate(float, PHYSICS.data.masses, PHYSICS.data.capacity,
-                        free(PHYSICS.data.colliderSizes);
-                        free(PHYSICS.data.velocities);
-                        free(PHYSICS.data.compToEntityMap);
-                        free(PHYSICS.data.entityToCompMap););
+        Entity lower = rComponent((Entity)(last->key >> 32));
+        Entity higher = rComponent((Entity)last->key);
 
-    RJ_ReturnReallocate(uint8_t, PHYSICS.data.flags, PHYSICS.data.capacity,
-                        free(PHYSICS.data.masses);
-                        free(PHYSICS.data.colliderSizes);
-                        free(PHYSICS.data.velocities);
-                        free(PHYSICS.data.compToEntityMap);
-                        free(PHYSICS.data.entityToCompMap););
+        if (!isDestroyed && lower < PHYSICS.data.count && higher < PHYSICS.data.count && (pIsSleeping(lower) || pIsSleeping(higher)) &&
+            PhysicsCache_Reserve(table, table->count + 1))
+        {
+            PHYSICS_CACHE_ENTRY *entry = &table->entries[PhysicsCache_FindSlot(table, last->key)];
+            *entry = *last;
+            entry->impulse = 0.0f;
+            table->count++;
 
-    PHYSICS.data.capacity = newCapacity;
+            continue;
+        }
 
-    RJ_DebugInfo("Physics position references reconfigured with new capacity %u.", PHYSICS.data.capacity);
-    return RJ_OK;
+        PhysicsEvents_Push(PhysicsContactEvent_End, last->key, Vector3_Zero);
+    }
 }
-*/
 
-bool Physics_IsColliding(Entity entity1, Entity entity2, Vector3 *overlapRet)
+/// @brief Marks the pairs of a destroyed entity in the current table. Entities are reused, so a new component must neither take over their impulses nor continue their contacts.
+/// @param entity Entity whose component is destroyed.
+static void PhysicsCache_Forget(Entity entity)
 {
-    Vector3 position1 = Entity_GetPosition(entity1);
-    Vector3 position2 = Entity_GetPosition(entity2);
-
-    Vector3 colliderSize1 = pColliderSize(rComponent(entity1));
-    Vector3 colliderSize2 = pColliderSize(rComponent(entity2));
-
-    Vector3 overlap = Vector3_Zero;
-
-    overlap.x = Maths_Min(position1.x + colliderSize1.x / 2.0f,
-                          position2.x + colliderSize2.x / 2.0f) -
-                Maths_Max(position1.x - colliderSize1.x / 2.0f,
-                          position2.x - colliderSize2.x / 2.0f);
-
-    overlap.y = Maths_Min(position1.y + colliderSize1.y / 2.0f,
-                          position2.y + colliderSize2.y / 2.0f) -
-                Maths_Max(position1.y - colliderSize1.y / 2.0f,
-                          position2.y - colliderSize2.y / 2.0f);
-
-    overlap.z = Maths_Min(position1.z + colliderSize1.z / 2.0f,
-                          position2.z + colliderSize2.z / 2.0f) -
-                Maths_Max(position1.z - colliderSize1.z / 2.0f,
-                          position2.z - colliderSize2.z / 2.0f);
+    PHYSICS_CACHE_TABLE *table = &PHYSICS.cache.tables[PHYSICS.cache.current];
 
-    if (overlapRet != NULL)
+    if (table->count == 0)
     {
-        *overlapRet = overlap;
+        return;
     }
 
-    return overlap.x > 0.0f && overlap.y > 0.0f && overlap.z > 0.0f;
+    for (RJ_Size slot = 0; slot < table->capacity; slot++)
+    {
+        PHYSICS_CACHE_ENTRY *entry = &table->entries[slot];
+
+        if (entry->key != PHYSICS_CACHE_EMPTY_KEY && ((Entity)(entry->key >> 32) == entity || (Entity)entry->key == entity))
+        {
+            entry->axis = PHYSICS_CACHE_AXIS_DESTROYED;
+            entry->impulse = 0.0f;
+        }
+    }
 }
 
-void Physics_UpdateComponents(float deltaTime)
+/// @brief Applies the resting impulse of every contact of the last step to the velocities, before they are integrated. Supported components then cancel gravity instead of sinking and being pushed back every step.
+/// @note Impulses that are not needed anymore are taken back by the resolve, which keeps the total impulse of a contact positive.
+static void PhysicsCache_WarmStart(void)
 {
-    for (Entity component = 0; component < PHYSICS.data.count; component++)
+    const PHYSICS_CACHE_TABLE *table = &PHYSICS.cache.tables[PHYSICS.cache.current];
+
+    for (RJ_Size slot = 0; slot < table->capacity; slot++)
     {
-        if (pIsStatic(component))
+        const PHYSICS_CACHE_ENTRY *entry = &table->entries[slot];
+
+        if (entry->key == PHYSICS_CACHE_EMPTY_KEY || entry->impulse <= 0.0f)
         {
             continue;
         }
 
-        pVelocity(component) = Vector3G_Sum(pVelocity(component), Vector3_New(0.0f, PHYSICS.properties.gravity * deltaTime, 0.0f));
-        pVelocity(component) = Vector3G_Scale(pVelocity(component), 1.0f - PHYSICS.properties.drag);
+        Entity lower = rComponent((Entity)(entry->key >> 32));
+        Entity higher = rComponent((Entity)entry->key);
 
-        Entity_SetPosition(rEntity(component), Vector3G_Sum(Entity_GetPosition(rEntity(component)), Vector3G_Scale(pVelocity(component), deltaTime)));
+        if (lower >= PHYSICS.data.count || higher >= PHYSICS.data.count || pIsSleeping(lower) || pIsSleeping(higher) || (pIsStatic(lower) && pIsStatic(higher)))
+        {
+            continue; // destroyed, fell asleep or became static since the last step
+        }
+
+        float lowerInvMass = pIsStatic(lower) ? 0.0f : 1.0f / pMass(lower);
+        float higherInvMass = pIsStatic(higher) ? 0.0f : 1.0f / pMass(higher);
+        float impulse = (float)entry->sign * entry->impulse / (lowerInvMass + higherInvMass);
+        float *velocities = pLanesAxis(PHYSICS.data.velocities, entry->axis);
+
+        velocities[lower] -= impulse * lowerInvMass;
+        velocities[higher] += impulse * higherInvMass;
+    }
+
+    PHYSICS.cache.isWarmStarted = true;
+}
+
+/// @brief Selects the separation axis of a contact. The axis of the smallest overlap is used unless the cached axis still overlaps nearly as little, which keeps resting contacts from flipping between axes.
+/// @param entry Cache entry of the contact.
+/// @param overlaps Overlap of the contact on every axis.
+static inline RJ_Size PhysicsCache_SelectAxis(const PHYSICS_CACHE_ENTRY *entry, const float *overlaps)
+{
+    RJ_Size axis = overlaps[0] < overlaps[1] && overlaps[0] < overlaps[2] ? 0 : (overlaps[1] < overlaps[2] ? 1 : 2);
+
+    if (entry->axis < PHYSICS_CACHE_AXIS_NONE && entry->axis != axis && overlaps[entry->axis] <= overlaps[axis] * PHYSICS_CACHE_AXIS_HYSTERESIS)
+    {
+        return entry->axis;
+    }
+
+    return axis;
+}
+
+/// @brief Selects the direction of the contact normal on the axis, from the first component to the second. The cached direction is kept while the axis does not change, otherwise the entry is reset from the positions.
+/// @param contact Contact to select for.
+/// @param entry Cache entry of the contact.
+/// @param axis Selected separation axis.
+/// @param positionSign Direction found from the positions of the components.
+static inline float PhysicsCache_SelectSign(const PHYSICS_CONTACT *contact, PHYSICS_CACHE_ENTRY *entry, RJ_Size axis, float positionSign)
+{
+    float keySign = rEntity(contact->first) < rEntity(contact->second) ? 1.0f : -1.0f; // entry sign is stored from the lower entity to the higher one
+
+    if (entry->axis != axis)
+    {
+        entry->axis = (uint8_t)axis;
+        entry->sign = (int8_t)(positionSign * keySign);
+        entry->impulse = 0.0f;
+        return positionSign;
+    }
+
+    return (float)entry->sign * keySign;
+}
+
+#pragma endregion Contact Cache
+
+/// @brief Applies Coulomb friction to the tangential relative velocity of a contact. The velocity change is limited by the friction of the pair times the normal velocity change of the contact, so a resting component slows down by friction times gravity.
+/// @param firstComponent First component of the contact.
+/// @param secondComponent Second component of the contact.
+/// @param axis Separation axis of the contact, the other two axes are tangential.
+/// @param normalImpulse Relative normal velocity change of the contact in this step, resting impulse included.
+/// @param share1 Share of the first component from the change, 0 for static components.
+/// @param share2 Share of the second component from the change.
+static inline void PhysicsScene_ApplyFriction(Entity firstComponent, Entity secondComponent, RJ_Size axis, float normalImpulse, float share1, float share2)
+{
+    float friction = sqrtf(pFriction(firstComponent) * pFriction(secondComponent));
+
+    if (friction == 0.0f || normalImpulse <= 0.0f)
+    {
+        return;
+    }
+
+    float *tangents1 = pLanesAxis(PHYSICS.data.velocities, (axis + 1) % 3);
+    float *tangents2 = pLanesAxis(PHYSICS.data.velocities, (axis + 2) % 3);
+
+    float relative1 = tangents1[secondComponent] - tangents1[firstComponent];
+    float relative2 = tangents2[secondComponent] - tangents2[firstComponent];
+    float speed = sqrtf(relative1 * relative1 + relative2 * relative2);
+
+    if (speed == 0.0f)
+    {
+        return;
+    }
+
+    float scale = Maths_Min(friction * normalImpulse / speed, 1.0f);
+
+    if (share1 > 0.0f) // static components are shared by the contacts of every thread, they are only read
+    {
+        tangents1[firstComponent] += relative1 * scale * share1;
+        tangents2[firstComponent] += relative2 * scale * share1;
+    }
+
+    tangents1[secondComponent] -= relative1 * scale * share2;
+    tangents2[secondComponent] -= relative2 * scale * share2;
+}
+
+/// @brief Resolves a contact with a sphere or a capsule along its normal. The normal turns with the components, so the contact is neither cached nor warm started.
+/// @param contact Contact of a round pair, the first component is static if share1 is 0.
+/// @param share1 Share of the first component from the separation and the velocity change.
+/// @param share2 Share of the second component from the separation and the velocity change.
+/// @param separation Distance added to the separation.
+/// @return True if the components were penetrating, false if they were only closer than the contact distance.
+static bool PhysicsScene_ResolveRound(const PHYSICS_CONTACT *contact, float share1, float share2, float separation)
+{
+    Entity firstComponent = contact->first;
+    Entity secondComponent = contact->second;
+    PHYSICS_CACHE_ENTRY *entry = &pCacheEntry(contact->cacheEntry);
+    Vector3 normal = contact->overlap;
+
+    entry->axis = PHYSICS_CACHE_AXIS_NORMAL;
+    entry->impulse = 0.0f;
+
+    if (contact->depth <= 0.0f)
+    {
+        return false;
+    }
+
+    Vector3 relative = Vector3G_Sum(pVelocity(secondComponent), Vector3G_Scale(pVelocity(firstComponent), -1.0f));
+    float normalVelocity = Vector3G_Dot(relative, normal);
+    Vector3 impulse = Vector3_Zero;
+
+    if (normalVelocity < 0.0f)
+    {
+        float restitution = Maths_Max(pRestitution(firstComponent), pRestitution(secondComponent));
+        float change = normalVelocity < -PHYSICS_CONTACT_RESTING_VELOCITY ? -(1.0f + restitution) * normalVelocity : -normalVelocity;
+
+        // friction acts on the tangential part of the relative velocity, which the normal change does not touch
+        Vector3 tangent = Vector3G_Sum(relative, Vector3G_Scale(normal, -normalVelocity));
+        float speed = Vector3_Magnitude(tangent);
+        float friction = sqrtf(pFriction(firstComponent) * pFriction(secondComponent));
+        float scale = speed > 0.0f ? Maths_Min(friction * change / speed, 1.0f) : 0.0f;
+
+        impulse = Vector3G_Sum(Vector3G_Scale(normal, change), Vector3G_Scale(tangent, -scale));
+    }
+
+    Vector3 push = Vector3G_Scale(normal, (contact->depth + separation));
+
+    if (share1 > 0.0f) // static components are shared by the contacts of every thread, they are only read
+    {
+        pSetPosition(firstComponent, Vector3G_Sum(pPosition(firstComponent), Vector3G_Scale(push, -share1)));
+        pSetVelocity(firstComponent, Vector3G_Sum(pVelocity(firstComponent), Vector3G_Scale(impulse, -share1)));
+    }
+
+    pSetPosition(secondComponent, Vector3G_Sum(pPosition(secondComponent), Vector3G_Scale(push, share2)));
+    pSetVelocity(secondComponent, Vector3G_Sum(pVelocity(secondComponent), Vector3G_Scale(impulse, share2)));
+
+    return true;
+}
+
+/// @brief Resolve a collision between a static and dynamic physics component.
+/// @param contact Contact whose first component is static and second one is dynamic.
+/// @return True if the components were penetrating, false if they were only closer than the contact distance.
+/// @note Approaching contacts slower than the resting velocity are stopped instead of bounced and the velocity change is added to the cached impulse. A separating contact takes back the warm started impulse it does not need.
+static bool PhysicsScene_ResolveStaticVsDynamic(const PHYSICS_CONTACT *contact)
+{
+    Entity staticComponent = contact->first;
+    Entity dynamicComponent = contact->second;
+
+    if (pIsRoundPair(staticComponent, dynamicComponent))
+    {
+        return PhysicsScene_ResolveRound(contact, 0.0f, 1.0f, PHYSICS_SEPARATION_EPSILON);
+    }
+
+    PHYSICS_CACHE_ENTRY *entry = &pCacheEntry(contact->cacheEntry);
+
+    float overlaps[3] = {contact->overlap.x, contact->overlap.y, contact->overlap.z};
+    RJ_Size axis = PhysicsCache_SelectAxis(entry, overlaps);
+    float *positions = pLanesAxis(PHYSICS.data.positions, axis);
+    float *velocities = pLanesAxis(PHYSICS.data.velocities, axis);
+    float sign = PhysicsCache_SelectSign(contact, entry, axis, positions[dynamicComponent] < positions[staticComponent] ? -1.0f : 1.0f);
+
+    float normalVelocity = velocities[dynamicComponent] * sign;
+    float bounce = 0.0f;
+    bool isPenetrating = overlaps[axis] > 0.0f;
+
+    if (normalVelocity > 0.0f && entry->impulse > 0.0f)
+    {
+        float excess = Maths_Min(normalVelocity, entry->impulse);
+        normalVelocity -= excess;
+        entry->impulse -= excess;
+    }
+
+    if (isPenetrating)
+    {
+        positions[dynamicComponent] += sign * (overlaps[axis] + PHYSICS_SEPARATION_EPSILON);
+
+        if (normalVelocity < -PHYSICS_CONTACT_RESTING_VELOCITY)
+        {
+            float bounced = normalVelocity * -Maths_Max(pRestitution(staticComponent), pRestitution(dynamicComponent));
+            bounce = bounced - normalVelocity;
+            normalVelocity = bounced;
+        }
+        else if (normalVelocity < 0.0f)
+        {
+            entry->impulse -= normalVelocity;
+            normalVelocity = 0.0f;
+        }
+    }
+
+    velocities[dynamicComponent] = normalVelocity * sign;
+    PhysicsScene_ApplyFriction(staticComponent, dynamicComponent, axis, entry->impulse + bounce, 0.0f, 1.0f);
+
+    return isPenetrating;
+}
+
+/// @brief Resolve a collision between two dynamic physics components.
+/// @param contact Contact of two dynamic components.
+/// @return True if the components were penetrating, false if they were only closer than the contact distance.
+/// @note Cached like PhysicsScene_ResolveStaticVsDynamic, separations and velocity changes are split by the inverse masses so momentum is kept.
+static bool PhysicsScene_ResolveDynamicVsDynamic(const PHYSICS_CONTACT *contact)
+{
+    Entity firstComponent = contact->first;
+    Entity secondComponent = contact->second;
+    float m1 = pMass(firstComponent);
+    float m2 = pMass(secondComponent);
+    float totalInvMass = 1.0f / m1 + 1.0f / m2;
+    float share1 = (1.0f / m1) / totalInvMass;
+    float share2 = (1.0f / m2) / totalInvMass;
+
+    if (pIsRoundPair(firstComponent, secondComponent))
+    {
+        return PhysicsScene_ResolveRound(contact, share1, share2, 0.0f);
+    }
+
+    PHYSICS_CACHE_ENTRY *entry = &pCacheEntry(contact->cacheEntry);
+
+    float overlaps[3] = {contact->overlap.x, contact->overlap.y, contact->overlap.z};
+    RJ_Size axis = PhysicsCache_SelectAxis(entry, overlaps);
+    float *positions = pLanesAxis(PHYSICS.data.positions, axis);
+    float *velocities = pLanesAxis(PHYSICS.data.velocities, axis);
+    float sign = PhysicsCache_SelectSign(contact, entry, axis, positions[firstComponent] < positions[secondComponent] ? 1.0f : -1.0f);
+
+    float normalVelocity = (velocities[secondComponent] - velocities[firstComponent]) * sign;
+    float bounce = 0.0f;
+    bool isPenetrating = overlaps[axis] > 0.0f;
+
+    if (normalVelocity > 0.0f && entry->impulse > 0.0f)
+    {
+        float excess = Maths_Min(normalVelocity, entry->impulse);
+        velocities[firstComponent] += sign * excess * share1;
+        velocities[secondComponent] -= sign * excess * share2;
+        normalVelocity -= excess;
+        entry->impulse -= excess;
+    }
+
+    if (isPenetrating)
+    {
+        positions[firstComponent] -= sign * overlaps[axis] * share1;
+        positions[secondComponent] += sign * overlaps[axis] * share2;
+
+        if (normalVelocity < -PHYSICS_CONTACT_RESTING_VELOCITY)
+        {
+            // v1' = ( (m1 - e*m2)*v1 + (1+e)*m2*v2 ) / (m1+m2)
+            // v2' = ( (m2 - e*m1)*v2 + (1+e)*m1*v1 ) / (m1+m2)
+            float v1 = velocities[firstComponent];
+            float v2 = velocities[secondComponent];
+            float oneOverMassSum = 1.0f / (m1 + m2);
+            float restitution = Maths_Max(pRestitution(firstComponent), pRestitution(secondComponent));
+
+            velocities[firstComponent] = ((m1 - restitution * m2) * v1 + (1.0f + restitution) * m2 * v2) * oneOverMassSum;
+            velocities[secondComponent] = ((m2 - restitution * m1) * v2 + (1.0f + restitution) * m1 * v1) * oneOverMassSum;
+            bounce = -(1.0f + restitution) * normalVelocity;
+        }
+        else if (normalVelocity < 0.0f)
+        {
+            velocities[firstComponent] += sign * normalVelocity * share1;
+            velocities[secondComponent] -= sign * normalVelocity * share2;
+            entry->impulse -= normalVelocity;
+        }
+    }
+
+    PhysicsScene_ApplyFriction(firstComponent, secondComponent, axis, entry->impulse + bounce, share1, share2);
+
+    return isPenetrating;
+}
+
+#pragma region Integration
+
+/// @brief Points every lane column into the lane block. Columns are laneCapacity floats apart so all of them keep the block alignment.
+static void PhysicsScene_AssignLanes(void)
+{
+    float *column = PHYSICS.data.laneMemory;
+    PHYSICS_LANES *lanes[] = {&PHYSICS.data.velocities, &PHYSICS.data.colliderSizes, &PHYSICS.data.positions};
+
+    for (RJ_Size i = 0; i < sizeof(lanes) / sizeof(lanes[0]); i++)
+    {
+        lanes[i]->x = column;
+        column += PHYSICS.data.laneCapacity;
+        lanes[i]->y = column;
+        column += PHYSICS.data.laneCapacity;
+        lanes[i]->z = column;
+        column += PHYSICS.data.laneCapacity;
+    }
+
+    float **materials[] = {&PHYSICS.data.drags, &PHYSICS.data.gravityScales, &PHYSICS.data.restitutions, &PHYSICS.data.frictions};
+
+    for (RJ_Size i = 0; i < sizeof(materials) / sizeof(materials[0]); i++)
+    {
+        *materials[i] = column;
+        column += PHYSICS.data.laneCapacity;
+    }
+}
+
+/// @brief Gets the position the simulation uses for a single entity, read the same way PhysicsScene_GatherPositions reads them.
+/// @param entity Entity to read.
+/// @return Local position of a root entity, world transform cache position of an attached one.
+static inline Vector3 PhysicsScene_GetEntityPosition(Entity entity)
+{
+    return Entity_GetParent(entity) == RJ_INDEX_INVALID ? Entity_GetPosition(entity) : Entity_GetWorldPosition(entity);
+}
+
+/// @brief Copies the entity positions of a component range into the position lanes. Root entities are read from their local position, attached ones from the world transform cache.
+/// @param firstComponent First component of the range.
+/// @param componentCount Number of components in the range.
+static void PhysicsScene_GatherPositions(Entity firstComponent, RJ_Size componentCount)
+{
+    const EntitySpan *spans = Entity_GetSpans(NULL);
+
+    for (Entity component = firstComponent; component < firstComponent + componentCount; component++)
+    {
+        Entity entity = rEntity(component);
+        pSetPosition(component, EntitySpan_At(spans, parents, entity) == RJ_INDEX_INVALID ? EntitySpan_At(spans, positions, entity) : EntitySpan_At(spans, worldPositions, entity));
+    }
+}
+
+/// @brief Writes the position lanes of a component range back to their entities and marks their transforms dirty. Attached entities follow their parent, so they are not written.
+/// @param firstComponent First component of the range.
+/// @param componentCount Number of components in the range.
+static void PhysicsScene_ScatterPositions(Entity firstComponent, RJ_Size componentCount)
+{
+    const EntitySpan *spans = Entity_GetSpans(NULL);
+
+    for (Entity component = firstComponent; component < firstComponent + componentCount; component++)
+    {
+        Entity entity = rEntity(component);
+
+        if (EntitySpan_At(spans, parents, entity) == RJ_INDEX_INVALID)
+        {
+            EntitySpan_At(spans, positions, entity) = pPosition(component);
+            EntitySpan_At(spans, isDirty, entity) = true;
+        }
+    }
+}
+
+/// @brief Integrates a single component with its own drag and gravity scale. Shared by every kernel for the unaligned head and tail so all of them produce identical results.
+/// @param component Component to integrate.
+/// @param gravityStep Gravity multiplied by the delta time.
+/// @param deltaTime Time step.
+static inline void PhysicsKernel_IntegrateOne(RJ_Size component, float gravityStep, float deltaTime)
+{
+    float dragFactor = 1.0f - pDrag(component);
+
+    pVelocityX(component) = pVelocityX(component) * dragFactor;
+    pVelocityY(component) = (pVelocityY(component) + gravityStep * pGravityScale(component)) * dragFactor;
+    pVelocityZ(component) = pVelocityZ(component) * dragFactor;
+
+    pPositionX(component) = pPositionX(component) + pVelocityX(component) * deltaTime;
+    pPositionY(component) = pPositionY(component) + pVelocityY(component) * deltaTime;
+    pPositionZ(component) = pPositionZ(component) + pVelocityZ(component) * deltaTime;
+}
+
+/// @brief Runs a wrapped task with its world bound to the running thread.
+static void PhysicsWorld_RunTask(void *userData, RJ_Size taskIndex, RJ_Size first, RJ_Size count)
+{
+    const PHYSICS_TASK *task = (const PHYSICS_TASK *)userData;
+
+    PHYSICS_WORLD = task->world;
+    task->task(task->userData, taskIndex, first, count);
+}
+
+/// @brief Runs a task on the thread pool of the bound world, see ThreadPool_ParallelFor.
+/// @param itemCount Number of items to split.
+/// @param granularity Ranges are multiples of this many items except the last one.
+/// @param task Task to run for every range, runs with the world bound.
+/// @param userData User data passed to the task.
+static void PhysicsWorld_ParallelFor(RJ_Size itemCount, RJ_Size granularity, ThreadPoolTask task, void *userData)
+{
+    PHYSICS_TASK wrapped = {.world = PHYSICS_WORLD, .task = task, .userData = userData};
+
+    ThreadPool_ParallelFor(PHYSICS.threadPool, itemCount, granularity, PhysicsWorld_RunTask, &wrapped);
+}
+
+/// @brief Integration task, gathers, integrates and scatters a range of the awake components.
+static void PhysicsKernel_IntegrateTask(void *userData, RJ_Size taskIndex, RJ_Size firstDynamic, RJ_Size dynamicCount)
+{
+    (void)taskIndex;
+    float deltaTime = *(const float *)userData;
+    Entity firstComponent = PHYSICS.data.awakeStart + firstDynamic;
+
+    PhysicsScene_GatherPositions(firstComponent, dynamicCount);
+    PHYSICS.kernels.integrate(firstComponent, dynamicCount, PHYSICS.properties.gravity * deltaTime, deltaTime);
+    PhysicsScene_ScatterPositions(firstComponent, dynamicCount);
+}
+
+/// @brief Portable integration kernel, used when no vector instruction set is available.
+static void PhysicsKernel_IntegrateScalar(RJ_Size firstComponent, RJ_Size componentCount, float gravityStep, float deltaTime)
+{
+    for (RJ_Size component = firstComponent; component < firstComponent + componentCount; component++)
+    {
+        PhysicsKernel_IntegrateOne(component, gravityStep, deltaTime);
+    }
+}
+
+#if RJ_ARCHITECTURE == RJ_ARCHITECTURE_X64 && !PHYSICS_FORCE_SCALAR
+
+/// @brief SSE integration kernel, 4 components per iteration. SSE2 is part of the x64 baseline so it is always available.
+static void PhysicsKernel_IntegrateSSE(RJ_Size firstComponent, RJ_Size componentCount, float gravityStep, float deltaTime)
+{
+    RJ_Size component = firstComponent;
+    RJ_Size end = firstComponent + componentCount;
+
+    for (; component < end && component % 4 != 0; component++)
+    {
+        PhysicsKernel_IntegrateOne(component, gravityStep, deltaTime);
+    }
+
+    __m128 gravityStepWide = _mm_set1_ps(gravityStep);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 step = _mm_set1_ps(deltaTime);
+
+    for (; component + 4 <= end; component += 4)
+    {
+        __m128 gravity = _mm_mul_ps(gravityStepWide, _mm_load_ps(&pGravityScale(component)));
+        __m128 drag = _mm_sub_ps(one, _mm_load_ps(&pDrag(component)));
+
+        __m128 velocityX = _mm_mul_ps(_mm_load_ps(&pVelocityX(component)), drag);
+        __m128 velocityY = _mm_mul_ps(_mm_add_ps(_mm_load_ps(&pVelocityY(component)), gravity), drag);
+        __m128 velocityZ = _mm_mul_ps(_mm_load_ps(&pVelocityZ(component)), drag);
+
+        _mm_store_ps(&pVelocityX(component), velocityX);
+        _mm_store_ps(&pVelocityY(component), velocityY);
+        _mm_store_ps(&pVelocityZ(component), velocityZ);
+
+        _mm_store_ps(&pPositionX(component), _mm_add_ps(_mm_load_ps(&pPositionX(component)), _mm_mul_ps(velocityX, step)));
+        _mm_store_ps(&pPositionY(component), _mm_add_ps(_mm_load_ps(&pPositionY(component)), _mm_mul_ps(velocityY, step)));
+        _mm_store_ps(&pPositionZ(component), _mm_add_ps(_mm_load_ps(&pPositionZ(component)), _mm_mul_ps(velocityZ, step)));
+    }
+
+    for (; component < end; component++)
+    {
+        PhysicsKernel_IntegrateOne(component, gravityStep, deltaTime);
+    }
+}
+
+/// @brief AVX2 integration kernel, 8 components per iteration. Compiled for AVX2 regardless of the global flags and only selected if the CPU supports it.
+__attribute__((target("avx2"))) static void PhysicsKernel_IntegrateAVX2(RJ_Size firstComponent, RJ_Size componentCount, float gravityStep, float deltaTime)
+{
+    RJ_Size component = firstComponent;
+    RJ_Size end = firstComponent + componentCount;
+
+    for (; component < end && component % PHYSICS_LANE_WIDTH != 0; component++)
+    {
+        PhysicsKernel_IntegrateOne(component, gravityStep, deltaTime);
+    }
+
+    __m256 gravityStepWide = _mm256_set1_ps(gravityStep);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 step = _mm256_set1_ps(deltaTime);
+
+    for (; component + PHYSICS_LANE_WIDTH <= end; component += PHYSICS_LANE_WIDTH)
+    {
+        __m256 gravity = _mm256_mul_ps(gravityStepWide, _mm256_load_ps(&pGravityScale(component)));
+        __m256 drag = _mm256_sub_ps(one, _mm256_load_ps(&pDrag(component)));
+
+        __m256 velocityX = _mm256_mul_ps(_mm256_load_ps(&pVelocityX(component)), drag);
+        __m256 velocityY = _mm256_mul_ps(_mm256_add_ps(_mm256_load_ps(&pVelocityY(component)), gravity), drag);
+        __m256 velocityZ = _mm256_mul_ps(_mm256_load_ps(&pVelocityZ(component)), drag);
+
+        _mm256_store_ps(&pVelocityX(component), velocityX);
+        _mm256_store_ps(&pVelocityY(component), velocityY);
+        _mm256_store_ps(&pVelocityZ(component), velocityZ);
+
+        // multiply and add are kept separate instead of fused so the results match the scalar kernel bit by bit
+        _mm256_store_ps(&pPositionX(component), _mm256_add_ps(_mm256_load_ps(&pPositionX(component)), _mm256_mul_ps(velocityX, step)));
+        _mm256_store_ps(&pPositionY(component), _mm256_add_ps(_mm256_load_ps(&pPositionY(component)), _mm256_mul_ps(velocityY, step)));
+        _mm256_store_ps(&pPositionZ(component), _mm256_add_ps(_mm256_load_ps(&pPositionZ(component)), _mm256_mul_ps(velocityZ, step)));
+    }
+
+    for (; component < end; component++)
+    {
+        PhysicsKernel_IntegrateOne(component, gravityStep, deltaTime);
+    }
+}
+
+#endif
+
+#pragma endregion Integration
+
+#pragma region Partitions
+
+/// @brief Swaps every data of two components and fixes the entity maps. Used to keep the partitions continuous.
+/// @param firstComponent First component.
+/// @param secondComponent Second component.
+static void PhysicsScene_SwapComponents(Entity firstComponent, Entity secondComponent)
+{
+    if (firstComponent == secondComponent)
+    {
+        return;
+    }
+
+    Entity firstEntity = rEntity(firstComponent);
+    Entity secondEntity = rEntity(secondComponent);
+
+    Vector3 tempVector = pVelocity(firstComponent);
+    pSetVelocity(firstComponent, pVelocity(secondComponent));
+    pSetVelocity(secondComponent, tempVector);
+
+    tempVector = pColliderSize(firstComponent);
+    pSetColliderSize(firstComponent, pColliderSize(secondComponent));
+    pSetColliderSize(secondComponent, tempVector);
+
+    tempVector = pPosition(firstComponent);
+    pSetPosition(firstComponent, pPosition(secondComponent));
+    pSetPosition(secondComponent, tempVector);
+
+    float tempMaterials[4] = {pDrag(firstComponent), pGravityScale(firstComponent), pRestitution(firstComponent), pFriction(firstComponent)};
+    pDrag(firstComponent) = pDrag(secondComponent);
+    pGravityScale(firstComponent) = pGravityScale(secondComponent);
+    pRestitution(firstComponent) = pRestitution(secondComponent);
+    pFriction(firstComponent) = pFriction(secondComponent);
+    pDrag(secondComponent) = tempMaterials[0];
+    pGravityScale(secondComponent) = tempMaterials[1];
+    pRestitution(secondComponent) = tempMaterials[2];
+    pFriction(secondComponent) = tempMaterials[3];
+
+    float tempMass = pMass(firstComponent);
+    pMass(firstComponent) = pMass(secondComponent);
+    pMass(secondComponent) = tempMass;
+
+    uint8_t tempFlag = pFlag(firstComponent);
+    pFlag(firstComponent) = pFlag(secondComponent);
+    pFlag(secondComponent) = tempFlag;
+
+    uint32_t tempLayer = pLayer(firstComponent);
+    pLayer(firstComponent) = pLayer(secondComponent);
+    pLayer(secondComponent) = tempLayer;
+
+    uint32_t tempMask = pMask(firstComponent);
+    pMask(firstComponent) = pMask(secondComponent);
+    pMask(secondComponent) = tempMask;
+
+    PHYSICS_BOUNDS tempBounds = pBounds(firstComponent);
+    pBounds(firstComponent) = pBounds(secondComponent);
+    pBounds(secondComponent) = tempBounds;
+
+    uint16_t tempRestSteps = PHYSICS.sleep.restSteps[firstComponent];
+    PHYSICS.sleep.restSteps[firstComponent] = PHYSICS.sleep.restSteps[secondComponent];
+    PHYSICS.sleep.restSteps[secondComponent] = tempRestSteps;
+
+    RJ_Size tempIslandId = PHYSICS.sleep.islandIds[firstComponent];
+    PHYSICS.sleep.islandIds[firstComponent] = PHYSICS.sleep.islandIds[secondComponent];
+    PHYSICS.sleep.islandIds[secondComponent] = tempIslandId;
+
+    rEntity(firstComponent) = secondEntity;
+    rEntity(secondComponent) = firstEntity;
+
+    if (firstEntity != RJ_INDEX_INVALID)
+    {
+        rComponent(firstEntity) = secondComponent;
+    }
+
+    if (secondEntity != RJ_INDEX_INVALID)
+    {
+        rComponent(secondEntity) = firstComponent;
+    }
+}
+
+/// @brief Gets the partition a component is in from its index.
+/// @param component Component to check.
+/// @return Partition of the component.
+static inline PHYSICS_PARTITION PhysicsScene_GetPartition(Entity component)
+{
+    if (component < PHYSICS.data.staticCount)
+    {
+        return PHYSICS_PARTITION_STATIC;
+    }
+
+    return component < PHYSICS.data.awakeStart ? PHYSICS_PARTITION_SLEEPING : PHYSICS_PARTITION_AWAKE;
+}
+
+/// @brief Moves a component to another partition by swapping it across the partition boundaries one at a time. Other components of the passed partitions may move.
+/// @param component Component to move.
+/// @param partition Target partition.
+/// @return New index of the component.
+static Entity PhysicsScene_MoveToPartition(Entity component, PHYSICS_PARTITION partition)
+{
+    PHYSICS_PARTITION current = PhysicsScene_GetPartition(component);
+
+    if (current == partition)
+    {
+        return component;
+    }
+
+    for (; current < partition; current++)
+    {
+        if (current == PHYSICS_PARTITION_STATIC)
+        {
+            PhysicsScene_SwapComponents(component, --PHYSICS.data.staticCount);
+            component = PHYSICS.data.staticCount;
+        }
+        else
+        {
+            PhysicsScene_SwapComponents(component, --PHYSICS.data.awakeStart);
+            component = PHYSICS.data.awakeStart;
+        }
+    }
+
+    for (; current > partition; current--)
+    {
+        if (current == PHYSICS_PARTITION_AWAKE)
+        {
+            PhysicsScene_SwapComponents(component, PHYSICS.data.awakeStart++);
+            component = PHYSICS.data.awakeStart - 1;
+        }
+        else
+        {
+            PhysicsScene_SwapComponents(component, PHYSICS.data.staticCount++);
+            component = PHYSICS.data.staticCount - 1;
+        }
+    }
+
+    PHYSICS.sleep.isSleepingDirty = true;
+    PHYSICS.broadphase.sweep.isDirty = true;
+
+    return component;
+}
+
+#pragma endregion Partitions
+
+#pragma region Broadphase
+
+/// @brief Computes the world space bounds of the given components from their position lanes and collider sizes.
+/// @param firstComponent First component of the range.
+/// @param componentCount Number of components in the range.
+static void PhysicsScene_UpdateBounds(Entity firstComponent, RJ_Size componentCount)
+{
+    for (Entity component = firstComponent; component < firstComponent + componentCount; component++)
+    {
+        Vector3 position = pPosition(component);
+        Vector3 halfSize = Vector3G_Scale(pColliderSize(component), 0.5f);
+
+        halfSize = Vector3G_Sum(halfSize, Vector3_NewN(PHYSICS_BROADPHASE_MARGIN));
+
+        pBounds(component).min = Vector3G_Sum(position, Vector3G_Scale(halfSize, -1.0f));
+        pBounds(component).max = Vector3G_Sum(position, halfSize);
+    }
+}
+
+/// @brief Checks whether two components collide with each other's layer. Tested before the bounds so filtered pairs cost two loads.
+/// @param firstComponent First component.
+/// @param secondComponent Second component.
+/// @return True if the layer of each component is in the mask of the other one.
+static inline bool PhysicsScene_CanPair(Entity firstComponent, Entity secondComponent)
+{
+    return (pLayer(firstComponent) & pMask(secondComponent)) != 0 && (pLayer(secondComponent) & pMask(firstComponent)) != 0;
+}
+
+/// @brief Checks whether the bounds of two components overlap.
+/// @param firstComponent First component.
+/// @param secondComponent Second component.
+/// @return True if the bounds overlap on all axes.
+static inline bool PhysicsScene_BoundsOverlap(Entity firstComponent, Entity secondComponent)
+{
+    return pBounds(firstComponent).min.x < pBounds(secondComponent).max.x && pBounds(secondComponent).min.x < pBounds(firstComponent).max.x &&
+           pBounds(firstComponent).min.y < pBounds(secondComponent).max.y && pBounds(secondComponent).min.y < pBounds(firstComponent).max.y &&
+           pBounds(firstComponent).min.z < pBounds(secondComponent).max.z && pBounds(secondComponent).min.z < pBounds(firstComponent).max.z;
+}
+
+/// @brief Appends a candidate pair to a pair list.
+/// @param list List to append to.
+/// @param firstComponent First component of the pair.
+/// @param secondComponent Second component of the pair.
+static inline void PhysicsScene_AddPair(PHYSICS_PAIR_LIST *list, Entity firstComponent, Entity secondComponent)
+{
+    if (!pReserve(PHYSICS_PAIR, list->pairs, list->capacity, list->count + 1))
+    {
+        PHYSICS.droppedCount++;
+        return;
+    }
+
+    list->pairs[list->count++] = (PHYSICS_PAIR){firstComponent, secondComponent};
+}
+
+/// @brief Converts a world space coordinate to a grid cell coordinate.
+/// @param grid Grid to use the cell size of.
+/// @param value World space coordinate.
+/// @return Cell coordinate on the same axis, clamped to PHYSICS_GRID_MAX_CELL.
+static inline int32_t PhysicsGrid_Cell(const PHYSICS_GRID *grid, float value)
+{
+    float cell = floorf(value * grid->inverseCellSize);
+
+    // written so NaN goes to the lower border too, casting it or an out of range value is undefined
+    if (!(cell > (float)-PHYSICS_GRID_MAX_CELL))
+    {
+        return -PHYSICS_GRID_MAX_CELL;
+    }
+
+    return cell < (float)PHYSICS_GRID_MAX_CELL ? (int32_t)cell : PHYSICS_GRID_MAX_CELL;
+}
+
+/// @brief Hashes a cell coordinate to a bucket of the grid.
+/// @param grid Grid to hash the cell for.
+/// @param cellX Cell coordinate on x axis.
+/// @param cellY Cell coordinate on y axis.
+/// @param cellZ Cell coordinate on z axis.
+/// @return Bucket index of the cell.
+static inline RJ_Size PhysicsGrid_Hash(const PHYSICS_GRID *grid, int32_t cellX, int32_t cellY, int32_t cellZ)
+{
+    return (((uint32_t)cellX * 73856093u) ^ ((uint32_t)cellY * 19349663u) ^ ((uint32_t)cellZ * 83492791u)) & (grid->bucketCount - 1);
+}
+
+/// @brief Calculates how many cells the bounds of a component covers.
+/// @param grid Grid to use the cell size of.
+/// @param component Component to calculate for.
+/// @return Covered cell count, saturated to avoid overflows for huge colliders. Every axis counts at most PHYSICS_GRID_MAX_CELLS_PER_COMPONENT + 1 cells, so oversized components stay above the limit.
+static inline uint64_t PhysicsGrid_CellCount(const PHYSICS_GRID *grid, Entity component)
+{
+    const int64_t maxExtent = PHYSICS_GRID_MAX_CELLS_PER_COMPONENT + 1;
+
+    int64_t extentX = (int64_t)PhysicsGrid_Cell(grid, pBounds(component).max.x) - PhysicsGrid_Cell(grid, pBounds(component).min.x) + 1;
+    int64_t extentY = (int64_t)PhysicsGrid_Cell(grid, pBounds(component).max.y) - PhysicsGrid_Cell(grid, pBounds(component).min.y) + 1;
+    int64_t extentZ = (int64_t)PhysicsGrid_Cell(grid, pBounds(component).max.z) - PhysicsGrid_Cell(grid, pBounds(component).min.z) + 1;
+
+    return (uint64_t)Maths_Min(extentX, maxExtent) * (uint64_t)Maths_Min(extentY, maxExtent) * (uint64_t)Maths_Min(extentZ, maxExtent);
+}
+
+/// @brief Derives the cell size of the grid from the collider sizes of the given components.
+/// @param firstComponent First component of the range.
+/// @param componentCount Number of components in the range.
+/// @return Average largest collider extent scaled with PHYSICS_GRID_CELL_SIZE_MULTIPLIER.
+static float PhysicsGrid_CalculateCellSize(Entity firstComponent, RJ_Size componentCount)
+{
+    float extentSum = 0.0f;
+
+    for (Entity component = firstComponent; component < firstComponent + componentCount; component++)
+    {
+        extentSum += Maths_Max(pColliderSizeX(component), Maths_Max(pColliderSizeY(component), pColliderSizeZ(component)));
+    }
+
+    float cellSize = componentCount > 0 ? extentSum / (float)componentCount * PHYSICS_GRID_CELL_SIZE_MULTIPLIER : 0.0f;
+
+    return cellSize > PHYSICS_SEPARATION_EPSILON ? cellSize : 1.0f;
+}
+
+/// @brief Inserts a range of components to the grid. Bounds of the components must be up to date.
+/// @param grid Grid to build.
+/// @param firstComponent First component of the range.
+/// @param componentCount Number of components in the range.
+/// @return True if every component was inserted, false if a buffer could not grow and some were left out.
+static bool PhysicsGrid_Build(PHYSICS_GRID *grid, Entity firstComponent, RJ_Size componentCount)
+{
+    bool isComplete = true;
+
+    grid->cellSize = PhysicsGrid_CalculateCellSize(firstComponent, componentCount);
+    grid->inverseCellSize = 1.0f / grid->cellSize;
+    grid->oversizedCount = 0;
+    grid->extent = (PHYSICS_BOUNDS){Vector3_NewN(FLT_MAX), Vector3_NewN(-FLT_MAX)};
+
+    RJ_Size entryCount = 0;
+    RJ_Size griddedCount = 0;
+
+    for (Entity component = firstComponent; component < firstComponent + componentCount; component++)
+    {
+        uint64_t cellCount = PhysicsGrid_CellCount(grid, component);
+
+        PHYSICS.broadphase.isOversized[component] = cellCount > PHYSICS_GRID_MAX_CELLS_PER_COMPONENT;
+
+        if (PHYSICS.broadphase.isOversized[component])
+        {
+            if (!pReserve(Entity, grid->oversized, grid->oversizedCapacity, grid->oversizedCount + 1))
+            {
+                // still marked oversized, so the insert passes skip it too
+                PHYSICS.droppedCount++;
+                isComplete = false;
+                continue;
+            }
+
+            grid->oversized[grid->oversizedCount++] = component;
+        }
+        else
+        {
+            entryCount += (RJ_Size)cellCount;
+            griddedCount++;
+
+            grid->extent.min = Vector3_New(Maths_Min(grid->extent.min.x, pBounds(component).min.x),
+                                           Maths_Min(grid->extent.min.y, pBounds(component).min.y),
+                                           Maths_Min(grid->extent.min.z, pBounds(component).min.z));
+            grid->extent.max = Vector3_New(Maths_Max(grid->extent.max.x, pBounds(component).max.x),
+                                           Maths_Max(grid->extent.max.y, pBounds(component).max.y),
+                                           Maths_Max(grid->extent.max.z, pBounds(component).max.z));
+        }
+    }
+
+    grid->bucketCount = 1;
+    while (grid->bucketCount < entryCount)
+    {
+        grid->bucketCount <<= 1;
+    }
+
+    if (!pReserve(RJ_Size, grid->bucketStarts, grid->bucketCapacity, grid->bucketCount + 1) ||
+        !pReserve(PHYSICS_GRID_ENTRY, grid->entries, grid->entryCapacity, entryCount))
+    {
+        // an empty grid is never hashed into, only the oversized components are kept
+        PHYSICS.droppedCount += griddedCount;
+        grid->bucketCount = 0;
+        grid->entryCount = 0;
+        return false;
+    }
+
+    memset(grid->bucketStarts, 0, sizeof(RJ_Size) * (grid->bucketCount + 1));
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (Entity component = firstComponent; component < firstComponent + componentCount; component++)
+        {
+            if (PHYSICS.broadphase.isOversized[component])
+            {
+                continue;
+            }
+
+            int32_t minX = PhysicsGrid_Cell(grid, pBounds(component).min.x);
+            int32_t minY = PhysicsGrid_Cell(grid, pBounds(component).min.y);
+            int32_t minZ = PhysicsGrid_Cell(grid, pBounds(component).min.z);
+            int32_t maxX = PhysicsGrid_Cell(grid, pBounds(component).max.x);
+            int32_t maxY = PhysicsGrid_Cell(grid, pBounds(component).max.y);
+            int32_t maxZ = PhysicsGrid_Cell(grid, pBounds(component).max.z);
+
+            for (int32_t cellX = minX; cellX <= maxX; cellX++)
+            {
+                for (int32_t cellY = minY; cellY <= maxY; cellY++)
+                {
+                    for (int32_t cellZ = minZ; cellZ <= maxZ; cellZ++)
+                    {
+                        RJ_Size bucket = PhysicsGrid_Hash(grid, cellX, cellY, cellZ);
+
+                        if (pass == 0)
+                        {
+                            grid->bucketStarts[bucket + 1]++;
+                        }
+                        else
+                        {
+                            grid->entries[grid->bucketStarts[bucket]++] = (PHYSICS_GRID_ENTRY){cellX, cellY, cellZ, component};
+                        }
+                    }
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (RJ_Size bucket = 0; bucket < grid->bucketCount; bucket++)
+            {
+                grid->bucketStarts[bucket + 1] += grid->bucketStarts[bucket];
+            }
+        }
+    }
+
+    // scatter pass moved every start to the start of the next bucket, shift them back
+    memmove(grid->bucketStarts + 1, grid->bucketStarts, sizeof(RJ_Size) * grid->bucketCount);
+    grid->bucketStarts[0] = 0;
+
+    grid->entryCount = entryCount;
+    return isComplete;
+}
+
+/// @brief Emits every overlapping pair inside the grid exactly once. A pair is only emitted from the cell that contains the minimum corner of the intersection of the two bounds, so pairs sharing multiple cells or hash collisions do not produce duplicates.
+/// @param grid Grid to collect the pairs from.
+/// @param list List to append the pairs to.
+static void PhysicsGrid_CollectPairs(const PHYSICS_GRID *grid, PHYSICS_PAIR_LIST *list)
+{
+    for (RJ_Size bucket = 0; bucket < grid->bucketCount; bucket++)
+    {
+        for (RJ_Size first = grid->bucketStarts[bucket]; first < grid->bucketStarts[bucket + 1]; first++)
+        {
+            const PHYSICS_GRID_ENTRY *firstEntry = &grid->entries[first];
+
+            for (RJ_Size second = first + 1; second < grid->bucketStarts[bucket + 1]; second++)
+            {
+                const PHYSICS_GRID_ENTRY *secondEntry = &grid->entries[second];
+
+                if (firstEntry->cellX != secondEntry->cellX ||
+                    firstEntry->cellY != secondEntry->cellY ||
+                    firstEntry->cellZ != secondEntry->cellZ ||
+                    !PhysicsScene_CanPair(firstEntry->component, secondEntry->component) ||
+                    !PhysicsScene_BoundsOverlap(firstEntry->component, secondEntry->component))
+                {
+                    continue;
+                }
+
+                if (PhysicsGrid_Cell(grid, Maths_Max(pBounds(firstEntry->component).min.x, pBounds(secondEntry->component).min.x)) != firstEntry->cellX ||
+                    PhysicsGrid_Cell(grid, Maths_Max(pBounds(firstEntry->component).min.y, pBounds(secondEntry->component).min.y)) != firstEntry->cellY ||
+                    PhysicsGrid_Cell(grid, Maths_Max(pBounds(firstEntry->component).min.z, pBounds(secondEntry->component).min.z)) != firstEntry->cellZ)
+                {
+                    continue;
+                }
+
+                PhysicsScene_AddPair(list, firstEntry->component, secondEntry->component);
+            }
+        }
+    }
+}
+
+/// @brief Emits the pairs of oversized components which are not inserted to the grid, by testing them against every component in the range.
+/// @param grid Grid holding the oversized components.
+/// @param firstComponent First component of the range the grid is built with.
+/// @param componentCount Number of components in the range.
+/// @param list List to append the pairs to.
+static void PhysicsGrid_CollectOversizedPairs(const PHYSICS_GRID *grid, Entity firstComponent, RJ_Size componentCount, PHYSICS_PAIR_LIST *list)
+{
+    for (RJ_Size oversized = 0; oversized < grid->oversizedCount; oversized++)
+    {
+        Entity oversizedComponent = grid->oversized[oversized];
+
+        for (Entity component = firstComponent; component < firstComponent + componentCount; component++)
+        {
+            // pairs of two oversized components are emitted once, from the smaller one
+            if (component == oversizedComponent ||
+                (PHYSICS.broadphase.isOversized[component] && component < oversizedComponent) ||
+                !PhysicsScene_CanPair(oversizedComponent, component) ||
+                !PhysicsScene_BoundsOverlap(oversizedComponent, component))
+            {
+                continue;
+            }
+
+            PhysicsScene_AddPair(list, oversizedComponent, component);
+        }
+    }
+}
+
+/// @brief Emits the pairs between a range of components and the components inside another grid by querying the cells each component covers. Used to test dynamic components against the static grid.
+/// @param grid Grid to query.
+/// @param firstComponent First component of the querying range.
+/// @param componentCount Number of components in the querying range.
+/// @param list List to append the pairs to, grid components are written as the first of the pair.
+static void PhysicsGrid_CollectQueryPairs(const PHYSICS_GRID *grid, Entity firstComponent, RJ_Size componentCount, PHYSICS_PAIR_LIST *list)
+{
+    for (Entity component = firstComponent; component < firstComponent + componentCount; component++)
+    {
+        for (RJ_Size oversized = 0; oversized < grid->oversizedCount; oversized++)
+        {
+            if (PhysicsScene_CanPair(grid->oversized[oversized], component) && PhysicsScene_BoundsOverlap(grid->oversized[oversized], component))
+            {
+                PhysicsScene_AddPair(list, grid->oversized[oversized], component);
+            }
+        }
+
+        if (grid->entryCount == 0)
+        {
+            continue;
+        }
+
+        int32_t minX = PhysicsGrid_Cell(grid, pBounds(component).min.x);
+        int32_t minY = PhysicsGrid_Cell(grid, pBounds(component).min.y);
+        int32_t minZ = PhysicsGrid_Cell(grid, pBounds(component).min.z);
+        int32_t maxX = PhysicsGrid_Cell(grid, pBounds(component).max.x);
+        int32_t maxY = PhysicsGrid_Cell(grid, pBounds(component).max.y);
+        int32_t maxZ = PhysicsGrid_Cell(grid, pBounds(component).max.z);
+
+        for (int32_t cellX = minX; cellX <= maxX; cellX++)
+        {
+            for (int32_t cellY = minY; cellY <= maxY; cellY++)
+            {
+                for (int32_t cellZ = minZ; cellZ <= maxZ; cellZ++)
+                {
+                    RJ_Size bucket = PhysicsGrid_Hash(grid, cellX, cellY, cellZ);
+
+                    for (RJ_Size entry = grid->bucketStarts[bucket]; entry < grid->bucketStarts[bucket + 1]; entry++)
+                    {
+                        const PHYSICS_GRID_ENTRY *gridEntry = &grid->entries[entry];
+
+                        if (gridEntry->cellX != cellX ||
+                            gridEntry->cellY != cellY ||
+                            gridEntry->cellZ != cellZ ||
+                            !PhysicsScene_CanPair(gridEntry->component, component) ||
+                            !PhysicsScene_BoundsOverlap(gridEntry->component, component))
+                        {
+                            continue;
+                        }
+
+                        if (PhysicsGrid_Cell(grid, Maths_Max(pBounds(gridEntry->component).min.x, pBounds(component).min.x)) != cellX ||
+                            PhysicsGrid_Cell(grid, Maths_Max(pBounds(gridEntry->component).min.y, pBounds(component).min.y)) != cellY ||
+                            PhysicsGrid_Cell(grid, Maths_Max(pBounds(gridEntry->component).min.z, pBounds(component).min.z)) != cellZ)
+                        {
+                            continue;
+                        }
+
+                        PhysicsScene_AddPair(list, gridEntry->component, component);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// @brief Grows the arrays of the sweep. The endpoint capacity is shared by the axes, so it only grows once every axis did.
+/// @param sweep Sweep to grow.
+/// @param endpointCount Number of endpoints on every axis.
+/// @param activeCount Number of components that can be active at once.
+/// @param activeIndexCount Number of components indexed by the active indices.
+/// @return True if every array holds the required count.
+static bool PhysicsSweep_Reserve(PHYSICS_SWEEP *sweep, RJ_Size endpointCount, RJ_Size activeCount, RJ_Size activeIndexCount)
+{
+    RJ_Size endpointCapacity = 0;
+    bool isReserved = true;
+
+    for (RJ_Size axis = 0; axis < 3; axis++)
+    {
+        RJ_Size axisCapacity = sweep->endpointCapacity;
+
+        if (pReserve(PHYSICS_ENDPOINT, sweep->endpoints[axis], axisCapacity, endpointCount))
+        {
+            endpointCapacity = axisCapacity;
+        }
+        else
+        {
+            isReserved = false;
+        }
+    }
+
+    if (isReserved)
+    {
+        sweep->endpointCapacity = endpointCapacity;
+    }
+
+    return isReserved &&
+           pReserve(Entity, sweep->active, sweep->activeCapacity, activeCount) &&
+           pReserve(RJ_Size, sweep->activeIndices, sweep->activeIndexCapacity, activeIndexCount);
+}
+
+/// @brief Recreates the endpoint arrays of the sweep for a range of components. Called only when the component set changes.
+/// @param sweep Sweep to rebuild.
+/// @param firstComponent First component of the range.
+/// @param componentCount Number of components in the range.
+static void PhysicsSweep_Rebuild(PHYSICS_SWEEP *sweep, Entity firstComponent, RJ_Size componentCount)
+{
+    if (!PhysicsSweep_Reserve(sweep, componentCount * 2, componentCount, firstComponent + componentCount))
+    {
+        // stays dirty so the next step tries again, no pair is collected until then
+        PHYSICS.droppedCount += componentCount;
+        sweep->endpointCount = 0;
+        sweep->isDirty = true;
+        return;
+    }
+
+    for (RJ_Size axis = 0; axis < 3; axis++)
+    {
+        for (RJ_Size index = 0; index < componentCount; index++)
+        {
+            sweep->endpoints[axis][index * 2] = (PHYSICS_ENDPOINT){0.0f, (firstComponent + index) << 1};
+            sweep->endpoints[axis][index * 2 + 1] = (PHYSICS_ENDPOINT){0.0f, ((firstComponent + index) << 1) | 1};
+        }
+    }
+
+    sweep->endpointCount = componentCount * 2;
+    sweep->isDirty = false;
+}
+
+/// @brief Sorts the endpoints of an axis with insertion sort. Runs close to linear time when the order is almost the same as the previous frame.
+/// @param endpoints Endpoints of an axis.
+/// @param endpointCount Number of endpoints.
+static void PhysicsSweep_SortAxis(PHYSICS_ENDPOINT *endpoints, RJ_Size endpointCount)
+{
+    for (RJ_Size index = 1; index < endpointCount; index++)
+    {
+        PHYSICS_ENDPOINT endpoint = endpoints[index];
+        RJ_Size target = index;
+
+        while (target > 0 && endpoints[target - 1].value > endpoint.value)
+        {
+            endpoints[target] = endpoints[target - 1];
+            target--;
+        }
+
+        endpoints[target] = endpoint;
+    }
+}
+
+/// @brief Compares two endpoints by their values, used to fully sort the endpoints after a rebuild.
+/// @param first First endpoint.
+/// @param second Second endpoint.
+/// @return Negative, zero or positive like strcmp.
+static int PhysicsSweep_CompareEndpoints(const void *first, const void *second)
+{
+    float firstValue = ((const PHYSICS_ENDPOINT *)first)->value;
+    float secondValue = ((const PHYSICS_ENDPOINT *)second)->value;
+
+    return (firstValue > secondValue) - (firstValue < secondValue);
+}
+
+/// @brief Refreshes and re-sorts the endpoints, then sweeps the axis with the largest spread and emits the pairs whose bounds overlap.
+/// @param sweep Sweep to update.
+/// @param firstComponent First component of the range.
+/// @param componentCount Number of components in the range.
+/// @param list List to append the pairs to.
+static void PhysicsSweep_CollectPairs(PHYSICS_SWEEP *sweep, Entity firstComponent, RJ_Size componentCount, PHYSICS_PAIR_LIST *list)
+{
+    bool isRebuilt = sweep->isDirty || sweep->endpointCount != componentCount * 2;
+
+    if (isRebuilt)
+    {
+        PhysicsSweep_Rebuild(sweep, firstComponent, componentCount);
+    }
+
+    float spreads[3] = {0.0f, 0.0f, 0.0f};
+
+    for (RJ_Size axis = 0; axis < 3; axis++)
+    {
+        float sum = 0.0f;
+        float squareSum = 0.0f;
+
+        for (RJ_Size index = 0; index < sweep->endpointCount; index++)
+        {
+            PHYSICS_ENDPOINT *endpoint = &sweep->endpoints[axis][index];
+            const float *bound = (endpoint->data & 1) ? (const float *)&pBounds(endpoint->data >> 1).max : (const float *)&pBounds(endpoint->data >> 1).min;
+
+            endpoint->value = bound[axis];
+            sum += endpoint->value;
+            squareSum += endpoint->value * endpoint->value;
+        }
+
+        spreads[axis] = sweep->endpointCount > 0 ? squareSum - sum * sum / (float)sweep->endpointCount : 0.0f;
+
+        if (isRebuilt)
+        {
+            qsort(sweep->endpoints[axis], sweep->endpointCount, sizeof(PHYSICS_ENDPOINT), PhysicsSweep_CompareEndpoints);
+        }
+        else
+        {
+            PhysicsSweep_SortAxis(sweep->endpoints[axis], sweep->endpointCount);
+        }
+    }
+
+    RJ_Size sweepAxis = spreads[0] >= spreads[1] && spreads[0] >= spreads[2] ? 0 : (spreads[1] >= spreads[2] ? 1 : 2);
+
+    sweep->activeCount = 0;
+
+    for (RJ_Size index = 0; index < sweep->endpointCount; index++)
+    {
+        PHYSICS_ENDPOINT endpoint = sweep->endpoints[sweepAxis][index];
+        Entity component = endpoint.data >> 1;
+
+        if (endpoint.data & 1)
+        {
+            Entity lastActive = sweep->active[--sweep->activeCount];
+            sweep->active[sweep->activeIndices[component]] = lastActive;
+            sweep->activeIndices[lastActive] = sweep->activeIndices[component];
+            continue;
+        }
+
+        for (RJ_Size active = 0; active < sweep->activeCount; active++)
+        {
+            Entity activeComponent = sweep->active[active];
+
+            if (PhysicsScene_CanPair(activeComponent, component) && PhysicsScene_BoundsOverlap(activeComponent, component))
+            {
+                PhysicsScene_AddPair(list, activeComponent, component);
+            }
+        }
+
+        sweep->activeIndices[component] = sweep->activeCount;
+        sweep->active[sweep->activeCount++] = component;
+    }
+}
+
+/// @brief Emits the pairs whose bounds overlap by testing every pair of components.
+/// @param firstComponent First component of the range.
+/// @param componentCount Number of components in the range.
+/// @param list List to append the pairs to.
+static void PhysicsScene_CollectBruteForcePairs(Entity firstComponent, RJ_Size componentCount, PHYSICS_PAIR_LIST *list)
+{
+    for (Entity firstPairComponent = firstComponent; firstPairComponent < firstComponent + componentCount; firstPairComponent++)
+    {
+        for (Entity secondPairComponent = firstPairComponent + 1; secondPairComponent < firstComponent + componentCount; secondPairComponent++)
+        {
+            if (PhysicsScene_CanPair(firstPairComponent, secondPairComponent) && PhysicsScene_BoundsOverlap(firstPairComponent, secondPairComponent))
+            {
+                PhysicsScene_AddPair(list, firstPairComponent, secondPairComponent);
+            }
+        }
+    }
+}
+
+#pragma endregion Broadphase
+
+#pragma region Sleep
+
+/// @brief Finds the root of an island in the union find forest, halving the path on the way.
+/// @param index Index relative to the first awake component.
+/// @return Root index of the island.
+static inline RJ_Size PhysicsSleep_FindIsland(RJ_Size index)
+{
+    while (PHYSICS.sleep.islandParents[index] != index)
+    {
+        PHYSICS.sleep.islandParents[index] = PHYSICS.sleep.islandParents[PHYSICS.sleep.islandParents[index]];
+        index = PHYSICS.sleep.islandParents[index];
+    }
+
+    return index;
+}
+
+/// @brief Compares island ids for sorting and searching.
+static int PhysicsSleep_CompareIslandIds(const void *first, const void *second)
+{
+    Entity firstId = *(const Entity *)first;
+    Entity secondId = *(const Entity *)second;
+    return (firstId > secondId) - (firstId < secondId);
+}
+
+/// @brief Wakes every sleeping component whose island id is in a sorted id array.
+/// @param islandIds Sorted island ids to wake.
+/// @param islandCount Number of ids.
+static void PhysicsSleep_WakeIslands(const Entity *islandIds, RJ_Size islandCount)
+{
+    for (Entity component = PHYSICS.data.staticCount; component < PHYSICS.data.awakeStart;)
+    {
+        if (bsearch(&PHYSICS.sleep.islandIds[component], islandIds, islandCount, sizeof(Entity), PhysicsSleep_CompareIslandIds) == NULL)
+        {
+            component++;
+            continue;
+        }
+
+        // the last sleeping component is swapped into this index, so it is checked next
+        Entity awakeComponent = PhysicsScene_MoveToPartition(component, PHYSICS_PARTITION_AWAKE);
+        PHYSICS.sleep.restSteps[awakeComponent] = 0;
+    }
+}
+
+/// @brief Wakes every sleeping component. Used when the static set changes since sleeping components may be resting on it.
+static void PhysicsSleep_WakeAll(void)
+{
+    if (PHYSICS.data.awakeStart == PHYSICS.data.staticCount)
+    {
+        return;
+    }
+
+    memset(PHYSICS.sleep.restSteps + PHYSICS.data.staticCount, 0, sizeof(uint16_t) * (PHYSICS.data.awakeStart - PHYSICS.data.staticCount));
+    PHYSICS.data.awakeStart = PHYSICS.data.staticCount;
+
+    PHYSICS.sleep.isSleepingDirty = true;
+    PHYSICS.broadphase.sweep.isDirty = true;
+}
+
+/// @brief Checks whether the colliders of two components touch, leaving out the broadphase margin so bodies that are merely near stay apart.
+/// @param firstComponent First component.
+/// @param secondComponent Second component.
+/// @return True if the collider boxes meet on all axes.
+static inline bool PhysicsSleep_IsTouching(Entity firstComponent, Entity secondComponent)
+{
+    Vector3 distance = Vector3G_Sum(pPosition(firstComponent), Vector3G_Scale(pPosition(secondComponent), -1.0f));
+    Vector3 reach = Vector3G_Scale(Vector3G_Sum(pColliderSize(firstComponent), pColliderSize(secondComponent)), 0.5f);
+
+    return fabsf(distance.x) <= reach.x && fabsf(distance.y) <= reach.y && fabsf(distance.z) <= reach.z;
+}
+
+/// @brief Wakes the islands of the sleeping components touched by awake ones. Expects the bounds of the awake components to be up to date.
+static void PhysicsSleep_WakeTouched(void)
+{
+    RJ_Size sleepingCount = PHYSICS.data.awakeStart - PHYSICS.data.staticCount;
+
+    if (sleepingCount == 0)
+    {
+        return;
+    }
+
+    if (PHYSICS.sleep.isSleepingDirty)
+    {
+        PHYSICS.sleep.isSleepingDirty = !PhysicsGrid_Build(&PHYSICS.sleep.sleepingGrid, PHYSICS.data.staticCount, sleepingCount);
+    }
+
+    PHYSICS.sleep.wakePairs.count = 0;
+    PhysicsGrid_CollectQueryPairs(&PHYSICS.sleep.sleepingGrid, PHYSICS.data.awakeStart, PHYSICS.data.count - PHYSICS.data.awakeStart, &PHYSICS.sleep.wakePairs);
+
+    if (PHYSICS.sleep.wakePairs.count == 0)
+    {
+        return;
+    }
+
+    // sleeping components always have rest steps, zero marks the touched ones until their island ids are collected
+    for (RJ_Size pair = 0; pair < PHYSICS.sleep.wakePairs.count; pair++)
+    {
+        Entity sleeping = PHYSICS.sleep.wakePairs.pairs[pair].first;
+        Entity awake = PHYSICS.sleep.wakePairs.pairs[pair].second;
+
+        if (!pIsTrigger(sleeping) && !pIsTrigger(awake) && PhysicsSleep_IsTouching(sleeping, awake))
+        {
+            PHYSICS.sleep.restSteps[sleeping] = 0;
+        }
+    }
+
+    RJ_Size islandCount = 0;
+
+    for (Entity component = PHYSICS.data.staticCount; component < PHYSICS.data.awakeStart; component++)
+    {
+        if (PHYSICS.sleep.restSteps[component] == 0)
+        {
+            PHYSICS.sleep.transitions[islandCount++] = PHYSICS.sleep.islandIds[component];
+        }
+    }
+
+    qsort(PHYSICS.sleep.transitions, islandCount, sizeof(Entity), PhysicsSleep_CompareIslandIds);
+
+    RJ_Size uniqueCount = 0;
+
+    for (RJ_Size island = 0; island < islandCount; island++)
+    {
+        if (uniqueCount == 0 || PHYSICS.sleep.transitions[uniqueCount - 1] != PHYSICS.sleep.transitions[island])
+        {
+            PHYSICS.sleep.transitions[uniqueCount++] = PHYSICS.sleep.transitions[island];
+        }
+    }
+
+    PhysicsSleep_WakeIslands(PHYSICS.sleep.transitions, uniqueCount);
+}
+
+/// @brief Updates the rest steps of the awake components, builds the islands from the dynamic contacts and puts the islands that rested long enough to sleep.
+static void PhysicsSleep_Update(void)
+{
+    Entity firstAwake = PHYSICS.data.awakeStart;
+    RJ_Size awakeCount = PHYSICS.data.count - PHYSICS.data.awakeStart;
+
+    for (RJ_Size index = 0; index < awakeCount; index++)
+    {
+        Entity component = firstAwake + index;
+        float speedSquared = pVelocityX(component) * pVelocityX(component) + pVelocityY(component) * pVelocityY(component) + pVelocityZ(component) * pVelocityZ(component);
+
+        if (speedSquared < PHYSICS_SLEEP_VELOCITY_THRESHOLD * PHYSICS_SLEEP_VELOCITY_THRESHOLD)
+        {
+            PHYSICS.sleep.restSteps[component] += PHYSICS.sleep.restSteps[component] < UINT16_MAX;
+        }
+        else
+        {
+            PHYSICS.sleep.restSteps[component] = 0;
+        }
+
+        PHYSICS.sleep.islandParents[index] = index;
+        PHYSICS.sleep.islandRestSteps[index] = UINT16_MAX;
+    }
+
+    // only pairs the last narrowphase found touching join islands, bodies that are merely near each other stay apart
+    const PHYSICS_CONTACT_LIST *contacts = &PHYSICS.narrowphase.dynamicContacts;
+
+    for (RJ_Size contact = 0; contact < contacts->count; contact++)
+    {
+        Entity first = contacts->contacts[contact].first;
+        Entity second = contacts->contacts[contact].second;
+
+        if (pIsTrigger(first) || pIsTrigger(second))
+        {
+            continue; // triggers do not support anything
+        }
+
+        RJ_Size firstRoot = PhysicsSleep_FindIsland(first - firstAwake);
+        RJ_Size secondRoot = PhysicsSleep_FindIsland(second - firstAwake);
+
+        if (firstRoot != secondRoot)
+        {
+            PHYSICS.sleep.islandParents[Maths_Max(firstRoot, secondRoot)] = Maths_Min(firstRoot, secondRoot);
+        }
+    }
+
+    for (RJ_Size index = 0; index < awakeCount; index++)
+    {
+        RJ_Size root = PhysicsSleep_FindIsland(index);
+        PHYSICS.sleep.islandRestSteps[root] = Maths_Min(PHYSICS.sleep.islandRestSteps[root], PHYSICS.sleep.restSteps[firstAwake + index]);
+    }
+
+    RJ_Size sleepCount = 0;
+
+    // roots have the smallest index of their island, so the id of an island is assigned before any other member reads it
+    for (RJ_Size index = 0; index < awakeCount; index++)
+    {
+        RJ_Size root = PhysicsSleep_FindIsland(index);
+
+        if (PHYSICS.sleep.islandRestSteps[root] < PHYSICS_SLEEP_STEP_COUNT)
+        {
+            continue;
+        }
+
+        if (root == index)
+        {
+            PHYSICS.sleep.islandIds[firstAwake + index] = PHYSICS.sleep.nextIslandId++;
+        }
+
+        PHYSICS.sleep.islandIds[firstAwake + index] = PHYSICS.sleep.islandIds[firstAwake + root];
+        PHYSICS.sleep.transitions[sleepCount++] = rEntity(firstAwake + index);
+    }
+
+    for (RJ_Size sleeping = 0; sleeping < sleepCount; sleeping++)
+    {
+        Entity component = PhysicsScene_MoveToPartition(rComponent(PHYSICS.sleep.transitions[sleeping]), PHYSICS_PARTITION_SLEEPING);
+        pSetVelocity(component, Vector3_Zero);
+    }
+}
+
+#pragma endregion Sleep
+
+#pragma region Continuous Collision
+
+/// @brief Position of a continuous component at the start of the last integration. Integration adds the final velocity times the step, so it is recovered from the current state.
+#define pSweepStart(component) Vector3G_Sum(pPosition(component), Vector3G_Scale(pVelocity(component), -PHYSICS.continuous.deltaTime))
+
+/// @brief Grows the bounds of the awake continuous components to cover their whole motion of the last integration, so the broadphase pairs them with everything they passed.
+static void PhysicsContinuous_SweepBounds(void)
+{
+    if (PHYSICS.continuous.count == 0 || PHYSICS.continuous.deltaTime == 0.0f)
+    {
+        return;
+    }
+
+    for (Entity component = PHYSICS.data.awakeStart; component < PHYSICS.data.count; component++)
+    {
+        if (!pIsContinuous(component))
+        {
+            continue;
+        }
+
+        Vector3 start = pSweepStart(component);
+        Vector3 halfSize = Vector3G_Sum(Vector3G_Scale(pColliderSize(component), 0.5f), Vector3_NewN(PHYSICS_BROADPHASE_MARGIN));
+
+        pBounds(component).min = Vector3_New(Maths_Min(pBounds(component).min.x, start.x - halfSize.x),
+                                             Maths_Min(pBounds(component).min.y, start.y - halfSize.y),
+                                             Maths_Min(pBounds(component).min.z, start.z - halfSize.z));
+        pBounds(component).max = Vector3_New(Maths_Max(pBounds(component).max.x, start.x + halfSize.x),
+                                             Maths_Max(pBounds(component).max.y, start.y + halfSize.y),
+                                             Maths_Max(pBounds(component).max.z, start.z + halfSize.z));
+    }
+}
+
+/// @brief Finds when a moving component first touches another one with a slab test against their Minkowski sum. The other component is taken at its current position.
+/// @param mover Moving component.
+/// @param target Component to test against.
+/// @param start Position of the mover at the start of the motion.
+/// @param motion Motion of the mover.
+/// @return Fraction of the motion in [0, 1) at the first touch, 1 if they do not touch or already overlap at the start.
+static float PhysicsContinuous_TimeOfImpact(Entity mover, Entity target, Vector3 start, Vector3 motion)
+{
+    float starts[3] = {start.x, start.y, start.z};
+    float motions[3] = {motion.x, motion.y, motion.z};
+    float targets[3] = {pPositionX(target), pPositionY(target), pPositionZ(target)};
+    float extents[3] = {(pColliderSizeX(mover) + pColliderSizeX(target)) * 0.5f,
+                        (pColliderSizeY(mover) + pColliderSizeY(target)) * 0.5f,
+                        (pColliderSizeZ(mover) + pColliderSizeZ(target)) * 0.5f};
+
+    float enter = -FLT_MAX;
+    float exit = FLT_MAX;
+
+    for (RJ_Size axis = 0; axis < 3; axis++)
+    {
+        float low = targets[axis] - extents[axis] - starts[axis];
+        float high = targets[axis] + extents[axis] - starts[axis];
+
+        if (motions[axis] == 0.0f)
+        {
+            if (low >= 0.0f || high <= 0.0f)
+            {
+                return 1.0f; // never inside the slab on this axis
+            }
+
+            continue;
+        }
+
+        float inverseMotion = 1.0f / motions[axis];
+        float slabEnter = (motions[axis] > 0.0f ? low : high) * inverseMotion;
+        float slabExit = (motions[axis] > 0.0f ? high : low) * inverseMotion;
+
+        enter = Maths_Max(enter, slabEnter);
+        exit = Maths_Min(exit, slabExit);
+    }
+
+    if (enter < 0.0f || enter >= 1.0f || enter >= exit)
+    {
+        return 1.0f; // overlapping at the start is left to the discrete resolve
+    }
+
+    return enter;
+}
+
+/// @brief Tests the motion of a continuous component against one of its pairs and keeps the earliest impact. Triggers do not stop anything.
+/// @param mover Continuous component.
+/// @param target Other component of the pair.
+static inline void PhysicsContinuous_TestPair(Entity mover, Entity target)
+{
+    if (pIsTrigger(mover) || pIsTrigger(target))
+    {
+        return;
+    }
+
+    Vector3 start = pSweepStart(mover);
+    Vector3 motion = Vector3G_Scale(pVelocity(mover), PHYSICS.continuous.deltaTime);
+    float *impactTime = &PHYSICS.continuous.impactTimes[mover - PHYSICS.data.awakeStart];
+
+    *impactTime = Maths_Min(*impactTime, PhysicsContinuous_TimeOfImpact(mover, target, start, motion));
+}
+
+/// @brief Moves every awake continuous component back to its earliest impact of the last integration, slightly inside the hit component so the resolve iterations bounce it like a discrete contact.
+/// @note Only the pairs of continuous components are tested, the pairs come from the swept bounds so nothing that was passed is missed.
+static void PhysicsContinuous_Clamp(void)
+{
+    if (PHYSICS.continuous.count == 0 || PHYSICS.continuous.deltaTime == 0.0f)
+    {
+        return;
+    }
+
+    for (RJ_Size index = 0; index < PHYSICS.data.count - PHYSICS.data.awakeStart; index++)
+    {
+        PHYSICS.continuous.impactTimes[index] = 1.0f;
+    }
+
+    for (RJ_Size pair = 0; pair < PHYSICS.broadphase.dynamicPairs.count; pair++)
+    {
+        Entity first = PHYSICS.broadphase.dynamicPairs.pairs[pair].first;
+        Entity second = PHYSICS.broadphase.dynamicPairs.pairs[pair].second;
+
+        if (pIsContinuous(first))
+        {
+            PhysicsContinuous_TestPair(first, second);
+        }
+
+        if (pIsContinuous(second))
+        {
+            PhysicsContinuous_TestPair(second, first);
+        }
+    }
+
+    for (RJ_Size pair = 0; pair < PHYSICS.broadphase.staticPairs.count; pair++)
+    {
+        Entity dynamicComponent = PHYSICS.broadphase.staticPairs.pairs[pair].second;
+
+        if (pIsContinuous(dynamicComponent))
+        {
+            PhysicsContinuous_TestPair(dynamicComponent, PHYSICS.broadphase.staticPairs.pairs[pair].first);
+        }
+    }
+
+    for (Entity component = PHYSICS.data.awakeStart; component < PHYSICS.data.count; component++)
+    {
+        float impactTime = PHYSICS.continuous.impactTimes[component - PHYSICS.data.awakeStart];
+
+        if (impactTime >= 1.0f)
+        {
+            continue;
+        }
+
+        Vector3 start = pSweepStart(component);
+        Vector3 motion = Vector3G_Scale(pVelocity(component), PHYSICS.continuous.deltaTime);
+
+        impactTime = Maths_Min(impactTime + PHYSICS_SEPARATION_EPSILON / sqrtf(Vector3G_Dot(motion, motion)), 1.0f);
+        pSetPosition(component, Vector3G_Sum(start, Vector3G_Scale(motion, impactTime)));
+    }
+}
+
+#pragma endregion Continuous Collision
+
+/// @brief Gathers the static positions and indexes them in the static grid.
+/// @return True if every static component was indexed, see PhysicsGrid_Build.
+static bool PhysicsScene_BuildStaticGrid(void)
+{
+    PhysicsScene_GatherPositions(0, PHYSICS.data.staticCount);
+    PhysicsScene_UpdateBounds(0, PHYSICS.data.staticCount);
+    PHYSICS.broadphase.staticGridVersion = ++PHYSICS.broadphase.staticGridBuildCount;
+
+    return PhysicsGrid_Build(&PHYSICS.broadphase.staticGrid, 0, PHYSICS.data.staticCount);
+}
+
+/// @brief Rebuilds the candidate pair lists for the current positions. Dynamic pairs are collected with the configured broadphase, static pairs by querying the static grid which is only rebuilt when the static set changes. Static components are never paired with each other.
+/// @note Only awake components are collected. Sleeping ones are kept in a grid like the statics and are woken with their island when an awake component touches them.
+static void PhysicsScene_UpdateBroadphase(void)
+{
+    PHYSICS.broadphase.dynamicPairs.count = 0;
+    PHYSICS.broadphase.staticPairs.count = 0;
+
+    if (PHYSICS.broadphase.isStaticDirty)
+    {
+        PhysicsSleep_WakeAll();
+
+        // an incomplete grid is built again by the next step
+        PHYSICS.broadphase.isStaticDirty = !PhysicsScene_BuildStaticGrid();
+    }
+
+    PhysicsScene_GatherPositions(PHYSICS.data.awakeStart, PHYSICS.data.count - PHYSICS.data.awakeStart);
+    PhysicsScene_UpdateBounds(PHYSICS.data.awakeStart, PHYSICS.data.count - PHYSICS.data.awakeStart);
+    PhysicsContinuous_SweepBounds();
+
+    // woken components keep the positions and bounds they fell asleep with, so they join the awake range ready to use
+    PhysicsSleep_WakeTouched();
+
+    Entity firstDynamic = PHYSICS.data.awakeStart;
+    RJ_Size dynamicCount = PHYSICS.data.count - PHYSICS.data.awakeStart;
+
+    switch (PHYSICS.broadphase.type)
+    {
+    case PhysicsBroadphase_BruteForce:
+        PhysicsScene_CollectBruteForcePairs(firstDynamic, dynamicCount, &PHYSICS.broadphase.dynamicPairs);
+        break;
+
+    case PhysicsBroadphase_SpatialHash:
+        PhysicsGrid_Build(&PHYSICS.broadphase.grid, firstDynamic, dynamicCount);
+        PhysicsGrid_CollectPairs(&PHYSICS.broadphase.grid, &PHYSICS.broadphase.dynamicPairs);
+        PhysicsGrid_CollectOversizedPairs(&PHYSICS.broadphase.grid, firstDynamic, dynamicCount, &PHYSICS.broadphase.dynamicPairs);
+        break;
+
+    case PhysicsBroadphase_SweepAndPrune:
+        PhysicsSweep_CollectPairs(&PHYSICS.broadphase.sweep, firstDynamic, dynamicCount, &PHYSICS.broadphase.dynamicPairs);
+        break;
+    }
+
+    PhysicsGrid_CollectQueryPairs(&PHYSICS.broadphase.staticGrid, firstDynamic, dynamicCount, &PHYSICS.broadphase.staticPairs);
+}
+
+#pragma region Queries
+
+/// @brief Brings the query structures up to date with the current positions. Static and sleeping components are queried from their own grids, awake ones from the broadphase grid which is rebuilt here for every broadphase type, the spatial hash broadphase rebuilds it every step anyway.
+/// @note Static and sleeping grids are built the same way the step would build them, so queries never change the simulation.
+static void PhysicsQuery_Refresh(void)
+{
+    if (!PHYSICS.query.isDirty)
+    {
+        return;
+    }
+
+    if (PHYSICS.broadphase.isStaticDirty)
+    {
+        // the flag is kept, the next step still has to wake the sleeping components
+        PhysicsScene_BuildStaticGrid();
+    }
+
+    if (PHYSICS.sleep.isSleepingDirty)
+    {
+        PHYSICS.sleep.isSleepingDirty = !PhysicsGrid_Build(&PHYSICS.sleep.sleepingGrid, PHYSICS.data.staticCount, PHYSICS.data.awakeStart - PHYSICS.data.staticCount);
+    }
+
+    PhysicsScene_GatherPositions(PHYSICS.data.awakeStart, PHYSICS.data.count - PHYSICS.data.awakeStart);
+    PhysicsScene_UpdateBounds(PHYSICS.data.awakeStart, PHYSICS.data.count - PHYSICS.data.awakeStart);
+    PhysicsGrid_Build(&PHYSICS.broadphase.grid, PHYSICS.data.awakeStart, PHYSICS.data.count - PHYSICS.data.awakeStart);
+
+    PHYSICS.query.isDirty = false;
+}
+
+/// @brief Casts a ray against the collider of a component with a slab test.
+/// @param component Component to test.
+/// @param origin Origin of the ray.
+/// @param direction Normalized direction of the ray.
+/// @param retAxis Filled with the axis of the hit face.
+/// @return Distance to the hit, FLT_MAX if the ray misses or starts inside the collider.
+static float PhysicsQuery_RayBox(Entity component, const float *origin, const float *direction, RJ_Size *retAxis)
+{
+    float positions[3] = {pPositionX(component), pPositionY(component), pPositionZ(component)};
+    float halfSizes[3] = {pColliderSizeX(component) * 0.5f, pColliderSizeY(component) * 0.5f, pColliderSizeZ(component) * 0.5f};
+
+    float enter = -FLT_MAX;
+    float exit = FLT_MAX;
+
+    for (RJ_Size axis = 0; axis < 3; axis++)
+    {
+        float low = positions[axis] - halfSizes[axis] - origin[axis];
+        float high = positions[axis] + halfSizes[axis] - origin[axis];
+
+        if (direction[axis] == 0.0f)
+        {
+            if (low >= 0.0f || high <= 0.0f)
+            {
+                return FLT_MAX;
+            }
+
+            continue;
+        }
+
+        float slabEnter = Maths_Min(low / direction[axis], high / direction[axis]);
+        float slabExit = Maths_Max(low / direction[axis], high / direction[axis]);
+
+        if (slabEnter > enter)
+        {
+            enter = slabEnter;
+            *retAxis = axis;
+        }
+
+        exit = Maths_Min(exit, slabExit);
+    }
+
+    return enter < 0.0f || enter > exit ? FLT_MAX : enter;
+}
+
+/// @brief Casts a ray against a single component and keeps the hit if it is the closest one so far.
+/// @param component Component to test.
+/// @param origin Origin of the ray.
+/// @param direction Normalized direction of the ray.
+/// @param layerMask Only components with a layer in the mask are hit.
+/// @param hit Closest hit so far, its distance limits the ray.
+static inline void PhysicsQuery_RaycastOne(Entity component, const float *origin, const float *direction, uint32_t layerMask, PhysicsRaycastHit *hit)
+{
+    if ((pLayer(component) & layerMask) == 0)
+    {
+        return;
+    }
+
+    RJ_Size axis = 0;
+    float distance = PhysicsQuery_RayBox(component, origin, direction, &axis);
+
+    if (distance >= hit->distance)
+    {
+        return;
+    }
+
+    float normal[3] = {0.0f, 0.0f, 0.0f};
+    normal[axis] = direction[axis] > 0.0f ? -1.0f : 1.0f;
+
+    hit->entity = rEntity(component);
+    hit->distance = distance;
+    hit->normal = Vector3_New(normal[0], normal[1], normal[2]);
+}
+
+/// @brief Casts a ray through the cells of a grid in order with a 3D DDA, stopping once the cells are further than the closest hit.
+/// @param grid Grid to traverse.
+/// @param origin Origin of the ray.
+/// @param direction Normalized direction of the ray.
+/// @param layerMask Only components with a layer in the mask are hit.
+/// @param hit Closest hit so far, its distance limits the ray.
+static void PhysicsQuery_RaycastGrid(const PHYSICS_GRID *grid, const float *origin, const float *direction, uint32_t layerMask, PhysicsRaycastHit *hit)
+{
+    for (RJ_Size oversized = 0; oversized < grid->oversizedCount; oversized++)
+    {
+        PhysicsQuery_RaycastOne(grid->oversized[oversized], origin, direction, layerMask, hit);
+    }
+
+    if (grid->entryCount == 0)
+    {
+        return;
+    }
+
+    float extentMin[3] = {grid->extent.min.x, grid->extent.min.y, grid->extent.min.z};
+    float extentMax[3] = {grid->extent.max.x, grid->extent.max.y, grid->extent.max.z};
+
+    float enter = 0.0f;
+    float exit = hit->distance;
+
+    for (RJ_Size axis = 0; axis < 3; axis++)
+    {
+        if (direction[axis] == 0.0f)
+        {
+            if (origin[axis] < extentMin[axis] || origin[axis] > extentMax[axis])
+            {
+                return;
+            }
+
+            continue;
+        }
+
+        float low = (extentMin[axis] - origin[axis]) / direction[axis];
+        float high = (extentMax[axis] - origin[axis]) / direction[axis];
+
+        enter = Maths_Max(enter, Maths_Min(low, high));
+        exit = Maths_Min(exit, Maths_Max(low, high));
+    }
+
+    if (enter > exit)
+    {
+        return;
+    }
+
+    int32_t cells[3];
+    int32_t steps[3];
+    float nextTimes[3];  // distance along the ray to the next cell boundary on every axis
+    float deltaTimes[3]; // distance along the ray between two cell boundaries on every axis
+    RJ_Size cellCount = 2; // one extra cell for rounding at the cell boundaries
+
+    for (RJ_Size axis = 0; axis < 3; axis++)
+    {
+        cells[axis] = PhysicsGrid_Cell(grid, origin[axis] + direction[axis] * enter);
+
+        // bounds the walk, float steps could otherwise keep going past the exit cell
+        int32_t exitCell = PhysicsGrid_Cell(grid, origin[axis] + direction[axis] * exit);
+        cellCount += (RJ_Size)(exitCell > cells[axis] ? exitCell - cells[axis] : cells[axis] - exitCell);
+
+        if (direction[axis] == 0.0f)
+        {
+            steps[axis] = 0;
+            nextTimes[axis] = FLT_MAX;
+            deltaTimes[axis] = FLT_MAX;
+            continue;
+        }
+
+        steps[axis] = direction[axis] > 0.0f ? 1 : -1;
+        nextTimes[axis] = ((float)(cells[axis] + (steps[axis] > 0)) * grid->cellSize - origin[axis]) / direction[axis];
+        deltaTimes[axis] = grid->cellSize / Maths_Abs(direction[axis]);
+    }
+
+    float time = enter;
+
+    for (RJ_Size cell = 0; cell < cellCount && time <= Maths_Min(exit, hit->distance); cell++)
+    {
+        RJ_Size bucket = PhysicsGrid_Hash(grid, cells[0], cells[1], cells[2]);
+
+        for (RJ_Size entry = grid->bucketStarts[bucket]; entry < grid->bucketStarts[bucket + 1]; entry++)
+        {
+            const PHYSICS_GRID_ENTRY *gridEntry = &grid->entries[entry];
+
+            if (gridEntry->cellX == cells[0] && gridEntry->cellY == cells[1] && gridEntry->cellZ == cells[2])
+            {
+                PhysicsQuery_RaycastOne(gridEntry->component, origin, direction, layerMask, hit);
+            }
+        }
+
+        RJ_Size axis = nextTimes[0] < nextTimes[1] && nextTimes[0] < nextTimes[2] ? 0 : (nextTimes[1] < nextTimes[2] ? 1 : 2);
+
+        time = nextTimes[axis];
+        nextTimes[axis] += deltaTimes[axis];
+        cells[axis] += steps[axis];
+    }
+}
+
+/// @brief Checks whether the collider of a component overlaps a query box.
+/// @param component Component to test.
+/// @param query Query box.
+/// @return True if they overlap on all axes.
+static inline bool PhysicsQuery_BoxOverlap(Entity component, const PHYSICS_BOUNDS *query)
+{
+    return pPositionX(component) - pColliderSizeX(component) * 0.5f < query->max.x && query->min.x < pPositionX(component) + pColliderSizeX(component) * 0.5f &&
+           pPositionY(component) - pColliderSizeY(component) * 0.5f < query->max.y && query->min.y < pPositionY(component) + pColliderSizeY(component) * 0.5f &&
+           pPositionZ(component) - pColliderSizeZ(component) * 0.5f < query->max.z && query->min.z < pPositionZ(component) + pColliderSizeZ(component) * 0.5f;
+}
+
+/// @brief Appends a component to the query results, counting it even if the buffer is full.
+/// @param component Component to append.
+/// @param retEntities Result buffer.
+/// @param entityCapacity Capacity of the result buffer.
+/// @param count Number of components found so far.
+static inline void PhysicsQuery_Append(Entity component, Entity *retEntities, RJ_Size entityCapacity, RJ_Size *count)
+{
+    if (*count < entityCapacity)
+    {
+        retEntities[*count] = rEntity(component);
+    }
+
+    (*count)++;
+}
+
+/// @brief Collects the components of a grid overlapping a query box. Like the pair collection, a component is only reported from the cell containing the minimum corner of the intersection of its bounds and the query, so components covering many cells are reported once.
+/// @param grid Grid to query.
+/// @param query Query box.
+/// @param layerMask Only components with a layer in the mask are collected.
+/// @param retEntities Result buffer.
+/// @param entityCapacity Capacity of the result buffer.
+/// @param count Number of components found so far.
+static void PhysicsQuery_OverlapGrid(const PHYSICS_GRID *grid, const PHYSICS_BOUNDS *query, uint32_t layerMask, Entity *retEntities, RJ_Size entityCapacity, RJ_Size *count)
+{
+    for (RJ_Size oversized = 0; oversized < grid->oversizedCount; oversized++)
+    {
+        Entity component = grid->oversized[oversized];
+
+        if ((pLayer(component) & layerMask) != 0 && PhysicsQuery_BoxOverlap(component, query))
+        {
+            PhysicsQuery_Append(component, retEntities, entityCapacity, count);
+        }
+    }
+
+    PHYSICS_BOUNDS clipped = {Vector3_New(Maths_Max(query->min.x, grid->extent.min.x), Maths_Max(query->min.y, grid->extent.min.y), Maths_Max(query->min.z, grid->extent.min.z)),
+                              Vector3_New(Maths_Min(query->max.x, grid->extent.max.x), Maths_Min(query->max.y, grid->extent.max.y), Maths_Min(query->max.z, grid->extent.max.z))};
+
+    if (grid->entryCount == 0 || clipped.min.x > clipped.max.x || clipped.min.y > clipped.max.y || clipped.min.z > clipped.max.z)
+    {
+        return;
+    }
+
+    int32_t minX = PhysicsGrid_Cell(grid, clipped.min.x);
+    int32_t minY = PhysicsGrid_Cell(grid, clipped.min.y);
+    int32_t minZ = PhysicsGrid_Cell(grid, clipped.min.z);
+    int32_t maxX = PhysicsGrid_Cell(grid, clipped.max.x);
+    int32_t maxY = PhysicsGrid_Cell(grid, clipped.max.y);
+    int32_t maxZ = PhysicsGrid_Cell(grid, clipped.max.z);
+
+    for (int32_t cellX = minX; cellX <= maxX; cellX++)
+    {
+        for (int32_t cellY = minY; cellY <= maxY; cellY++)
+        {
+            for (int32_t cellZ = minZ; cellZ <= maxZ; cellZ++)
+            {
+                RJ_Size bucket = PhysicsGrid_Hash(grid, cellX, cellY, cellZ);
+
+                for (RJ_Size entry = grid->bucketStarts[bucket]; entry < grid->bucketStarts[bucket + 1]; entry++)
+                {
+                    Entity component = grid->entries[entry].component;
+
+                    if (grid->entries[entry].cellX != cellX ||
+                        grid->entries[entry].cellY != cellY ||
+                        grid->entries[entry].cellZ != cellZ ||
+                        (pLayer(component) & layerMask) == 0 ||
+                        !PhysicsQuery_BoxOverlap(component, query))
+                    {
+                        continue;
+                    }
+
+                    if (PhysicsGrid_Cell(grid, Maths_Max(pBounds(component).min.x, clipped.min.x)) != cellX ||
+                        PhysicsGrid_Cell(grid, Maths_Max(pBounds(component).min.y, clipped.min.y)) != cellY ||
+                        PhysicsGrid_Cell(grid, Maths_Max(pBounds(component).min.z, clipped.min.z)) != cellZ)
+                    {
+                        continue;
+                    }
+
+                    PhysicsQuery_Append(component, retEntities, entityCapacity, count);
+                }
+            }
+        }
+    }
+}
+
+/// @brief Tests the distance of a single component to a point and keeps it if it is the nearest one so far.
+/// @param component Component to test.
+/// @param point Query point.
+/// @param layerMask Only components with a layer in the mask are found.
+/// @param ignoredComponent Component to skip, RJ_INDEX_INVALID for none.
+/// @param nearest Nearest component so far.
+/// @param nearestDistance Distance of the nearest component so far.
+static inline void PhysicsQuery_NearestOne(Entity component, Vector3 point, uint32_t layerMask, Entity ignoredComponent, Entity *nearest, float *nearestDistance)
+{
+    if (component == ignoredComponent || (pLayer(component) & layerMask) == 0)
+    {
+        return;
+    }
+
+    float distanceX = Maths_Max(Maths_Abs(point.x - pPositionX(component)) - pColliderSizeX(component) * 0.5f, 0.0f);
+    float distanceY = Maths_Max(Maths_Abs(point.y - pPositionY(component)) - pColliderSizeY(component) * 0.5f, 0.0f);
+    float distanceZ = Maths_Max(Maths_Abs(point.z - pPositionZ(component)) - pColliderSizeZ(component) * 0.5f, 0.0f);
+    float distance = sqrtf(distanceX * distanceX + distanceY * distanceY + distanceZ * distanceZ);
+
+    if (distance < *nearestDistance)
+    {
+        *nearest = component;
+        *nearestDistance = distance;
+    }
+}
+
+/// @brief Searches the cells of a grid in growing rings around a point until the ring is further than the nearest component found.
+/// @param grid Grid to query.
+/// @param point Query point.
+/// @param layerMask Only components with a layer in the mask are found.
+/// @param ignoredComponent Component to skip, RJ_INDEX_INVALID for none.
+/// @param nearest Nearest component so far.
+/// @param nearestDistance Distance of the nearest component so far, limits the search.
+static void PhysicsQuery_NearestGrid(const PHYSICS_GRID *grid, Vector3 point, uint32_t layerMask, Entity ignoredComponent, Entity *nearest, float *nearestDistance)
+{
+    for (RJ_Size oversized = 0; oversized < grid->oversizedCount; oversized++)
+    {
+        PhysicsQuery_NearestOne(grid->oversized[oversized], point, layerMask, ignoredComponent, nearest, nearestDistance);
+    }
+
+    if (grid->entryCount == 0)
+    {
+        return;
+    }
+
+    int32_t centerX = PhysicsGrid_Cell(grid, point.x);
+    int32_t centerY = PhysicsGrid_Cell(grid, point.y);
+    int32_t centerZ = PhysicsGrid_Cell(grid, point.z);
+    int32_t minX = PhysicsGrid_Cell(grid, grid->extent.min.x);
+    int32_t minY = PhysicsGrid_Cell(grid, grid->extent.min.y);
+    int32_t minZ = PhysicsGrid_Cell(grid, grid->extent.min.z);
+    int32_t maxX = PhysicsGrid_Cell(grid, grid->extent.max.x);
+    int32_t maxY = PhysicsGrid_Cell(grid, grid->extent.max.y);
+    int32_t maxZ = PhysicsGrid_Cell(grid, grid->extent.max.z);
+
+    int32_t firstRing = Maths_Max(Maths_Max(Maths_Max(minX - centerX, centerX - maxX), Maths_Max(minY - centerY, centerY - maxY)), Maths_Max(Maths_Max(minZ - centerZ, centerZ - maxZ), 0));
+    int32_t ringCount = Maths_Max(Maths_Max(Maths_Max(centerX - minX, maxX - centerX), Maths_Max(centerY - minY, maxY - centerY)), Maths_Max(centerZ - minZ, maxZ - centerZ)) + 1;
+
+    // every cell of a ring is at least ring - 1 cells away from the point, and a component is inserted to the cell holding its closest point
+    for (int32_t ring = firstRing; ring < ringCount && (float)(ring - 1) * grid->cellSize < *nearestDistance; ring++)
+    {
+        for (int32_t cellX = Maths_Max(centerX - ring, minX); cellX <= Maths_Min(centerX + ring, maxX); cellX++)
+        {
+            for (int32_t cellY = Maths_Max(centerY - ring, minY); cellY <= Maths_Min(centerY + ring, maxY); cellY++)
+            {
+                bool isRingSide = cellX == centerX - ring || cellX == centerX + ring || cellY == centerY - ring || cellY == centerY + ring;
+
+                for (int32_t cellZ = Maths_Max(centerZ - ring, minZ); cellZ <= Maths_Min(centerZ + ring, maxZ); cellZ++)
+                {
+                    if (!isRingSide && cellZ > centerZ - ring && cellZ < centerZ + ring)
+                    {
+                        cellZ = centerZ + ring; // inner cells belong to the previous rings
+                        if (cellZ > maxZ)
+                        {
+                            break;
+                        }
+                    }
+
+                    RJ_Size bucket = PhysicsGrid_Hash(grid, cellX, cellY, cellZ);
+
+                    for (RJ_Size entry = grid->bucketStarts[bucket]; entry < grid->bucketStarts[bucket + 1]; entry++)
+                    {
+                        const PHYSICS_GRID_ENTRY *gridEntry = &grid->entries[entry];
+
+                        if (gridEntry->cellX == cellX && gridEntry->cellY == cellY && gridEntry->cellZ == cellZ)
+                        {
+                            PhysicsQuery_NearestOne(gridEntry->component, point, layerMask, ignoredComponent, nearest, nearestDistance);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#pragma endregion Queries
+
+#pragma region Narrowphase
+
+/// @brief Appends the hits of a tested batch to a contact list.
+/// @param list List to append to.
+/// @param pairs Tested pairs, first of the batch.
+/// @param hitMask Bit i is set if pairs[i] is a contact.
+/// @param overlapX Overlaps of the batch on the x axis.
+/// @param overlapY Overlaps of the batch on the y axis.
+/// @param overlapZ Overlaps of the batch on the z axis.
+static inline void PhysicsNarrowphase_PackHits(PHYSICS_CONTACT_LIST *list, const PHYSICS_PAIR *pairs, uint32_t hitMask, const float *overlapX, const float *overlapY, const float *overlapZ)
+{
+    while (hitMask != 0)
+    {
+        RJ_Size lane = (RJ_Size)__builtin_ctz(hitMask);
+        hitMask &= hitMask - 1;
+
+        PHYSICS_CONTACT *contact = &list->contacts[list->count++];
+        contact->first = pairs[lane].first;
+        contact->second = pairs[lane].second;
+        contact->overlap = Vector3_New(overlapX[lane], overlapY[lane], overlapZ[lane]);
+        contact->depth = Maths_Min(Maths_Min(overlapX[lane], overlapY[lane]), overlapZ[lane]);
+    }
+}
+
+/// @brief Tests a single pair. Shared by every kernel for the tail so all of them produce identical contacts.
+/// @param list List to append the contact to if the pair overlaps or is closer than the contact distance.
+/// @param pair Pair to test.
+static inline void PhysicsNarrowphase_TestOne(PHYSICS_CONTACT_LIST *list, const PHYSICS_PAIR *pair)
+{
+    Entity first = pair->first;
+    Entity second = pair->second;
+    float overlap[3];
+
+    overlap[0] = Maths_Min(pPositionX(first) + pColliderSizeX(first) * 0.5f, pPositionX(second) + pColliderSizeX(second) * 0.5f) -
+                 Maths_Max(pPositionX(first) - pColliderSizeX(first) * 0.5f, pPositionX(second) - pColliderSizeX(second) * 0.5f);
+    overlap[1] = Maths_Min(pPositionY(first) + pColliderSizeY(first) * 0.5f, pPositionY(second) + pColliderSizeY(second) * 0.5f) -
+                 Maths_Max(pPositionY(first) - pColliderSizeY(first) * 0.5f, pPositionY(second) - pColliderSizeY(second) * 0.5f);
+    overlap[2] = Maths_Min(pPositionZ(first) + pColliderSizeZ(first) * 0.5f, pPositionZ(second) + pColliderSizeZ(second) * 0.5f) -
+                 Maths_Max(pPositionZ(first) - pColliderSizeZ(first) * 0.5f, pPositionZ(second) - pColliderSizeZ(second) * 0.5f);
+
+    uint32_t hitMask = overlap[0] > -PHYSICS_CONTACT_DISTANCE && overlap[1] > -PHYSICS_CONTACT_DISTANCE && overlap[2] > -PHYSICS_CONTACT_DISTANCE;
+    PhysicsNarrowphase_PackHits(list, pair, hitMask, &overlap[0], &overlap[1], &overlap[2]);
+}
+
+/// @brief Portable narrowphase kernel, used when no vector instruction set is available.
+static void PhysicsNarrowphase_TestScalar(const PHYSICS_PAIR *pairs, RJ_Size pairCount, PHYSICS_CONTACT_LIST *contacts)
+{
+    for (RJ_Size pair = 0; pair < pairCount; pair++)
+    {
+        PhysicsNarrowphase_TestOne(contacts, &pairs[pair]);
+    }
+}
+
+#if RJ_ARCHITECTURE == RJ_ARCHITECTURE_X64 && !PHYSICS_FORCE_SCALAR
+
+/// @brief Computes the overlap of 4 pairs on a single axis.
+static inline __m128 PhysicsNarrowphase_OverlapSSE(const float *positions, const float *sizes, const Entity *firsts, const Entity *seconds, __m128 half)
+{
+    __m128 firstPosition = _mm_setr_ps(positions[firsts[0]], positions[firsts[1]], positions[firsts[2]], positions[firsts[3]]);
+    __m128 firstHalfSize = _mm_mul_ps(_mm_setr_ps(sizes[firsts[0]], sizes[firsts[1]], sizes[firsts[2]], sizes[firsts[3]]), half);
+    __m128 secondPosition = _mm_setr_ps(positions[seconds[0]], positions[seconds[1]], positions[seconds[2]], positions[seconds[3]]);
+    __m128 secondHalfSize = _mm_mul_ps(_mm_setr_ps(sizes[seconds[0]], sizes[seconds[1]], sizes[seconds[2]], sizes[seconds[3]]), half);
+
+    return _mm_sub_ps(_mm_min_ps(_mm_add_ps(firstPosition, firstHalfSize), _mm_add_ps(secondPosition, secondHalfSize)),
+                      _mm_max_ps(_mm_sub_ps(firstPosition, firstHalfSize), _mm_sub_ps(secondPosition, secondHalfSize)));
+}
+
+/// @brief SSE narrowphase kernel, 4 pairs per iteration. Operands are assembled from the lanes since SSE has no gather.
+static void PhysicsNarrowphase_TestSSE(const PHYSICS_PAIR *pairs, RJ_Size pairCount, PHYSICS_CONTACT_LIST *contacts)
+{
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 distance = _mm_set1_ps(-PHYSICS_CONTACT_DISTANCE);
+    alignas(16) float overlapX[4];
+    alignas(16) float overlapY[4];
+    alignas(16) float overlapZ[4];
+
+    RJ_Size pair = 0;
+
+    for (; pair + 4 <= pairCount; pair += 4)
+    {
+        const PHYSICS_PAIR *batch = &pairs[pair];
+        Entity firsts[4] = {batch[0].first, batch[1].first, batch[2].first, batch[3].first};
+        Entity seconds[4] = {batch[0].second, batch[1].second, batch[2].second, batch[3].second};
+
+        __m128 x = PhysicsNarrowphase_OverlapSSE(PHYSICS.data.positions.x, PHYSICS.data.colliderSizes.x, firsts, seconds, half);
+        __m128 y = PhysicsNarrowphase_OverlapSSE(PHYSICS.data.positions.y, PHYSICS.data.colliderSizes.y, firsts, seconds, half);
+        __m128 z = PhysicsNarrowphase_OverlapSSE(PHYSICS.data.positions.z, PHYSICS.data.colliderSizes.z, firsts, seconds, half);
+
+        uint32_t hitMask = (uint32_t)_mm_movemask_ps(_mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(x, distance), _mm_cmpgt_ps(y, distance)), _mm_cmpgt_ps(z, distance)));
+
+        if (hitMask != 0)
+        {
+            _mm_store_ps(overlapX, x);
+            _mm_store_ps(overlapY, y);
+            _mm_store_ps(overlapZ, z);
+            PhysicsNarrowphase_PackHits(contacts, batch, hitMask, overlapX, overlapY, overlapZ);
+        }
+    }
+
+    for (; pair < pairCount; pair++)
+    {
+        PhysicsNarrowphase_TestOne(contacts, &pairs[pair]);
+    }
+}
+
+/// @brief Computes the overlap of 8 pairs on a single axis.
+__attribute__((target("avx2"))) static inline __m256 PhysicsNarrowphase_OverlapAVX2(const float *positions, const float *sizes, __m256i firsts, __m256i seconds, __m256 half)
+{
+    __m256 firstPosition = _mm256_i32gather_ps(positions, firsts, 4);
+    __m256 firstHalfSize = _mm256_mul_ps(_mm256_i32gather_ps(sizes, firsts, 4), half);
+    __m256 secondPosition = _mm256_i32gather_ps(positions, seconds, 4);
+    __m256 secondHalfSize = _mm256_mul_ps(_mm256_i32gather_ps(sizes, seconds, 4), half);
+
+    return _mm256_sub_ps(_mm256_min_ps(_mm256_add_ps(firstPosition, firstHalfSize), _mm256_add_ps(secondPosition, secondHalfSize)),
+                         _mm256_max_ps(_mm256_sub_ps(firstPosition, firstHalfSize), _mm256_sub_ps(secondPosition, secondHalfSize)));
+}
+
+/// @brief AVX2 narrowphase kernel, 8 pairs per iteration with gathered operands. Only selected if the CPU supports AVX2.
+__attribute__((target("avx2"))) static void PhysicsNarrowphase_TestAVX2(const PHYSICS_PAIR *pairs, RJ_Size pairCount, PHYSICS_CONTACT_LIST *contacts)
+{
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 distance = _mm256_set1_ps(-PHYSICS_CONTACT_DISTANCE);
+    __m256i deinterleave = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    alignas(32) float overlapX[8];
+    alignas(32) float overlapY[8];
+    alignas(32) float overlapZ[8];
+
+    RJ_Size pair = 0;
+
+    for (; pair + 8 <= pairCount; pair += 8)
+    {
+        const PHYSICS_PAIR *batch = &pairs[pair];
+
+        // pairs are interleaved first, second : split them into a vector of firsts and a vector of seconds
+        __m256i low = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)&batch[0]), deinterleave);
+        __m256i high = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)&batch[4]), deinterleave);
+        __m256i firsts = _mm256_permute2x128_si256(low, high, 0x20);
+        __m256i seconds = _mm256_permute2x128_si256(low, high, 0x31);
+
+        __m256 x = PhysicsNarrowphase_OverlapAVX2(PHYSICS.data.positions.x, PHYSICS.data.colliderSizes.x, firsts, seconds, half);
+        __m256 y = PhysicsNarrowphase_OverlapAVX2(PHYSICS.data.positions.y, PHYSICS.data.colliderSizes.y, firsts, seconds, half);
+        __m256 z = PhysicsNarrowphase_OverlapAVX2(PHYSICS.data.positions.z, PHYSICS.data.colliderSizes.z, firsts, seconds, half);
+
+        __m256 hits = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(x, distance, _CMP_GT_OQ), _mm256_cmp_ps(y, distance, _CMP_GT_OQ)), _mm256_cmp_ps(z, distance, _CMP_GT_OQ));
+        uint32_t hitMask = (uint32_t)_mm256_movemask_ps(hits);
+
+        if (hitMask != 0)
+        {
+            _mm256_store_ps(overlapX, x);
+            _mm256_store_ps(overlapY, y);
+            _mm256_store_ps(overlapZ, z);
+            PhysicsNarrowphase_PackHits(contacts, batch, hitMask, overlapX, overlapY, overlapZ);
+        }
+    }
+
+    for (; pair < pairCount; pair++)
+    {
+        PhysicsNarrowphase_TestOne(contacts, &pairs[pair]);
+    }
+}
+
+#endif
+
+/// @brief Gets the radius and the half length of the vertical segment of a round shape. Spheres are capsules with an empty segment.
+/// @param shape Round shape, sphere or capsule.
+/// @param size Collider size the shape is fitted into.
+/// @param retRadius Pointer to fill with the radius.
+/// @param retHalfSegment Pointer to fill with the half length of the segment.
+static inline void PhysicsShape_GetRound(PhysicsShape shape, Vector3 size, float *retRadius, float *retHalfSegment)
+{
+    if (shape == PhysicsShape_Capsule)
+    {
+        *retRadius = Maths_Min(size.x, size.z) * 0.5f;
+        *retHalfSegment = Maths_Max(size.y * 0.5f - *retRadius, 0.0f);
+        return;
+    }
+
+    *retRadius = Maths_Min(Maths_Min(size.x, size.y), size.z) * 0.5f;
+    *retHalfSegment = 0.0f;
+}
+
+/// @brief Tests two spheres.
+/// @param retNormal Pointer to fill with the unit normal from the first sphere to the second.
+/// @return Penetration depth, negative if the spheres are apart.
+static inline float PhysicsShape_TestSphereSphere(Vector3 position1, float radius1, Vector3 position2, float radius2, Vector3 *retNormal)
+{
+    Vector3 delta = Vector3_New(position2.x - position1.x, position2.y - position1.y, position2.z - position1.z);
+    float distance = Vector3_Magnitude(delta);
+
+    *retNormal = distance > 0.0f ? Vector3G_Scale(delta, (1.0f / distance)) : Vector3_Up;
+    return radius1 + radius2 - distance;
+}
+
+/// @brief Tests two round shapes through the closest points of their vertical segments, in the middle of the height range they share or at their facing ends if they share none.
+/// @param retNormal Pointer to fill with the unit normal from the first shape to the second.
+/// @return Penetration depth, negative if the shapes are apart.
+static inline float PhysicsShape_TestRoundRound(Vector3 position1, float radius1, float halfSegment1, Vector3 position2, float radius2, float halfSegment2, Vector3 *retNormal)
+{
+    float low = Maths_Max(position1.y - halfSegment1, position2.y - halfSegment2);
+    float high = Maths_Min(position1.y + halfSegment1, position2.y + halfSegment2);
+
+    if (low <= high)
+    {
+        position1.y = position2.y = (low + high) * 0.5f;
+    }
+    else if (position1.y < position2.y)
+    {
+        position1.y += halfSegment1;
+        position2.y -= halfSegment2;
+    }
+    else
+    {
+        position1.y -= halfSegment1;
+        position2.y += halfSegment2;
+    }
+
+    return PhysicsShape_TestSphereSphere(position1, radius1, position2, radius2, retNormal);
+}
+
+/// @brief Tests a round shape against a box through the point of its segment closest to the box.
+/// @param retNormal Pointer to fill with the unit normal from the round shape to the box.
+/// @return Penetration depth, negative if the shapes are apart.
+/// @note If the segment point is inside the box, the shape is pushed out through the face needing the smallest motion. Along y the whole segment has to leave the box.
+static inline float PhysicsShape_TestRoundBox(Vector3 position, float radius, float halfSegment, Vector3 boxPosition, Vector3 boxSize, Vector3 *retNormal)
+{
+    Vector3 boxMin = Vector3_New(boxPosition.x - boxSize.x * 0.5f, boxPosition.y - boxSize.y * 0.5f, boxPosition.z - boxSize.z * 0.5f);
+    Vector3 boxMax = Vector3_New(boxPosition.x + boxSize.x * 0.5f, boxPosition.y + boxSize.y * 0.5f, boxPosition.z + boxSize.z * 0.5f);
+
+    Vector3 center = Vector3_New(position.x, Maths_Clamp(Maths_Clamp(position.y, boxMin.y, boxMax.y), position.y - halfSegment, position.y + halfSegment), position.z);
+    Vector3 delta = Vector3_New(Maths_Clamp(center.x, boxMin.x, boxMax.x) - center.x,
+                                Maths_Clamp(center.y, boxMin.y, boxMax.y) - center.y,
+                                Maths_Clamp(center.z, boxMin.z, boxMax.z) - center.z);
+    float distance = Vector3_Magnitude(delta);
+
+    if (distance > 0.0f)
+    {
+        *retNormal = Vector3G_Scale(delta, (1.0f / distance));
+        return radius - distance;
+    }
+
+    float faceDepths[6] = {center.x - boxMin.x, boxMax.x - center.x,
+                           position.y + halfSegment - boxMin.y, boxMax.y - position.y + halfSegment,
+                           center.z - boxMin.z, boxMax.z - center.z};
+    Vector3 faceNormals[6] = {Vector3_Right, Vector3_Left, Vector3_Up, Vector3_Down, Vector3_Forward, Vector3_Backward};
+    RJ_Size face = 0;
+
+    for (RJ_Size i = 1; i < 6; i++)
+    {
+        face = faceDepths[i] < faceDepths[face] ? i : face;
+    }
+
+    *retNormal = faceNormals[face];
+    return faceDepths[face] + radius;
+}
+
+/// @brief Tests two shapes, at least one of them round. Used by single queries, the narrowphase calls the shape tests from kernels specialized for a shape pair instead.
+/// @param retNormal Pointer to fill with the unit normal from the first shape to the second.
+/// @return Penetration depth, negative if the shapes are apart.
+static float PhysicsShape_Test(PhysicsShape shape1, Vector3 position1, Vector3 size1, PhysicsShape shape2, Vector3 position2, Vector3 size2, Vector3 *retNormal)
+{
+    float radius1 = 0.0f;
+    float halfSegment1 = 0.0f;
+    float radius2 = 0.0f;
+    float halfSegment2 = 0.0f;
+
+    if (shape1 != PhysicsShape_Box)
+    {
+        PhysicsShape_GetRound(shape1, size1, &radius1, &halfSegment1);
+    }
+
+    if (shape2 != PhysicsShape_Box)
+    {
+        PhysicsShape_GetRound(shape2, size2, &radius2, &halfSegment2);
+    }
+
+    if (shape1 == PhysicsShape_Box)
+    {
+        Vector3 normal;
+        float depth = PhysicsShape_TestRoundBox(position2, radius2, halfSegment2, position1, size1, &normal);
+
+        *retNormal = Vector3G_Scale(normal, -1.0f);
+        return depth;
+    }
+
+    if (shape2 == PhysicsShape_Box)
+    {
+        return PhysicsShape_TestRoundBox(position1, radius1, halfSegment1, position2, size2, retNormal);
+    }
+
+    return PhysicsShape_TestRoundRound(position1, radius1, halfSegment1, position2, radius2, halfSegment2, retNormal);
+}
+
+/// @brief Appends a round pair to a contact list if it is closer than the contact distance.
+/// @param list List to append to.
+/// @param pair Tested pair.
+/// @param normal Unit normal from the first component to the second.
+/// @param depth Penetration depth of the pair.
+static inline void PhysicsNarrowphase_AddRound(PHYSICS_CONTACT_LIST *list, const PHYSICS_PAIR *pair, Vector3 normal, float depth)
+{
+    if (depth <= -PHYSICS_CONTACT_DISTANCE)
+    {
+        return;
+    }
+
+    PHYSICS_CONTACT *contact = &list->contacts[list->count++];
+    contact->first = pair->first;
+    contact->second = pair->second;
+    contact->overlap = normal;
+    contact->depth = depth;
+}
+
+/// @brief Sphere vs sphere kernel.
+static void PhysicsNarrowphase_TestSphereSphere(const PHYSICS_PAIR *pairs, RJ_Size pairCount, PHYSICS_CONTACT_LIST *contacts)
+{
+    for (RJ_Size pair = 0; pair < pairCount; pair++)
+    {
+        Entity first = pairs[pair].first;
+        Entity second = pairs[pair].second;
+        float radius1 = Maths_Min(Maths_Min(pColliderSizeX(first), pColliderSizeY(first)), pColliderSizeZ(first)) * 0.5f;
+        float radius2 = Maths_Min(Maths_Min(pColliderSizeX(second), pColliderSizeY(second)), pColliderSizeZ(second)) * 0.5f;
+        Vector3 normal;
+
+        float depth = PhysicsShape_TestSphereSphere(pPosition(first), radius1, pPosition(second), radius2, &normal);
+        PhysicsNarrowphase_AddRound(contacts, &pairs[pair], normal, depth);
+    }
+}
+
+/// @brief Tests a single round shape vs box pair, specialized on the shape and the order by the kernels calling it.
+/// @param list List to append the contact to.
+/// @param pair Pair to test.
+/// @param shape Shape of the round component.
+/// @param isRoundFirst True if the first component is the round one.
+static inline void PhysicsNarrowphase_TestRoundBoxOne(PHYSICS_CONTACT_LIST *list, const PHYSICS_PAIR *pair, PhysicsShape shape, bool isRoundFirst)
+{
+    Entity round = isRoundFirst ? pair->first : pair->second;
+    Entity box = isRoundFirst ? pair->second : pair->first;
+    float radius;
+    float halfSegment;
+    Vector3 normal;
+
+    PhysicsShape_GetRound(shape, pColliderSize(round), &radius, &halfSegment);
+    float depth = PhysicsShape_TestRoundBox(pPosition(round), radius, halfSegment, pPosition(box), pColliderSize(box), &normal);
+    PhysicsNarrowphase_AddRound(list, pair, isRoundFirst ? normal : Vector3G_Scale(normal, -1.0f), depth);
+}
+
+/// @brief Sphere vs box kernel.
+static void PhysicsNarrowphase_TestSphereBox(const PHYSICS_PAIR *pairs, RJ_Size pairCount, PHYSICS_CONTACT_LIST *contacts)
+{
+    for (RJ_Size pair = 0; pair < pairCount; pair++)
+    {
+        PhysicsNarrowphase_TestRoundBoxOne(contacts, &pairs[pair], PhysicsShape_Sphere, true);
+    }
+}
+
+/// @brief Box vs sphere kernel, static boxes are always the first of a pair.
+static void PhysicsNarrowphase_TestBoxSphere(const PHYSICS_PAIR *pairs, RJ_Size pairCount, PHYSICS_CONTACT_LIST *contacts)
+{
+    for (RJ_Size pair = 0; pair < pairCount; pair++)
+    {
+        PhysicsNarrowphase_TestRoundBoxOne(contacts, &pairs[pair], PhysicsShape_Sphere, false);
+    }
+}
+
+/// @brief Capsule vs box kernel.
+static void PhysicsNarrowphase_TestCapsuleBox(const PHYSICS_PAIR *pairs, RJ_Size pairCount, PHYSICS_CONTACT_LIST *contacts)
+{
+    for (RJ_Size pair = 0; pair < pairCount; pair++)
+    {
+        PhysicsNarrowphase_TestRoundBoxOne(contacts, &pairs[pair], PhysicsShape_Capsule, true);
+    }
+}
+
+/// @brief Box vs capsule kernel.
+static void PhysicsNarrowphase_TestBoxCapsule(const PHYSICS_PAIR *pairs, RJ_Size pairCount, PHYSICS_CONTACT_LIST *contacts)
+{
+    for (RJ_Size pair = 0; pair < pairCount; pair++)
+    {
+        PhysicsNarrowphase_TestRoundBoxOne(contacts, &pairs[pair], PhysicsShape_Capsule, false);
+    }
+}
+
+/// @brief Round vs round kernel for the pairs with a capsule, sphere pairs have their own kernel.
+static void PhysicsNarrowphase_TestRoundRound(const PHYSICS_PAIR *pairs, RJ_Size pairCount, PHYSICS_CONTACT_LIST *contacts)
+{
+    for (RJ_Size pair = 0; pair < pairCount; pair++)
+    {
+        Entity first = pairs[pair].first;
+        Entity second = pairs[pair].second;
+        float radius1;
+        float halfSegment1;
+        float radius2;
+        float halfSegment2;
+        Vector3 normal;
+
+        PhysicsShape_GetRound(pShape(first), pColliderSize(first), &radius1, &halfSegment1);
+        PhysicsShape_GetRound(pShape(second), pColliderSize(second), &radius2, &halfSegment2);
+        float depth = PhysicsShape_TestRoundRound(pPosition(first), radius1, halfSegment1, pPosition(second), radius2, halfSegment2, &normal);
+        PhysicsNarrowphase_AddRound(contacts, &pairs[pair], normal, depth);
+    }
+}
+
+/// @brief Narrowphase kernels indexed by shape pair, first shape * PHYSICS_SHAPE_COUNT + second shape. Box pairs use the vector kernel selected for the CPU.
+static const PHYSICS_NARROWPHASE_KERNEL PHYSICS_SHAPE_KERNELS[PHYSICS_SHAPE_PAIR_COUNT] = {
+    NULL, PhysicsNarrowphase_TestBoxSphere, PhysicsNarrowphase_TestBoxCapsule,
+    PhysicsNarrowphase_TestSphereBox, PhysicsNarrowphase_TestSphereSphere, PhysicsNarrowphase_TestRoundRound,
+    PhysicsNarrowphase_TestCapsuleBox, PhysicsNarrowphase_TestRoundRound, PhysicsNarrowphase_TestRoundRound,
+};
+
+/// @brief Groups the pairs of a list by shape pair with a counting sort that keeps their order inside a group, so every kernel runs over a continuous range of homogeneous pairs.
+/// @param pairs Pair list to group, its group starts are set.
+/// @note Without round components every pair is a box pair and the list is left as it is.
+static void PhysicsNarrowphase_GroupPairs(PHYSICS_PAIR_LIST *pairs)
+{
+    RJ_Size *starts = pairs->groupStarts;
+    memset(starts, 0, sizeof(pairs->groupStarts));
+
+    if (PHYSICS.narrowphase.roundCount == 0)
+    {
+        for (RJ_Size group = 1; group <= PHYSICS_SHAPE_PAIR_COUNT; group++)
+        {
+            starts[group] = pairs->count;
+        }
+
+        return;
+    }
+
+    for (RJ_Size pair = 0; pair < pairs->count; pair++)
+    {
+        starts[pShape(pairs->pairs[pair].first) * PHYSICS_SHAPE_COUNT + pShape(pairs->pairs[pair].second) + 1]++;
+    }
+
+    for (RJ_Size group = 0; group < PHYSICS_SHAPE_PAIR_COUNT; group++)
+    {
+        starts[group + 1] += starts[group];
+    }
+
+    PHYSICS_PAIR_LIST *grouped = &PHYSICS.narrowphase.grouped;
+
+    if (!pReserve(PHYSICS_PAIR, grouped->pairs, grouped->capacity, pairs->count))
+    {
+        // only the box pairs are kept, packed in place in their order, round pairs can not be tested without their group
+        PHYSICS.droppedCount += pairs->count - starts[1];
+        pairs->count = 0;
+
+        for (RJ_Size pair = 0; pair < starts[PHYSICS_SHAPE_PAIR_COUNT]; pair++)
+        {
+            if (pShape(pairs->pairs[pair].first) == PhysicsShape_Box && pShape(pairs->pairs[pair].second) == PhysicsShape_Box)
+            {
+                pairs->pairs[pairs->count++] = pairs->pairs[pair];
+            }
+        }
+
+        for (RJ_Size group = 1; group <= PHYSICS_SHAPE_PAIR_COUNT; group++)
+        {
+            starts[group] = pairs->count;
+        }
+
+        return;
+    }
+
+    RJ_Size cursors[PHYSICS_SHAPE_PAIR_COUNT];
+    memcpy(cursors, starts, sizeof(cursors));
+
+    for (RJ_Size pair = 0; pair < pairs->count; pair++)
+    {
+        const PHYSICS_PAIR *current = &pairs->pairs[pair];
+        grouped->pairs[cursors[pShape(current->first) * PHYSICS_SHAPE_COUNT + pShape(current->second)]++] = *current;
+    }
+
+    PHYSICS_PAIR *swappedPairs = pairs->pairs;
+    RJ_Size swappedCapacity = pairs->capacity;
+
+    pairs->pairs = grouped->pairs;
+    pairs->capacity = grouped->capacity;
+    grouped->pairs = swappedPairs;
+    grouped->capacity = swappedCapacity;
+}
+
+/// @brief Narrowphase task, tests a range of the pair list given as user data with the kernel of every shape pair group it covers. Contacts of the range are written starting from the index of its first pair, so no two tasks write to the same place.
+static void PhysicsNarrowphase_Task(void *userData, RJ_Size taskIndex, RJ_Size firstPair, RJ_Size pairCount)
+{
+    const PHYSICS_PAIR_LIST *pairs = (const PHYSICS_PAIR_LIST *)userData;
+    PHYSICS_CONTACT_LIST *contacts = pairs == &PHYSICS.broadphase.dynamicPairs ? &PHYSICS.narrowphase.dynamicContacts : &PHYSICS.narrowphase.staticContacts;
+    PHYSICS_CONTACT_LIST range = {.count = 0, .capacity = pairCount, .contacts = contacts->contacts + firstPair};
+
+    for (RJ_Size group = 0; group < PHYSICS_SHAPE_PAIR_COUNT; group++)
+    {
+        RJ_Size first = Maths_Max(pairs->groupStarts[group], firstPair);
+        RJ_Size end = Maths_Min(pairs->groupStarts[group + 1], firstPair + pairCount);
+
+        if (first < end)
+        {
+            PHYSICS_NARROWPHASE_KERNEL kernel = group == 0 ? PHYSICS.kernels.narrowphase : PHYSICS_SHAPE_KERNELS[group];
+            kernel(pairs->pairs + first, end - first, &range);
+        }
+    }
+
+    PHYSICS.narrowphase.taskFirstContacts[taskIndex] = firstPair;
+    PHYSICS.narrowphase.taskContactCounts[taskIndex] = range.count;
+}
+
+/// @brief Tests every candidate pair with the selected narrowphase kernel and packs the overlapping ones into a contact list. Overlaps are computed from the position lanes.
+/// @param pairs Candidate pairs from the broadphase, either the dynamic or the static pair list.
+/// @param contacts Contact list to fill, cleared first.
+/// @note Pairs are split between the threads, the ranges are then packed in order so the contact order does not depend on the thread count.
+static void PhysicsNarrowphase_Collect(const PHYSICS_PAIR_LIST *pairs, PHYSICS_CONTACT_LIST *contacts)
+{
+    contacts->count = 0;
+
+    // every pair may write a contact at its own index, so only the pairs the contacts fit for are tested
+    RJ_Size pairCount = pReserve(PHYSICS_CONTACT, contacts->contacts, contacts->capacity, pairs->count) ? pairs->count : contacts->capacity;
+    PHYSICS.droppedCount += pairs->count - pairCount;
+
+    PhysicsWorld_ParallelFor(pairCount, PHYSICS_PARALLEL_PAIR_GRANULARITY, PhysicsNarrowphase_Task, (void *)pairs);
+
+    for (RJ_Size task = 0; task < ThreadPool_GetThreadCount(PHYSICS.threadPool); task++)
+    {
+        RJ_Size taskCount = PHYSICS.narrowphase.taskContactCounts[task];
+
+        if (taskCount > 0 && PHYSICS.narrowphase.taskFirstContacts[task] != contacts->count)
+        {
+            memmove(contacts->contacts + contacts->count, contacts->contacts + PHYSICS.narrowphase.taskFirstContacts[task], sizeof(PHYSICS_CONTACT) * taskCount);
+        }
+
+        contacts->count += taskCount;
+    }
+}
+
+#pragma endregion Narrowphase
+
+#pragma region Triggers
+
+/// @brief Removes the contacts involving a trigger from a contact list so they are never resolved, and reports the penetrating ones.
+/// @param contacts Contact list to filter, kept in order.
+/// @param isReported True on the first resolve iteration, later iterations only filter so an overlap is reported once per step.
+static void PhysicsTrigger_Extract(PHYSICS_CONTACT_LIST *contacts, bool isReported)
+{
+    if (PHYSICS.trigger.count == 0)
+    {
+        return;
+    }
+
+    RJ_Size keptCount = 0;
+
+    for (RJ_Size contact = 0; contact < contacts->count; contact++)
+    {
+        const PHYSICS_CONTACT *current = &contacts->contacts[contact];
+
+        if (!pIsTrigger(current->first) && !pIsTrigger(current->second))
+        {
+            contacts->contacts[keptCount++] = *current;
+            continue;
+        }
+
+        if (isReported && current->depth > 0.0f)
+        {
+            if (!pReserve(PhysicsTriggerOverlap, PHYSICS.trigger.overlaps, PHYSICS.trigger.overlapCapacity, PHYSICS.trigger.overlapCount + 1))
+            {
+                PHYSICS.droppedCount++;
+                continue;
+            }
+
+            PHYSICS.trigger.overlaps[PHYSICS.trigger.overlapCount++] = pIsTrigger(current->first)
+                                                                           ? (PhysicsTriggerOverlap){rEntity(current->first), rEntity(current->second)}
+                                                                           : (PhysicsTriggerOverlap){rEntity(current->second), rEntity(current->first)};
+        }
+    }
+
+    contacts->count = keptCount;
+}
+
+#pragma endregion Triggers
+
+#pragma region Solver
+
+/// @brief Greedy colors the contacts so no two contacts of a color share a dynamic component, then sorts them by color keeping their order inside a color.
+/// @param contacts Contacts to color and sort.
+/// @param isFirstStatic True if the first component of every contact is static. Static components are only read so they do not constrain the colors.
+/// @note Contacts that find no free color go to the last color, which is resolved on a single thread.
+static void PhysicsSolver_Color(PHYSICS_CONTACT_LIST *contacts, bool isFirstStatic)
+{
+    const uint64_t serialColor = PHYSICS_SOLVER_COLOR_COUNT - 1;
+    const uint64_t parallelColors = (UINT64_C(1) << serialColor) - 1;
+
+    memset(PHYSICS.solver.colorStarts, 0, sizeof(PHYSICS.solver.colorStarts));
+
+    if (!pReserve(uint8_t, PHYSICS.solver.contactColors, PHYSICS.solver.contactColorCapacity, contacts->count) ||
+        !pReserve(PHYSICS_CONTACT, PHYSICS.solver.sortedContacts.contacts, PHYSICS.solver.sortedContacts.capacity, contacts->count))
+    {
+        // unsorted contacts are all resolved by the serial color, slower but nothing is dropped
+        PHYSICS.solver.colorStarts[PHYSICS_SOLVER_COLOR_COUNT] = contacts->count;
+        return;
+    }
+
+    for (RJ_Size contact = 0; contact < contacts->count; contact++)
+    {
+        PHYSICS.solver.bodyColors[contacts->contacts[contact].first] = 0;
+        PHYSICS.solver.bodyColors[contacts->contacts[contact].second] = 0;
+    }
+
+    for (RJ_Size contact = 0; contact < contacts->count; contact++)
+    {
+        Entity first = contacts->contacts[contact].first;
+        Entity second = contacts->contacts[contact].second;
+
+        uint64_t usedColors = PHYSICS.solver.bodyColors[second] | (isFirstStatic ? 0 : PHYSICS.solver.bodyColors[first]);
+        uint64_t freeColors = ~usedColors & parallelColors;
+        uint64_t color = freeColors != 0 ? (uint64_t)__builtin_ctzll(freeColors) : serialColor;
+
+        if (color != serialColor)
+        {
+            PHYSICS.solver.bodyColors[first] |= UINT64_C(1) << color;
+            PHYSICS.solver.bodyColors[second] |= UINT64_C(1) << color;
+        }
+
+        PHYSICS.solver.contactColors[contact] = (uint8_t)color;
+        PHYSICS.solver.colorStarts[color + 1]++;
+    }
+
+    for (RJ_Size color = 0; color < PHYSICS_SOLVER_COLOR_COUNT; color++)
+    {
+        PHYSICS.solver.colorStarts[color + 1] += PHYSICS.solver.colorStarts[color];
+    }
+
+    RJ_Size colorCursors[PHYSICS_SOLVER_COLOR_COUNT];
+    memcpy(colorCursors, PHYSICS.solver.colorStarts, sizeof(colorCursors));
+
+    for (RJ_Size contact = 0; contact < contacts->count; contact++)
+    {
+        PHYSICS.solver.sortedContacts.contacts[colorCursors[PHYSICS.solver.contactColors[contact]]++] = contacts->contacts[contact];
+    }
+
+    PHYSICS_CONTACT *sorted = PHYSICS.solver.sortedContacts.contacts;
+    RJ_Size sortedCapacity = PHYSICS.solver.sortedContacts.capacity;
+
+    PHYSICS.solver.sortedContacts.contacts = contacts->contacts;
+    PHYSICS.solver.sortedContacts.capacity = contacts->capacity;
+    contacts->contacts = sorted;
+    contacts->capacity = sortedCapacity;
+}
+
+/// @brief Solver task, resolves a range of the dynamic contacts given as user data.
+static void PhysicsSolver_DynamicTask(void *userData, RJ_Size taskIndex, RJ_Size firstContact, RJ_Size contactCount)
+{
+    const PHYSICS_CONTACT *contacts = (const PHYSICS_CONTACT *)userData + firstContact;
+
+    for (RJ_Size contact = 0; contact < contactCount; contact++)
+    {
+        PHYSICS.solver.taskIsPenetrating[taskIndex] |= PhysicsScene_ResolveDynamicVsDynamic(&contacts[contact]);
+    }
+}
+
+/// @brief Solver task, resolves a range of the static contacts given as user data.
+static void PhysicsSolver_StaticTask(void *userData, RJ_Size taskIndex, RJ_Size firstContact, RJ_Size contactCount)
+{
+    const PHYSICS_CONTACT *contacts = (const PHYSICS_CONTACT *)userData + firstContact;
+
+    for (RJ_Size contact = 0; contact < contactCount; contact++)
+    {
+        PHYSICS.solver.taskIsPenetrating[taskIndex] |= PhysicsScene_ResolveStaticVsDynamic(&contacts[contact]);
+    }
+}
+
+/// @brief Colors and resolves a contact list color by color. Contacts of a color are split between the threads, the last color runs on the calling thread.
+/// @param contacts Contacts to resolve.
+/// @param isFirstStatic True for the static contact list.
+/// @note Contacts of a color touch different dynamic components so their order does not change the result, which makes the result independent from the thread count.
+static void PhysicsSolver_Resolve(PHYSICS_CONTACT_LIST *contacts, bool isFirstStatic)
+{
+    ThreadPoolTask task = isFirstStatic ? PhysicsSolver_StaticTask : PhysicsSolver_DynamicTask;
+
+    PhysicsCache_Attach(contacts);
+    PhysicsSolver_Color(contacts, isFirstStatic);
+
+    for (RJ_Size color = 0; color < PHYSICS_SOLVER_COLOR_COUNT; color++)
+    {
+        RJ_Size first = PHYSICS.solver.colorStarts[color];
+        RJ_Size count = PHYSICS.solver.colorStarts[color + 1] - first;
+
+        if (count == 0)
+        {
+            continue;
+        }
+
+        if (color == PHYSICS_SOLVER_COLOR_COUNT - 1)
+        {
+            task(contacts->contacts, 0, first, count);
+        }
+        else
+        {
+            PhysicsWorld_ParallelFor(count, PHYSICS_PARALLEL_CONTACT_GRANULARITY, task, contacts->contacts + first);
+        }
+    }
+}
+
+#pragma endregion Solver
+
+#pragma region Snapshots
+
+/// @brief Fixed part of a snapshot, followed by the dense arrays it describes. Only the state the next step reads is kept, scratch buffers and grids that are rebuilt from it are not.
+typedef struct PHYSICS_SNAPSHOT_HEADER
+{
+    RJ_Size size;           // total size of the snapshot in bytes
+    RJ_Size entityMapChunkCount; // allocated chunks of the entity to component map, saved whole
+    RJ_Size count;
+    RJ_Size staticCount;
+    RJ_Size awakeStart;
+    RJ_Size cacheCapacity;         // slot count of the current contact cache table, saved whole so slots and their order match
+    RJ_Size cacheCount;
+    RJ_Size previousCacheCapacity; // the other table is emptied by the next step, only its capacity decides the slots
+    RJ_Size endpointCount;         // sweep and prune endpoints per axis, their order decides the pair order for equal values
+    RJ_Size nextIslandId;
+    RJ_Size staticGridVersion;
+    RJ_Size continuousCount;
+    RJ_Size triggerCount;
+    RJ_Size roundCount;
+    RJ_Size eventFrame;
+    float continuousDeltaTime;
+    bool isWarmStarted;
+    bool isStaticDirty;
+    bool isSweepDirty;
+} PHYSICS_SNAPSHOT_HEADER;
+
+/// @brief Cursor over a snapshot buffer. Every byte is XORed with the byte at the same offset of the base snapshot if there is one, bytes past the base are kept as they are.
+typedef struct PHYSICS_SNAPSHOT_STREAM
+{
+    uint8_t *bytes; // NULL only measures the size
+    const uint8_t *base;
+    RJ_Size baseSize;
+    RJ_Size offset;
+    bool isSaving;
+} PHYSICS_SNAPSHOT_STREAM;
+
+/// @brief XORs bytes with the base snapshot bytes at the same offset.
+/// @param bytes Bytes to XOR in place.
+/// @param size Number of bytes.
+/// @param stream Stream holding the base and the offset of the bytes.
+static inline void PhysicsSnapshot_Xor(uint8_t *bytes, RJ_Size size, const PHYSICS_SNAPSHOT_STREAM *stream)
+{
+    if (stream->base == NULL || stream->offset >= stream->baseSize)
+    {
+        return;
+    }
+
+    const uint8_t *base = stream->base + stream->offset;
+    RJ_Size baseSize = Maths_Min(size, stream->baseSize - stream->offset);
+
+    for (RJ_Size i = 0; i < baseSize; i++)
+    {
+        bytes[i] ^= base[i];
+    }
+}
+
+/// @brief Copies a section between the state and the snapshot in the direction of the stream, then advances it.
+/// @param stream Stream to transfer with.
+/// @param data State the section is copied from or to.
+/// @param size Size of the section in bytes.
+static void PhysicsSnapshot_Transfer(PHYSICS_SNAPSHOT_STREAM *stream, void *data, RJ_Size size)
+{
+    if (stream->bytes != NULL && size > 0)
+    {
+        uint8_t *target = stream->isSaving ? stream->bytes + stream->offset : (uint8_t *)data;
+
+        memcpy(target, stream->isSaving ? data : stream->bytes + stream->offset, size);
+        PhysicsSnapshot_Xor(target, size, stream);
     }
+
+    stream->offset += size;
+}
+
+/// @brief Transfers the dense arrays of a snapshot. Shared by measuring, saving and restoring so the layout is written once.
+/// @param stream Stream to transfer with, positioned after the header.
+/// @param header Header holding the counts of the arrays.
+static void PhysicsSnapshot_TransferArrays(PHYSICS_SNAPSHOT_STREAM *stream, const PHYSICS_SNAPSHOT_HEADER *header)
+{
+    RJ_Size count = header->count;
+
+    for (RJ_Size chunk = 0; chunk < header->entityMapChunkCount; chunk++)
+    {
+        PhysicsSnapshot_Transfer(stream, PHYSICS.data.entityToCompMap.chunks[chunk], sizeof(Entity) * ENTITY_CHUNK_SIZE);
+    }
+
+    PhysicsSnapshot_Transfer(stream, PHYSICS.data.compToEntityMap, sizeof(Entity) * count);
+
+    for (RJ_Size column = 0; column < PHYSICS_LANE_COLUMN_COUNT; column++)
+    {
+        PhysicsSnapshot_Transfer(stream, PHYSICS.data.laneMemory + column * PHYSICS.data.laneCapacity, sizeof(float) * count);
+    }
+
+    PhysicsSnapshot_Transfer(stream, PHYSICS.data.masses, sizeof(float) * count);
+    PhysicsSnapshot_Transfer(stream, PHYSICS.data.flags, sizeof(uint8_t) * count);
+    PhysicsSnapshot_Transfer(stream, PHYSICS.data.layers, sizeof(uint32_t) * count);
+    PhysicsSnapshot_Transfer(stream, PHYSICS.data.masks, sizeof(uint32_t) * count);
+
+    // sleeping components keep the bounds they fell asleep with, the sleeping grid is rebuilt from them
+    PhysicsSnapshot_Transfer(stream, PHYSICS.broadphase.bounds, sizeof(PHYSICS_BOUNDS) * count);
+    PhysicsSnapshot_Transfer(stream, PHYSICS.sleep.restSteps, sizeof(uint16_t) * count);
+    PhysicsSnapshot_Transfer(stream, PHYSICS.sleep.islandIds, sizeof(RJ_Size) * count);
+
+    PhysicsSnapshot_Transfer(stream, PHYSICS.cache.tables[PHYSICS.cache.current].entries, sizeof(PHYSICS_CACHE_ENTRY) * header->cacheCapacity);
+
+    for (RJ_Size axis = 0; axis < 3; axis++)
+    {
+        PhysicsSnapshot_Transfer(stream, PHYSICS.broadphase.sweep.endpoints[axis], sizeof(PHYSICS_ENDPOINT) * header->endpointCount);
+    }
+}
+
+/// @brief Fills a header from the current state.
+/// @param retHeader Header to fill, its size is measured too.
+static void PhysicsSnapshot_FillHeader(PHYSICS_SNAPSHOT_HEADER *retHeader)
+{
+    memset(retHeader, 0, sizeof(PHYSICS_SNAPSHOT_HEADER)); // padding is part of the bytes, keep it out of the deltas
+
+    retHeader->entityMapChunkCount = PHYSICS.data.entityToCompMap.chunkCount;
+    retHeader->count = PHYSICS.data.count;
+    retHeader->staticCount = PHYSICS.data.staticCount;
+    retHeader->awakeStart = PHYSICS.data.awakeStart;
+    retHeader->cacheCapacity = PHYSICS.cache.tables[PHYSICS.cache.current].capacity;
+    retHeader->cacheCount = PHYSICS.cache.tables[PHYSICS.cache.current].count;
+    retHeader->previousCacheCapacity = PHYSICS.cache.tables[PHYSICS.cache.current ^ 1].capacity;
+    retHeader->endpointCount = PHYSICS.broadphase.sweep.endpointCount;
+    retHeader->nextIslandId = PHYSICS.sleep.nextIslandId;
+    retHeader->staticGridVersion = PHYSICS.broadphase.staticGridVersion;
+    retHeader->continuousCount = PHYSICS.continuous.count;
+    retHeader->triggerCount = PHYSICS.trigger.count;
+    retHeader->roundCount = PHYSICS.narrowphase.roundCount;
+    retHeader->eventFrame = PHYSICS.events.frame;
+    retHeader->continuousDeltaTime = PHYSICS.continuous.deltaTime;
+    retHeader->isWarmStarted = PHYSICS.cache.isWarmStarted;
+    retHeader->isStaticDirty = PHYSICS.broadphase.isStaticDirty;
+    retHeader->isSweepDirty = PHYSICS.broadphase.sweep.isDirty;
+
+    PHYSICS_SNAPSHOT_STREAM measure = {.offset = sizeof(PHYSICS_SNAPSHOT_HEADER)};
+    PhysicsSnapshot_TransferArrays(&measure, retHeader);
+    retHeader->size = measure.offset;
+}
+
+/// @brief Resizes a contact cache table to a saved capacity and empties it.
+/// @param table Table to resize.
+/// @param capacity Capacity to resize to, 0 frees the table.
+/// @return RJ_OK / RJ_ERROR_ALLOCATION
+static RJ_Result PhysicsSnapshot_ResizeCache(PHYSICS_CACHE_TABLE *table, RJ_Size capacity)
+{
+    if (table->capacity != capacity)
+    {
+        free(table->entries);
+        table->entries = NULL;
+        table->capacity = 0;
+
+        if (capacity > 0)
+        {
+            RJ_ReturnAllocate(PHYSICS_CACHE_ENTRY, table->entries, capacity);
+        }
+
+        table->capacity = capacity;
+    }
+
+    for (RJ_Size slot = 0; slot < table->capacity; slot++)
+    {
+        table->entries[slot].key = PHYSICS_CACHE_EMPTY_KEY;
+    }
+
+    table->count = 0;
+    return RJ_OK;
+}
+
+#pragma endregion Snapshots
+
+
+/// @brief Patches every entity a world stores after Entity_Compact moved them, registered for every initialized world.
+/// @param world World to patch.
+/// @param remap New entity of every old entity, RJ_INDEX_INVALID for destroyed ones.
+/// @param slotCount Number of old entities in remap.
+static void PhysicsScene_RemapEntities(void *world, const Entity *remap, RJ_Size slotCount)
+{
+    PhysicsWorld *previous = Physics_SetWorld(world == &PHYSICS_DEFAULT_WORLD ? NULL : (PhysicsWorld *)world);
+
+    EntityMap_Remap(&PHYSICS.data.entityToCompMap, remap, slotCount);
+
+    for (Entity component = 0; component < PHYSICS.data.count; component++)
+    {
+        rEntity(component) = remap[rEntity(component)];
+    }
+
+    PhysicsCache_Remap(&PHYSICS.cache.tables[0], remap);
+    PhysicsCache_Remap(&PHYSICS.cache.tables[1], remap);
+
+    for (RJ_Size event = 0; event < PHYSICS.events.count; event++)
+    {
+        PHYSICS.events.events[event].first = remap[PHYSICS.events.events[event].first];
+        PHYSICS.events.events[event].second = remap[PHYSICS.events.events[event].second];
+    }
+
+    for (RJ_Size overlap = 0; overlap < PHYSICS.trigger.overlapCount; overlap++)
+    {
+        PHYSICS.trigger.overlaps[overlap].trigger = remap[PHYSICS.trigger.overlaps[overlap].trigger];
+        PHYSICS.trigger.overlaps[overlap].other = remap[PHYSICS.trigger.overlaps[overlap].other];
+    }
+
+    Physics_SetWorld(previous);
+}
+
+/// @brief Frees every buffer of the system and clears it. Buffers that are not allocated yet are NULL, so it is also used to clean up a failed initialization.
+static void PhysicsScene_FreeBuffers(void)
+{
+    Entity_RemapCallbackRemove(PhysicsScene_RemapEntities, PHYSICS_WORLD);
+
+    EntityMap_Destroy(&PHYSICS.data.entityToCompMap);
+    free(PHYSICS.data.compToEntityMap);
+    RJ_FreeAligned(PHYSICS.data.laneMemory);
+    free(PHYSICS.data.masses);
+    free(PHYSICS.data.flags);
+    free(PHYSICS.data.layers);
+    free(PHYSICS.data.masks);
+
+    free(PHYSICS.broadphase.bounds);
+    free(PHYSICS.broadphase.isOversized);
+    free(PHYSICS.broadphase.grid.oversized);
+    free(PHYSICS.broadphase.grid.bucketStarts);
+    free(PHYSICS.broadphase.grid.entries);
+    free(PHYSICS.broadphase.staticGrid.oversized);
+    free(PHYSICS.broadphase.staticGrid.bucketStarts);
+    free(PHYSICS.broadphase.staticGrid.entries);
+    free(PHYSICS.broadphase.dynamicPairs.pairs);
+    free(PHYSICS.broadphase.staticPairs.pairs);
+
+    for (RJ_Size axis = 0; axis < 3; axis++)
+    {
+        free(PHYSICS.broadphase.sweep.endpoints[axis]);
+    }
+
+    free(PHYSICS.broadphase.sweep.active);
+    free(PHYSICS.broadphase.sweep.activeIndices);
+
+    free(PHYSICS.narrowphase.dynamicContacts.contacts);
+    free(PHYSICS.narrowphase.staticContacts.contacts);
+    free(PHYSICS.narrowphase.grouped.pairs);
+
+    free(PHYSICS.solver.bodyColors);
+    free(PHYSICS.solver.contactColors);
+    free(PHYSICS.solver.sortedContacts.contacts);
+
+    free(PHYSICS.cache.tables[0].entries);
+    free(PHYSICS.cache.tables[1].entries);
+
+    free(PHYSICS.sleep.restSteps);
+    free(PHYSICS.sleep.islandIds);
+    free(PHYSICS.sleep.islandParents);
+    free(PHYSICS.sleep.islandRestSteps);
+    free(PHYSICS.sleep.transitions);
+    free(PHYSICS.sleep.sleepingGrid.oversized);
+    free(PHYSICS.sleep.sleepingGrid.bucketStarts);
+    free(PHYSICS.sleep.sleepingGrid.entries);
+    free(PHYSICS.sleep.wakePairs.pairs);
+
+    free(PHYSICS.continuous.impactTimes);
+
+    free(PHYSICS.trigger.overlaps);
+
+    free(PHYSICS.events.events);
+
+    memset(&PHYSICS, 0, sizeof(PHYSICS));
+}
+
+/// @brief Selects the widest integration and narrowphase kernels the running CPU supports.
+static void PhysicsKernel_Select(void)
+{
+#if RJ_ARCHITECTURE == RJ_ARCHITECTURE_X64 && !PHYSICS_FORCE_SCALAR
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        PHYSICS.kernels.integrate = PhysicsKernel_IntegrateAVX2;
+        PHYSICS.kernels.narrowphase = PhysicsNarrowphase_TestAVX2;
+        PHYSICS.kernels.name = "AVX2";
+        return;
+    }
+
+    PHYSICS.kernels.integrate = PhysicsKernel_IntegrateSSE;
+    PHYSICS.kernels.narrowphase = PhysicsNarrowphase_TestSSE;
+    PHYSICS.kernels.name = "SSE";
+#else
+    PHYSICS.kernels.integrate = PhysicsKernel_IntegrateScalar;
+    PHYSICS.kernels.narrowphase = PhysicsNarrowphase_TestScalar;
+    PHYSICS.kernels.name = "scalar";
+#endif
+}
+
+#pragma endregion Source Only
+
+RJ_ResultWarn PhysicsWorld_Create(PhysicsWorld **retWorld)
+{
+    RJ_DebugAssertNullPointerCheck(retWorld);
+
+    PhysicsWorld *world = NULL;
+    RJ_ReturnAllocate(PhysicsWorld, world, 1);
+
+    *retWorld = world;
+    return RJ_OK;
+}
+
+void PhysicsWorld_Destroy(PhysicsWorld *world)
+{
+    if (world == NULL)
+    {
+        return;
+    }
+
+    PhysicsWorld *previous = Physics_SetWorld(world);
+
+    ThreadPool_Destroy(PHYSICS.threadPool);
+    PhysicsScene_FreeBuffers();
+
+    Physics_SetWorld(previous == world ? NULL : previous);
+    free(world);
+}
+
+PhysicsWorld *Physics_SetWorld(PhysicsWorld *world)
+{
+    PhysicsWorld *previous = Physics_GetWorld();
+
+    PHYSICS_WORLD = world == NULL ? &PHYSICS_DEFAULT_WORLD : world;
+    return previous;
+}
+
+PhysicsWorld *Physics_GetWorld(void)
+{
+    return PHYSICS_WORLD == &PHYSICS_DEFAULT_WORLD ? NULL : PHYSICS_WORLD;
+}
+
+RJ_ResultWarn Physics_Initialize(RJ_Size initialComponentCapacity, PhysicsBroadphase broadphase, float drag, float gravity, float elasticity)
+{
+    PHYSICS.data.capacity = initialComponentCapacity;
+    PHYSICS.data.count = 0;
+    PHYSICS.data.staticCount = 0;
+    PHYSICS.data.awakeStart = 0;
+
+    PHYSICS.broadphase.type = broadphase;
+    PHYSICS.broadphase.sweep.isDirty = true;
+    PHYSICS.broadphase.isStaticDirty = true;
+    PHYSICS.sleep.isSleepingDirty = true;
+    PHYSICS.query.isDirty = true;
+
+    PHYSICS.properties.drag = drag;
+    PHYSICS.properties.gravity = gravity;
+    PHYSICS.properties.elasticity = elasticity;
+    EntityMap_Create(&PHYSICS.data.entityToCompMap, sizeof(Entity), 0xff);
+
+    RJ_ReturnAllocate(Entity, PHYSICS.data.compToEntityMap, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    PHYSICS.data.laneCapacity = (PHYSICS.data.capacity + PHYSICS_LANE_WIDTH - 1) / PHYSICS_LANE_WIDTH * PHYSICS_LANE_WIDTH;
+
+    RJ_ReturnAllocateAligned(float, PHYSICS.data.laneMemory, PHYSICS.data.laneCapacity * PHYSICS_LANE_COLUMN_COUNT, PHYSICS_LANE_ALIGNMENT,
+                             PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(float, PHYSICS.data.masses, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(uint8_t, PHYSICS.data.flags, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(uint32_t, PHYSICS.data.layers, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(uint32_t, PHYSICS.data.masks, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(PHYSICS_BOUNDS, PHYSICS.broadphase.bounds, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(uint8_t, PHYSICS.broadphase.isOversized, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(uint64_t, PHYSICS.solver.bodyColors, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(uint16_t, PHYSICS.sleep.restSteps, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(RJ_Size, PHYSICS.sleep.islandIds, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(RJ_Size, PHYSICS.sleep.islandParents, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(uint16_t, PHYSICS.sleep.islandRestSteps, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(Entity, PHYSICS.sleep.transitions, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_ReturnAllocate(float, PHYSICS.continuous.impactTimes, PHYSICS.data.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    PHYSICS.events.capacity = PHYSICS_CONTACT_EVENT_DEFAULT_CAPACITY;
+    RJ_ReturnAllocate(PhysicsContactEvent, PHYSICS.events.events, PHYSICS.events.capacity,
+                      PhysicsScene_FreeBuffers(););
+
+    RJ_Result result = Entity_RemapCallbackAdd(PhysicsScene_RemapEntities, PHYSICS_WORLD);
+    if (result != RJ_OK)
+    {
+        PhysicsScene_FreeBuffers();
+        return result;
+    }
+
+    PhysicsScene_AssignLanes();
+    PhysicsKernel_Select();
+
+    memset(PHYSICS.data.compToEntityMap, 0xff, sizeof(Entity) * initialComponentCapacity);
+
+    RJ_DebugInfo("Physics initialized with component capacity %u, using %s kernels.", PHYSICS.data.capacity, PHYSICS.kernels.name);
+
+    return RJ_OK;
+}
+
+void Physics_Terminate(void)
+{
+    ThreadPool_Destroy(PHYSICS.threadPool);
+    PhysicsScene_FreeBuffers();
+
+    RJ_DebugInfo("Physics terminated successfully.");
+}
+
+bool Physics_IsInitialized(void)
+{
+    return PHYSICS.data.capacity > 0;
+}
+
+RJ_ResultWarn Physics_SetThreadCount(RJ_Size threadCount)
+{
+    RJ_DebugAssert(threadCount > 0 && threadCount <= THREAD_POOL_MAX_THREAD_COUNT, "Physics thread count %u must be in [1, %u].", threadCount, THREAD_POOL_MAX_THREAD_COUNT);
+
+    ThreadPool_Destroy(PHYSICS.threadPool);
+    PHYSICS.threadPool = NULL;
+
+    if (threadCount > 1)
+    {
+        RJ_Result result = ThreadPool_Create(&PHYSICS.threadPool, threadCount);
+
+        if (result != RJ_OK)
+        {
+            RJ_DebugWarning("Physics thread pool creation failed, physics step stays on a single thread.");
+            return result;
+        }
+    }
+
+    RJ_DebugInfo("Physics step configured to run on %u threads.", threadCount);
+    return RJ_OK;
+}
+
+RJ_ResultWarn Physics_Resize(RJ_Size newCapacity)
+{
+    if (newCapacity < PHYSICS.data.count || newCapacity == 0)
+    {
+        RJ_DebugWarning("New physics component capacity %u can not hold the %u components.", newCapacity, PHYSICS.data.count);
+        return RJ_ERROR_CAPACITY;
+    }
+
+    RJ_Size oldCapacity = PHYSICS.data.capacity;
+    RJ_Size oldLaneCapacity = PHYSICS.data.laneCapacity;
+    RJ_Size newLaneCapacity = (newCapacity + PHYSICS_LANE_WIDTH - 1) / PHYSICS_LANE_WIDTH * PHYSICS_LANE_WIDTH;
+
+    if (newLaneCapacity != oldLaneCapacity)
+    {
+        // the columns are laneCapacity floats apart, so the block is laid out again instead of reallocated
+        float *laneMemory = NULL;
+        RJ_ReturnAllocateAligned(float, laneMemory, newLaneCapacity * PHYSICS_LANE_COLUMN_COUNT, PHYSICS_LANE_ALIGNMENT);
+
+        for (RJ_Size column = 0; column < PHYSICS_LANE_COLUMN_COUNT; column++)
+        {
+            memcpy(laneMemory + column * newLaneCapacity, PHYSICS.data.laneMemory + column * oldLaneCapacity, sizeof(float) * Maths_Min(oldLaneCapacity, newLaneCapacity));
+        }
+
+        RJ_FreeAligned(PHYSICS.data.laneMemory);
+        PHYSICS.data.laneMemory = laneMemory;
+        PHYSICS.data.laneCapacity = newLaneCapacity;
+        PhysicsScene_AssignLanes();
+    }
+
+    // a failure below leaves every buffer holding at least the smaller capacity, so that one stays usable
+    PHYSICS.data.capacity = Maths_Min(oldCapacity, newCapacity);
+
+    RJ_ReturnResize(Entity, PHYSICS.data.compToEntityMap, oldCapacity, newCapacity, 0xff);
+    RJ_ReturnResize(float, PHYSICS.data.masses, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(uint8_t, PHYSICS.data.flags, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(uint32_t, PHYSICS.data.layers, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(uint32_t, PHYSICS.data.masks, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(PHYSICS_BOUNDS, PHYSICS.broadphase.bounds, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(uint8_t, PHYSICS.broadphase.isOversized, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(uint64_t, PHYSICS.solver.bodyColors, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(uint16_t, PHYSICS.sleep.restSteps, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(RJ_Size, PHYSICS.sleep.islandIds, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(RJ_Size, PHYSICS.sleep.islandParents, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(uint16_t, PHYSICS.sleep.islandRestSteps, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(Entity, PHYSICS.sleep.transitions, oldCapacity, newCapacity, 0);
+    RJ_ReturnResize(float, PHYSICS.continuous.impactTimes, oldCapacity, newCapacity, 0);
+
+    PHYSICS.data.capacity = newCapacity;
+
+    RJ_DebugInfo("Physics resized to component capacity %u.", newCapacity);
+    return RJ_OK;
+}
+
+bool Physics_IsColliding(Entity entity1, Entity entity2, Vector3 *overlapRet)
+{
+    pAssertEntity(entity1);
+    pAssertEntity(entity2);
+
+    Vector3 position1 = PhysicsScene_GetEntityPosition(entity1);
+    Vector3 position2 = PhysicsScene_GetEntityPosition(entity2);
+
+    Vector3 colliderSize1 = pColliderSize(rComponent(entity1));
+    Vector3 colliderSize2 = pColliderSize(rComponent(entity2));
+
+    Vector3 overlap = Vector3_Zero;
+
+    if (pIsRoundPair(rComponent(entity1), rComponent(entity2)))
+    {
+        float depth = PhysicsShape_Test(pShape(rComponent(entity1)), position1, colliderSize1, pShape(rComponent(entity2)), position2, colliderSize2, &overlap);
+
+        if (overlapRet != NULL)
+        {
+            *overlapRet = Vector3G_Scale(overlap, depth);
+        }
+
+        return depth > 0.0f;
+    }
+
+    overlap.x = Maths_Min(position1.x + colliderSize1.x / 2.0f,
+                          position2.x + colliderSize2.x / 2.0f) -
+                Maths_Max(position1.x - colliderSize1.x / 2.0f,
+                          position2.x - colliderSize2.x / 2.0f);
+
+    overlap.y = Maths_Min(position1.y + colliderSize1.y / 2.0f,
+                          position2.y + colliderSize2.y / 2.0f) -
+                Maths_Max(position1.y - colliderSize1.y / 2.0f,
+                          position2.y - colliderSize2.y / 2.0f);
+
+    overlap.z = Maths_Min(position1.z + colliderSize1.z / 2.0f,
+                          position2.z + colliderSize2.z / 2.0f) -
+                Maths_Max(position1.z - colliderSize1.z / 2.0f,
+                          position2.z - colliderSize2.z / 2.0f);
+
+    if (overlapRet != NULL)
+    {
+        *overlapRet = overlap;
+    }
+
+    return overlap.x > 0.0f && overlap.y > 0.0f && overlap.z > 0.0f;
+}
+
+void Physics_UpdateComponents(float deltaTime)
+{
+    uint64_t lapStart = pStatsNow();
+    pStatsSet(integrateNanoseconds, 0);
+
+    PhysicsCache_WarmStart();
+    PHYSICS.continuous.deltaTime = deltaTime;
+    PHYSICS.query.isDirty = true;
+    PhysicsWorld_ParallelFor(PHYSICS.data.count - PHYSICS.data.awakeStart, PHYSICS_PARALLEL_COMPONENT_GRANULARITY, PhysicsKernel_IntegrateTask, &deltaTime);
+
+    pStatsLap(integrateNanoseconds, lapStart);
 }
 
 void Physics_ResolveCollisions(void)
 {
+    PHYSICS.events.frame++;
+    PHYSICS.events.count = 0;
+    PHYSICS.events.droppedCount = 0;
+    PHYSICS.droppedCount = 0;
+
+    uint64_t lapStart = pStatsNow();
+    pStatsSet(broadphaseNanoseconds, 0);
+    pStatsSet(narrowphaseNanoseconds, 0);
+    pStatsSet(resolveNanoseconds, 0);
+    pStatsSet(pairsOverlapping, 0);
+    pStatsSet(staticSkips, PHYSICS.data.awakeStart);
+    pStatsSet(iterations, 0);
+
+    PhysicsScene_UpdateBroadphase();
+    pStatsSet(pairsConsidered, PHYSICS.broadphase.dynamicPairs.count + PHYSICS.broadphase.staticPairs.count);
+    pStatsLap(broadphaseNanoseconds, lapStart);
+
+    PhysicsContinuous_Clamp();
+    PhysicsNarrowphase_GroupPairs(&PHYSICS.broadphase.dynamicPairs);
+    PhysicsNarrowphase_GroupPairs(&PHYSICS.broadphase.staticPairs);
+    pStatsLap(narrowphaseNanoseconds, lapStart);
+
+    PhysicsCache_BeginStep();
+
+    PHYSICS.trigger.overlapCount = 0;
+
     for (RJ_Size iteration = 0; iteration < PHYSICS_COLLISION_RESOLVE_ITERATIONS; iteration++)
     {
-        for (Entity firstComponent = 0; firstComponent < PHYSICS.data.count; firstComponent++)
+        memset(PHYSICS.solver.taskIsPenetrating, 0, sizeof(PHYSICS.solver.taskIsPenetrating));
+        pStatsSet(iterations, iteration + 1);
+        pStatsLap(resolveNanoseconds, lapStart);
+
+        PhysicsNarrowphase_Collect(&PHYSICS.broadphase.dynamicPairs, &PHYSICS.narrowphase.dynamicContacts);
+        PhysicsTrigger_Extract(&PHYSICS.narrowphase.dynamicContacts, iteration == 0);
+        pStatsLap(narrowphaseNanoseconds, lapStart);
+
+        PhysicsSolver_Resolve(&PHYSICS.narrowphase.dynamicContacts, false);
+        pStatsLap(resolveNanoseconds, lapStart);
+
+        PhysicsNarrowphase_Collect(&PHYSICS.broadphase.staticPairs, &PHYSICS.narrowphase.staticContacts);
+        PhysicsTrigger_Extract(&PHYSICS.narrowphase.staticContacts, iteration == 0);
+        pStatsLap(narrowphaseNanoseconds, lapStart);
+
+        PhysicsSolver_Resolve(&PHYSICS.narrowphase.staticContacts, true);
+
+        if (iteration == 0)
         {
-            for (Entity secondComponent = firstComponent + 1; secondComponent < PHYSICS.data.count; secondComponent++)
-            {
-                PhysicsScene_ResolveCollision(firstComponent, secondComponent);
-            }
+            pStatsSet(pairsOverlapping, PHYSICS.narrowphase.dynamicContacts.count + PHYSICS.narrowphase.staticContacts.count);
+        }
+
+        bool isPenetrating = false;
+
+        for (RJ_Size task = 0; task < ThreadPool_GetThreadCount(PHYSICS.threadPool); task++)
+        {
+            isPenetrating |= PHYSICS.solver.taskIsPenetrating[task];
+        }
+
+        if (!isPenetrating)
+        {
+            break; // nothing was pushed apart, further iterations would find the same contacts
         }
     }
+
+    PHYSICS.cache.isWarmStarted = false;
+    PHYSICS.continuous.deltaTime = 0.0f;
+
+    PhysicsScene_ScatterPositions(PHYSICS.data.awakeStart, PHYSICS.data.count - PHYSICS.data.awakeStart);
+
+    PhysicsSleep_Update();
+    PhysicsCache_EndStep();
+
+    PHYSICS.query.isDirty = true;
+
+    pStatsLap(resolveNanoseconds, lapStart);
 }
 
 void Physics_ComponentCreate(Entity entity, Vector3 colliderSize, float mass, bool isStatic)
 {
-    RJ_DebugAssert(PHYSICS.data.count < PHYSICS.data.capacity, "Maximum physics component capacity of %u reached.", PHYSICS.data.capacity);
+    if (PHYSICS.data.count == PHYSICS.data.capacity && Physics_Resize(Maths_Max(PHYSICS.data.capacity * PHYSICS_BUFFER_RESIZE_MULTIPLIER, PHYSICS_LANE_WIDTH)) != RJ_OK)
+    {
+        RJ_DebugWarning("Physics component capacity of %u could not grow, component is not created.", PHYSICS.data.capacity);
+        return;
+    }
+
+    if (EntityMap_Reserve(&PHYSICS.data.entityToCompMap, entity) != RJ_OK)
+    {
+        RJ_DebugWarning("Physics entity map could not grow to Entity %u, component is not created.", entity);
+        return;
+    }
 
     Entity component = PHYSICS.data.count;
 
     rComponent(entity) = component;
     rEntity(component) = entity;
 
-    pColliderSize(component) = colliderSize;
+    pSetVelocity(component, Vector3_Zero);
+    pSetColliderSize(component, colliderSize);
     pMass(component) = mass;
+    pDrag(component) = PHYSICS.properties.drag;
+    pGravityScale(component) = 1.0f;
+    pRestitution(component) = PHYSICS.properties.elasticity;
+    pFriction(component) = 0.0f;
+    pFlag(component) = 0;
     pSetStatic(component, isStatic);
+    pLayer(component) = PHYSICS_LAYER_DEFAULT;
+    pMask(component) = PHYSICS_MASK_ALL;
+
+    PHYSICS.sleep.restSteps[component] = 0;
 
     PHYSICS.data.count++;
+
+    if (isStatic)
+    {
+        PhysicsScene_MoveToPartition(component, PHYSICS_PARTITION_STATIC);
+        PHYSICS.broadphase.isStaticDirty = true;
+    }
+
+    PHYSICS.broadphase.sweep.isDirty = true;
+    PHYSICS.query.isDirty = true;
 }
 
 void Physics_ComponentDestroy(Entity entity)
 {
     pAssertEntity(entity);
 
-    pVelocity(rComponent(entity)) = Vector3_Zero;
-    pColliderSize(rComponent(entity)) = Vector3_Zero;
-    pMass(rComponent(entity)) = 0.0f;
-    pFlag(rComponent(entity)) = false;
+    Entity component = rComponent(entity);
+
+    if (pIsStatic(component))
+    {
+        PHYSICS.broadphase.isStaticDirty = true;
+    }
+    else if (pIsSleeping(component))
+    {
+        // the rest of the island may be resting on it
+        PhysicsSleep_WakeIslands(&PHYSICS.sleep.islandIds[component], 1);
+    }
+
+    PhysicsCache_Forget(entity);
+
+    component = PhysicsScene_MoveToPartition(rComponent(entity), PHYSICS_PARTITION_AWAKE);
+    PhysicsScene_SwapComponents(component, PHYSICS.data.count - 1);
+    component = PHYSICS.data.count - 1;
+
+    pSetVelocity(component, Vector3_Zero);
+    pSetColliderSize(component, Vector3_Zero);
+    pMass(component) = 0.0f;
+    pDrag(component) = 0.0f;
+    pGravityScale(component) = 0.0f;
+    pRestitution(component) = 0.0f;
+    pFriction(component) = 0.0f;
+
+    if (pIsContinuous(component))
+    {
+        PHYSICS.continuous.count--;
+    }
+
+    if (pIsTrigger(component))
+    {
+        PHYSICS.trigger.count--;
+    }
+
+    if (pShape(component) != PhysicsShape_Box)
+    {
+        PHYSICS.narrowphase.roundCount--;
+    }
+
+    pFlag(component) = 0;
+    pLayer(component) = 0;
+    pMask(component) = 0;
 
-    rEntity(rComponent(entity)) = RJ_INDEX_INVALID;
+    rEntity(component) = RJ_INDEX_INVALID;
     rComponent(entity) = RJ_INDEX_INVALID;
 
     PHYSICS.data.count--;
+    PHYSICS.broadphase.sweep.isDirty = true;
+    PHYSICS.query.isDirty = true;
 }
 
 bool Physics_ComponentValidate(Entity entity)
 {
-    return (rComponent(entity) < PHYSICS.data.count);
+    return EntityMap_Has(PHYSICS.data.entityToCompMap, entity) && rComponent(entity) < PHYSICS.data.count;
 }
 
 Vector3 Physics_ComponentGetVelocity(Entity entity)
@@ -428,7 +4258,8 @@ Vector3 Physics_ComponentGetVelocity(Entity entity)
 void Physics_ComponentSetVelocity(Entity entity, Vector3 newVelocity)
 {
     pAssertEntity(entity);
-    pVelocity(rComponent(entity)) = newVelocity;
+    Physics_ComponentWake(entity);
+    pSetVelocity(rComponent(entity), newVelocity);
 }
 
 Vector3 Physics_ComponentGetColliderSize(Entity entity)
@@ -440,7 +4271,15 @@ Vector3 Physics_ComponentGetColliderSize(Entity entity)
 void Physics_ComponentSetColliderSize(Entity entity, Vector3 newColliderSize)
 {
     pAssertEntity(entity);
-    pColliderSize(rComponent(entity)) = newColliderSize;
+    Physics_ComponentWake(entity);
+    pSetColliderSize(rComponent(entity), newColliderSize);
+
+    if (pIsStatic(rComponent(entity)))
+    {
+        PHYSICS.broadphase.isStaticDirty = true;
+    }
+
+    PHYSICS.query.isDirty = true;
 }
 
 float Physics_ComponentGetMass(Entity entity)
@@ -455,6 +4294,26 @@ void Physics_ComponentSetMass(Entity entity, float newMass)
     pMass(rComponent(entity)) = newMass;
 }
 
+PhysicsMaterial Physics_ComponentGetMaterial(Entity entity)
+{
+    pAssertEntity(entity);
+
+    Entity component = rComponent(entity);
+    return (PhysicsMaterial){pDrag(component), pGravityScale(component), pRestitution(component), pFriction(component)};
+}
+
+void Physics_ComponentSetMaterial(Entity entity, PhysicsMaterial newMaterial)
+{
+    pAssertEntity(entity);
+    Physics_ComponentWake(entity);
+
+    Entity component = rComponent(entity);
+    pDrag(component) = newMaterial.drag;
+    pGravityScale(component) = newMaterial.gravityScale;
+    pRestitution(component) = newMaterial.restitution;
+    pFriction(component) = newMaterial.friction;
+}
+
 bool Physics_ComponentIsStatic(Entity entity)
 {
     pAssertEntity(entity);
@@ -464,5 +4323,407 @@ bool Physics_ComponentIsStatic(Entity entity)
 void Physics_ComponentSetStatic(Entity entity, bool newIsStatic)
 {
     pAssertEntity(entity);
+
+    if ((bool)pIsStatic(rComponent(entity)) == newIsStatic)
+    {
+        return;
+    }
+
+    Physics_ComponentWake(entity);
+    PhysicsScene_MoveToPartition(rComponent(entity), newIsStatic ? PHYSICS_PARTITION_STATIC : PHYSICS_PARTITION_AWAKE);
+
     pSetStatic(rComponent(entity), newIsStatic);
+    pSetVelocity(rComponent(entity), Vector3_Zero);
+    PHYSICS.sleep.restSteps[rComponent(entity)] = 0;
+
+    PHYSICS.broadphase.isStaticDirty = true;
+    PHYSICS.broadphase.sweep.isDirty = true;
+    PHYSICS.query.isDirty = true;
+}
+
+bool Physics_ComponentIsContinuous(Entity entity)
+{
+    pAssertEntity(entity);
+    return pIsContinuous(rComponent(entity));
+}
+
+void Physics_ComponentSetContinuous(Entity entity, bool newIsContinuous)
+{
+    pAssertEntity(entity);
+
+    if ((bool)pIsContinuous(rComponent(entity)) == newIsContinuous)
+    {
+        return;
+    }
+
+    pSetContinuous(rComponent(entity), newIsContinuous);
+    PHYSICS.continuous.count = newIsContinuous ? PHYSICS.continuous.count + 1 : PHYSICS.continuous.count - 1;
+}
+
+uint32_t Physics_ComponentGetLayer(Entity entity)
+{
+    pAssertEntity(entity);
+    return pLayer(rComponent(entity));
+}
+
+uint32_t Physics_ComponentGetMask(Entity entity)
+{
+    pAssertEntity(entity);
+    return pMask(rComponent(entity));
+}
+
+void Physics_ComponentSetLayer(Entity entity, uint32_t newLayer, uint32_t newMask)
+{
+    pAssertEntity(entity);
+
+    pLayer(rComponent(entity)) = newLayer;
+    pMask(rComponent(entity)) = newMask;
+}
+
+bool Physics_ComponentIsTrigger(Entity entity)
+{
+    pAssertEntity(entity);
+    return pIsTrigger(rComponent(entity));
+}
+
+void Physics_ComponentSetTrigger(Entity entity, bool newIsTrigger)
+{
+    pAssertEntity(entity);
+
+    if ((bool)pIsTrigger(rComponent(entity)) == newIsTrigger)
+    {
+        return;
+    }
+
+    Physics_ComponentWake(entity);
+    pSetTrigger(rComponent(entity), newIsTrigger);
+    PHYSICS.trigger.count = newIsTrigger ? PHYSICS.trigger.count + 1 : PHYSICS.trigger.count - 1;
+}
+
+PhysicsShape Physics_ComponentGetShape(Entity entity)
+{
+    pAssertEntity(entity);
+    return pShape(rComponent(entity));
+}
+
+void Physics_ComponentSetShape(Entity entity, PhysicsShape newShape)
+{
+    pAssertEntity(entity);
+    RJ_DebugAssert(newShape >= PhysicsShape_Box && newShape <= PhysicsShape_Capsule, "Invalid physics shape %d.", (int)newShape);
+
+    PhysicsShape shape = pShape(rComponent(entity));
+
+    if (shape == newShape)
+    {
+        return;
+    }
+
+    Physics_ComponentWake(entity);
+    pSetShape(rComponent(entity), newShape);
+
+    if (shape == PhysicsShape_Box)
+    {
+        PHYSICS.narrowphase.roundCount++;
+    }
+    else if (newShape == PhysicsShape_Box)
+    {
+        PHYSICS.narrowphase.roundCount--;
+    }
+}
+
+RJ_Size Physics_GetTriggerOverlaps(const PhysicsTriggerOverlap **retOverlaps)
+{
+    RJ_DebugAssertNullPointerCheck(retOverlaps);
+
+    *retOverlaps = PHYSICS.trigger.overlaps;
+    return PHYSICS.trigger.overlapCount;
+}
+
+bool Physics_Raycast(Vector3 origin, Vector3 direction, float maxDistance, uint32_t layerMask, PhysicsRaycastHit *retHit)
+{
+    RJ_DebugAssertNullPointerCheck(retHit);
+
+    float magnitude = Vector3_Magnitude(direction);
+    RJ_DebugAssert(magnitude > 0.0f, "Raycast direction can not be zero.");
+
+    PhysicsQuery_Refresh();
+
+    float origins[3] = {origin.x, origin.y, origin.z};
+    float directions[3] = {direction.x / magnitude, direction.y / magnitude, direction.z / magnitude};
+
+    PhysicsRaycastHit hit = {.entity = RJ_INDEX_INVALID, .distance = maxDistance};
+
+    PhysicsQuery_RaycastGrid(&PHYSICS.broadphase.staticGrid, origins, directions, layerMask, &hit);
+    PhysicsQuery_RaycastGrid(&PHYSICS.sleep.sleepingGrid, origins, directions, layerMask, &hit);
+    PhysicsQuery_RaycastGrid(&PHYSICS.broadphase.grid, origins, directions, layerMask, &hit);
+
+    if (hit.entity == RJ_INDEX_INVALID)
+    {
+        return false;
+    }
+
+    hit.point = Vector3_New(origins[0] + directions[0] * hit.distance, origins[1] + directions[1] * hit.distance, origins[2] + directions[2] * hit.distance);
+    *retHit = hit;
+
+    return true;
+}
+
+RJ_Size Physics_QueryAABB(Vector3 center, Vector3 size, uint32_t layerMask, Entity *retEntities, RJ_Size entityCapacity)
+{
+    RJ_DebugAssert(retEntities != NULL || entityCapacity == 0, "Query result buffer can not be NULL with capacity %u.", entityCapacity);
+
+    PhysicsQuery_Refresh();
+
+    Vector3 halfSize = Vector3G_Scale(size, 0.5f);
+    PHYSICS_BOUNDS query = {Vector3G_Sum(center, Vector3G_Scale(halfSize, -1.0f)), Vector3G_Sum(center, halfSize)};
+    RJ_Size count = 0;
+
+    PhysicsQuery_OverlapGrid(&PHYSICS.broadphase.staticGrid, &query, layerMask, retEntities, entityCapacity, &count);
+    PhysicsQuery_OverlapGrid(&PHYSICS.sleep.sleepingGrid, &query, layerMask, retEntities, entityCapacity, &count);
+    PhysicsQuery_OverlapGrid(&PHYSICS.broadphase.grid, &query, layerMask, retEntities, entityCapacity, &count);
+
+    return count;
+}
+
+Entity Physics_QueryNearest(Vector3 point, float maxDistance, uint32_t layerMask, Entity ignoredEntity, float *retDistance)
+{
+    PhysicsQuery_Refresh();
+
+    Entity ignoredComponent = ignoredEntity != RJ_INDEX_INVALID && Physics_ComponentValidate(ignoredEntity) ? rComponent(ignoredEntity) : RJ_INDEX_INVALID;
+    Entity nearest = RJ_INDEX_INVALID;
+    float nearestDistance = maxDistance;
+
+    PhysicsQuery_NearestGrid(&PHYSICS.broadphase.staticGrid, point, layerMask, ignoredComponent, &nearest, &nearestDistance);
+    PhysicsQuery_NearestGrid(&PHYSICS.sleep.sleepingGrid, point, layerMask, ignoredComponent, &nearest, &nearestDistance);
+    PhysicsQuery_NearestGrid(&PHYSICS.broadphase.grid, point, layerMask, ignoredComponent, &nearest, &nearestDistance);
+
+    if (nearest == RJ_INDEX_INVALID)
+    {
+        return RJ_INDEX_INVALID;
+    }
+
+    if (retDistance != NULL)
+    {
+        *retDistance = nearestDistance;
+    }
+
+    return rEntity(nearest);
+}
+
+RJ_ResultWarn Physics_SetContactEventCapacity(RJ_Size capacity)
+{
+    free(PHYSICS.events.events);
+    PHYSICS.events.events = NULL;
+    PHYSICS.events.count = 0;
+    PHYSICS.events.capacity = 0;
+
+    if (capacity > 0)
+    {
+        RJ_ReturnAllocate(PhysicsContactEvent, PHYSICS.events.events, capacity);
+    }
+
+    PHYSICS.events.capacity = capacity;
+
+    RJ_DebugInfo("Physics contact event buffer resized to %u events.", capacity);
+    return RJ_OK;
+}
+
+RJ_Size Physics_GetContactEvents(const PhysicsContactEvent **retEvents)
+{
+    RJ_DebugAssertNullPointerCheck(retEvents);
+
+    *retEvents = PHYSICS.events.events;
+    return PHYSICS.events.count;
+}
+
+RJ_Size Physics_GetDroppedContactEventCount(void)
+{
+    return PHYSICS.events.droppedCount;
+}
+
+RJ_Size Physics_GetDroppedCollisionCount(void)
+{
+    return PHYSICS.droppedCount;
+}
+
+void Physics_GetPairCounts(RJ_Size *retCandidatePairCount, RJ_Size *retContactCount)
+{
+    if (retCandidatePairCount != NULL)
+    {
+        *retCandidatePairCount = PHYSICS.broadphase.dynamicPairs.count + PHYSICS.broadphase.staticPairs.count;
+    }
+
+    if (retContactCount != NULL)
+    {
+        *retContactCount = PHYSICS.narrowphase.dynamicContacts.count + PHYSICS.narrowphase.staticContacts.count;
+    }
+}
+
+void Physics_GetStats(PhysicsStats *retStats)
+{
+    RJ_DebugAssertNullPointerCheck(retStats);
+
+    *retStats = PHYSICS.stats;
+}
+
+RJ_Size Physics_SnapshotGetSize(void)
+{
+    PHYSICS_SNAPSHOT_HEADER header;
+    PhysicsSnapshot_FillHeader(&header);
+
+    return header.size;
+}
+
+RJ_ResultWarn Physics_SnapshotSave(void *retBuffer, RJ_Size bufferSize, const void *base, RJ_Size baseSize)
+{
+    RJ_DebugAssertNullPointerCheck(retBuffer);
+
+    PHYSICS_SNAPSHOT_HEADER header;
+    PhysicsSnapshot_FillHeader(&header);
+
+    if (header.size > bufferSize)
+    {
+        RJ_DebugWarning("Physics snapshot needs %u bytes but the buffer has %u.", header.size, bufferSize);
+        return RJ_ERROR_CAPACITY;
+    }
+
+    PHYSICS_SNAPSHOT_STREAM stream = {.bytes = retBuffer, .base = base, .baseSize = base == NULL ? 0 : baseSize, .isSaving = true};
+
+    PhysicsSnapshot_Transfer(&stream, &header, sizeof(PHYSICS_SNAPSHOT_HEADER));
+    PhysicsSnapshot_TransferArrays(&stream, &header);
+
+    return RJ_OK;
+}
+
+RJ_ResultWarn Physics_SnapshotRestore(const void *buffer, RJ_Size bufferSize, const void *base, RJ_Size baseSize)
+{
+    RJ_DebugAssertNullPointerCheck(buffer);
+
+    // restoring never writes to the buffer, the cast only shares the stream with saving
+    PHYSICS_SNAPSHOT_STREAM stream = {.bytes = (uint8_t *)buffer, .base = base, .baseSize = base == NULL ? 0 : baseSize, .isSaving = false};
+    PHYSICS_SNAPSHOT_HEADER header;
+
+    if (bufferSize < sizeof(PHYSICS_SNAPSHOT_HEADER))
+    {
+        RJ_DebugWarning("Physics snapshot of %u bytes is smaller than its header.", bufferSize);
+        return RJ_ERROR_CAPACITY;
+    }
+
+    PhysicsSnapshot_Transfer(&stream, &header, sizeof(PHYSICS_SNAPSHOT_HEADER));
+
+    if (header.size != bufferSize || header.entityMapChunkCount > ENTITY_MAX_CHUNK_COUNT)
+    {
+        RJ_DebugWarning("Physics snapshot does not match the system, %u bytes for %u components and %u entity chunks.", header.size, header.count, header.entityMapChunkCount);
+        return RJ_ERROR_INTERNAL;
+    }
+
+    if (header.count > PHYSICS.data.capacity)
+    {
+        RJ_Result resizeResult = Physics_Resize(header.count);
+
+        if (resizeResult != RJ_OK)
+        {
+            return resizeResult;
+        }
+    }
+
+    EntityMap *entityToCompMap = &PHYSICS.data.entityToCompMap;
+
+    if (header.entityMapChunkCount > 0)
+    {
+        RJ_Result mapResult = EntityMap_Reserve(entityToCompMap, header.entityMapChunkCount * ENTITY_CHUNK_SIZE - 1);
+
+        if (mapResult != RJ_OK)
+        {
+            return mapResult;
+        }
+    }
+
+    PHYSICS_SWEEP *sweep = &PHYSICS.broadphase.sweep;
+
+    if (!PhysicsSweep_Reserve(sweep, header.endpointCount, header.count, header.count))
+    {
+        return RJ_ERROR_ALLOCATION;
+    }
+
+    // the caches are resized last, so a failure leaves at most an empty cache behind
+    RJ_Result result = PhysicsSnapshot_ResizeCache(&PHYSICS.cache.tables[PHYSICS.cache.current], header.cacheCapacity);
+
+    if (result == RJ_OK)
+    {
+        result = PhysicsSnapshot_ResizeCache(&PHYSICS.cache.tables[PHYSICS.cache.current ^ 1], header.previousCacheCapacity);
+    }
+
+    if (result != RJ_OK)
+    {
+        PHYSICS.cache.tables[PHYSICS.cache.current].count = 0;
+        PHYSICS.cache.isWarmStarted = false;
+        return result;
+    }
+
+    PhysicsSnapshot_TransferArrays(&stream, &header);
+
+    // chunks added after the snapshot held no component then
+    for (RJ_Size chunk = header.entityMapChunkCount; chunk < entityToCompMap->chunkCount; chunk++)
+    {
+        memset(entityToCompMap->chunks[chunk], 0xff, sizeof(Entity) * ENTITY_CHUNK_SIZE);
+    }
+
+    PHYSICS.data.count = header.count;
+    PHYSICS.data.staticCount = header.staticCount;
+    PHYSICS.data.awakeStart = header.awakeStart;
+    PHYSICS.cache.tables[PHYSICS.cache.current].count = header.cacheCount;
+    PHYSICS.cache.isWarmStarted = header.isWarmStarted;
+    sweep->endpointCount = header.endpointCount;
+    sweep->isDirty = header.isSweepDirty;
+    PHYSICS.sleep.nextIslandId = header.nextIslandId;
+    PHYSICS.continuous.count = header.continuousCount;
+    PHYSICS.continuous.deltaTime = header.continuousDeltaTime;
+    PHYSICS.trigger.count = header.triggerCount;
+    PHYSICS.narrowphase.roundCount = header.roundCount;
+    PHYSICS.trigger.overlapCount = 0;
+    PHYSICS.events.frame = header.eventFrame;
+    PHYSICS.events.count = 0;
+    PHYSICS.events.droppedCount = 0;
+    PHYSICS.droppedCount = 0;
+
+    PhysicsScene_ScatterPositions(0, PHYSICS.data.count);
+
+    PHYSICS.broadphase.isStaticDirty = header.isStaticDirty;
+
+    if (!header.isStaticDirty && header.staticGridVersion != PHYSICS.broadphase.staticGridVersion)
+    {
+        PHYSICS.broadphase.isStaticDirty = !PhysicsScene_BuildStaticGrid();
+    }
+
+    PHYSICS.broadphase.staticGridVersion = header.staticGridVersion;
+    PHYSICS.sleep.isSleepingDirty = true;
+    PHYSICS.query.isDirty = true;
+
+    return RJ_OK;
+}
+
+void Physics_InvalidateStatics(void)
+{
+    PHYSICS.broadphase.isStaticDirty = true;
+    PHYSICS.query.isDirty = true;
+}
+
+bool Physics_ComponentIsSleeping(Entity entity)
+{
+    pAssertEntity(entity);
+    return pIsSleeping(rComponent(entity));
+}
+
+void Physics_ComponentWake(Entity entity)
+{
+    pAssertEntity(entity);
+
+    if (pIsSleeping(rComponent(entity)))
+    {
+        RJ_Size islandId = PHYSICS.sleep.islandIds[rComponent(entity)];
+        PhysicsSleep_WakeIslands(&islandId, 1);
+    }
+
+    PHYSICS.query.isDirty = true;
 }
@@ -14,6 +14,11 @@
 
 #define RENDERER_OPENGL_DRAW_TYPE GL_DYNAMIC_DRAW
 
+/// @brief Initial capacity of the moving entity list, it grows with the entity count.
+#define RENDERER_INITIAL_MOTION_CAPACITY 256
+/// @brief Growth factor of the batch and component capacities when they are full.
+#define RENDERER_RESIZE_MULTIPLIER 2
+
 #pragma region Source Only
 
 #pragma region typedefs
@@ -76,9 +81,17 @@ struct RENDERER
         RJ_Size capacity;
         RJ_Size count;
 
-        RendererEntityPair *entityToPairMap;
+        EntityMap entityToPairMap; // RendererEntityPair, both indices RJ_INDEX_INVALID for entities without a component
     } pairs;
 
+    struct RENDERER_MOTION
+    {
+        EntityChangeListener changes;
+
+        ListArray entities; // Entity, entities whose object matrix is interpolated every update, until their previous and world positions meet
+        EntityMap isMoving; // bool
+    } motion;
+
     struct RENDERER_CAMERA
     {
         RendererCamera cam;
@@ -118,11 +131,16 @@ struct RENDERER
 } RENDERER = {0};
 
 #define rBatch(batch) (RENDERER.data.batches[batch])
-#define rPair(entity) (RENDERER.pairs.entityToPairMap[entity])
+#define rPair(entity) (EntityMap_At(RENDERER.pairs.entityToPairMap, RendererEntityPair, entity))
 #define rEntity(pair) (rBatch((pair).batch).data.compToEntityMap[(pair).component])
 
 #define rObjectMatrix(pair) (rBatch((pair).batch).data.objectMatrices[(pair).component])
 
+#define rHasComponent(entity) (EntityMap_Has(RENDERER.pairs.entityToPairMap, entity) &&              \
+                               rPair(entity).batch < RENDERER.data.count &&                          \
+                               rPair(entity).component < rBatch(rPair(entity).batch).data.count && \
+                               rEntity(rPair(entity)) == (entity))
+
 #define rAssertBatch(batch) RJ_DebugAssert((batch) < RENDERER.data.count,                       \
                                            "Renderer batch %u exceeds maximum batch count %u.", \
                                            (batch), RENDERER.data.count)
@@ -179,18 +197,93 @@ static void RENDERER_MAIN_WINDOW_LOG_CALLBACK(GLenum source, GLenum type, GLuint
     }
 }
 
+/// @brief Adds an entity to the moving entities if it is not already one.
+/// @param entity Entity to add.
+static void Renderer_MotionAdd(Entity entity)
+{
+    if (!EntityMap_At(RENDERER.motion.isMoving, bool, entity))
+    {
+        EntityMap_At(RENDERER.motion.isMoving, bool, entity) = true;
+        ListArray_Add(&RENDERER.motion.entities, &entity);
+    }
+}
+
+/// @brief Patches every entity the renderer stores after Entity_Compact moved them.
+/// @param userData Unused.
+/// @param remap New entity of every old entity, RJ_INDEX_INVALID for destroyed ones.
+/// @param slotCount Number of old entities in remap.
+static void Renderer_RemapEntities(void *userData, const Entity *remap, RJ_Size slotCount)
+{
+    (void)userData;
+
+    EntityMap_Remap(&RENDERER.pairs.entityToPairMap, remap, slotCount);
+    EntityMap_Remap(&RENDERER.motion.isMoving, remap, slotCount);
+
+    for (RJ_Size batch = 0; batch < RENDERER.data.count; batch++)
+    {
+        for (RJ_Size component = 0; component < rBatch(batch).data.count; component++)
+        {
+            RendererEntityPair pair = {batch, component};
+
+            if (rEntity(pair) != RJ_INDEX_INVALID)
+            {
+                rEntity(pair) = remap[rEntity(pair)];
+            }
+        }
+    }
+
+    Entity *moving = (Entity *)RENDERER.motion.entities.data;
+    RJ_Size keptCount = 0;
+
+    for (RJ_Size index = 0; index < RENDERER.motion.entities.count; index++)
+    {
+        if (remap[moving[index]] != RJ_INDEX_INVALID)
+        {
+            moving[keptCount++] = remap[moving[index]];
+        }
+    }
+
+    RENDERER.motion.entities.count = keptCount;
+}
+
 #pragma endregion Source Only
 
 #pragma region Renderer
 
 RJ_ResultWarn Renderer_Initialize(RJ_Size initialBatchCapacity)
 {
-    RJ_Size entityCapacity = 0;
-    Entity_GetInternalData(&entityCapacity, NULL);
+    EntityMap_Create(&RENDERER.pairs.entityToPairMap, sizeof(RendererEntityPair), 0xff);
+    EntityMap_Create(&RENDERER.motion.isMoving, sizeof(bool), 0);
 
-    RJ_ReturnAllocate(RendererEntityPair, RENDERER.pairs.entityToPairMap, entityCapacity);
     RJ_ReturnAllocate(RENDERER_BATCH, RENDERER.data.batches, initialBatchCapacity);
 
+    RJ_Result result = ListArray_Create(&RENDERER.motion.entities, "Renderer Moving Entities", sizeof(Entity), RENDERER_INITIAL_MOTION_CAPACITY);
+    if (result != RJ_OK)
+    {
+        free(RENDERER.data.batches);
+        RJ_DebugWarning("Failed to create renderer moving entity list.");
+        return result;
+    }
+
+    result = Entity_ChangeListenerCreate(&RENDERER.motion.changes);
+    if (result != RJ_OK)
+    {
+        free(RENDERER.data.batches);
+        ListArray_Destroy(&RENDERER.motion.entities);
+        RJ_DebugWarning("Failed to create renderer entity change listener.");
+        return result;
+    }
+
+    result = Entity_RemapCallbackAdd(Renderer_RemapEntities, NULL);
+    if (result != RJ_OK)
+    {
+        Entity_ChangeListenerDestroy(RENDERER.motion.changes);
+        free(RENDERER.data.batches);
+        ListArray_Destroy(&RENDERER.motion.entities);
+        RJ_DebugWarning("Failed to register renderer entity remap callback.");
+        return result;
+    }
+
     RENDERER.data.capacity = initialBatchCapacity;
     RENDERER.data.count = 0;
 
@@ -245,8 +338,13 @@ void Renderer_Terminate(void)
         Renderer_BatchDestroy(batch - 1);
     }
 
-    free(RENDERER.pairs.entityToPairMap);
+    Entity_ChangeListenerDestroy(RENDERER.motion.changes);
+    Entity_RemapCallbackRemove(Renderer_RemapEntities, NULL);
+
+    EntityMap_Destroy(&RENDERER.pairs.entityToPairMap);
     free(RENDERER.data.batches);
+    ListArray_Destroy(&RENDERER.motion.entities);
+    EntityMap_Destroy(&RENDERER.motion.isMoving);
 
     if (RENDERER.shader.programHandle != 0)
     {
@@ -398,20 +496,21 @@ Vector3 Renderer_ScreenToWorldSpace(Vector2Int screenPosition, float depth)
     }
 }
 
-/*
-!RJ_ResultWarn Renderer_Resize(RJ_Size newBatchCapacity)
+RJ_ResultWarn Renderer_Resize(RJ_Size newBatchCapacity)
 {
-    RJ_DebugAssert(newBatchCapacity > RENDERER.data.count, "New batch capacity %u is must be greater than current batch count %u.", newBatchCapacity, RENDERER.data.count);
+    if (newBatchCapacity < RENDERER.data.count || newBatchCapacity == 0)
+    {
+        RJ_DebugWarning("New batch capacity %u can not hold the %u batches.", newBatchCapacity, RENDERER.data.count);
+        return RJ_ERROR_CAPACITY;
+    }
 
-    RJ_ReturnAllocate(RendererEntityPair, RENDERER.pairs.entityToPairMap, newBatchCapacity);
-    RJ_ReturnAllocate(RENDERER_BATCH, RENDERER.data.batches, newBatchCapacity);
+    RJ_ReturnResize(RENDERER_BATCH, RENDERER.data.batches, RENDERER.data.capacity, newBatchCapacity, 0);
 
     RENDERER.data.capacity = newBatchCapacity;
 
     RJ_DebugInfo("Renderer resized to new batch capacity of %u successfully.", newBatchCapacity);
     return RJ_OK;
 }
-*/
 
 // todo move this to shader, compute in gpu
 void Renderer_Update(void)
@@ -448,26 +547,55 @@ void Renderer_Update(void)
                   (vec4 *)&RENDERER.camera.projectionMatrix);
     }
 
-    for (RJ_Size batch = 0; batch < RENDERER.data.count; batch++)
+    float interpolationAlpha = RJ_GetFixedStepAlpha();
+    Entity_UpdateTransforms();
+    const EntitySpan *spans = Entity_GetSpans(NULL);
+
+    // only entities whose world transform changed are touched, they stay in the motion list while their interpolated position moves
+    RJ_Size changedCount = 0;
+    const Entity *changed = Entity_GetChangedEntities(RENDERER.motion.changes, &changedCount);
+
+    for (RJ_Size index = 0; index < changedCount; index++)
     {
-        for (RJ_Size component = 0; component < rBatch(batch).data.count; component++)
+        if (rHasComponent(changed[index]))
         {
-            RendererEntityPair pair = {batch, component};
-            // todo send transform data to gpu instead of calculating here
+            Renderer_MotionAdd(changed[index]);
+        }
+    }
+
+    Entity_ClearChangedEntities(RENDERER.motion.changes);
 
-            glm_mat4_identity((vec4 *)&rObjectMatrix(pair));
+    Entity *moving = (Entity *)RENDERER.motion.entities.data;
 
-            Vector3 componentPos = Entity_GetPosition(rEntity(pair));
-            glm_translate((vec4 *)&rObjectMatrix(pair), (float *)&(vec3){componentPos.x, componentPos.y, componentPos.z});
+    for (RJ_Size index = 0; index < RENDERER.motion.entities.count;)
+    {
+        Entity entity = moving[index];
+
+        if (rHasComponent(entity))
+        {
+            // todo send transform data to gpu instead of copying here
+            RendererEntityPair pair = rPair(entity);
 
-            Vector3 componentRot = Entity_GetRotation(rEntity(pair));
-            glm_rotate((vec4 *)&rObjectMatrix(pair), componentRot.x, (float *)&(vec3){1, 0, 0});
-            glm_rotate((vec4 *)&rObjectMatrix(pair), componentRot.y, (float *)&(vec3){0, 1, 0});
-            glm_rotate((vec4 *)&rObjectMatrix(pair), componentRot.z, (float *)&(vec3){0, 0, 1});
+            Vector3 previousPosition = EntitySpan_At(spans, previousPositions, entity);
+            Vector3 worldPosition = EntitySpan_At(spans, worldPositions, entity);
 
-            Vector3 componentScl = Entity_GetScale(rEntity(pair));
-            glm_scale((vec4 *)&rObjectMatrix(pair), (float *)&(vec3){componentScl.x, componentScl.y, componentScl.z});
+            // world matrices come from the entity transform cache, only the translation is interpolated
+            Vector3 componentPos = Vector3_Lerp(previousPosition, worldPosition, interpolationAlpha);
+            rObjectMatrix(pair) = EntitySpan_At(spans, worldMatrices, entity);
+            rObjectMatrix(pair).m[3][0] = componentPos.x;
+            rObjectMatrix(pair).m[3][1] = componentPos.y;
+            rObjectMatrix(pair).m[3][2] = componentPos.z;
+
+            // without a fixed loop the alpha stays 1 and previous positions are never stored, the matrix is final once written
+            if (interpolationAlpha < 1.0f && !Vector3_Compare(componentPos, worldPosition))
+            {
+                index++;
+                continue;
+            }
         }
+
+        EntityMap_At(RENDERER.motion.isMoving, bool, entity) = false;
+        moving[index] = moving[--RENDERER.motion.entities.count];
     }
 }
 
@@ -568,7 +696,16 @@ void Renderer_Render(void)
 
 RJ_ResultWarn Renderer_BatchCreate(RendererBatch *retBatch, StringView modelFile, RJ_Size initialComponentCapacity)
 {
-    RJ_DebugAssert(RENDERER.data.count < RENDERER.data.capacity, "Maximum renderer batch capacity of %u reached.", RENDERER.data.capacity); // todo expand capacity
+    if (RENDERER.data.count == RENDERER.data.capacity)
+    {
+        RJ_Result resizeResult = Renderer_Resize(Maths_Max(RENDERER.data.capacity * RENDERER_RESIZE_MULTIPLIER, 1));
+
+        if (resizeResult != RJ_OK)
+        {
+            RJ_DebugWarning("Renderer batch capacity of %u could not grow.", RENDERER.data.capacity);
+            return resizeResult;
+        }
+    }
 
     RendererBatch newBatch = RENDERER.data.count;
 
@@ -614,41 +751,60 @@ bool Renderer_BatchValidate(RendererBatch batch)
     return batch < RENDERER.data.count;
 }
 
-/*
-!RJ_ResultWarn Renderer_BatchResize(RendererBatch batch, RJ_Size newComponentCapacity)
+RJ_ResultWarn Renderer_BatchResize(RendererBatch batch, RJ_Size newComponentCapacity)
 {
     rAssertBatch(batch);
-    RJ_DebugAssert(newComponentCapacity > rBatch(batch).data.count, "New component capacity %u must be greater than current physics component count %u.", newComponentCapacity, rBatch(batch).data.count);
 
-    rBatch(batch).data.capacity = newComponentCapacity;
+    if (newComponentCapacity < rBatch(batch).data.count || newComponentCapacity == 0)
+    {
+        RJ_DebugWarning("New component capacity %u of batch %u can not hold the %u components.", newComponentCapacity, batch, rBatch(batch).data.count);
+        return RJ_ERROR_CAPACITY;
+    }
 
-    RJ_ReturnReallocate(RJ_Size, rBatch(batch).data.compToEntityMap, newComponentCapacity);
+    RJ_Size oldCapacity = rBatch(batch).data.capacity;
 
-    RJ_ReturnReallocate(Matrix4, rBatch(batch).data.objectMatrices, newComponentCapacity,
-                        free(rBatch(batch).data.compToEntityMap););
+    // a failure below leaves both buffers holding at least the smaller capacity, so that one stays usable
+    rBatch(batch).data.capacity = Maths_Min(oldCapacity, newComponentCapacity);
 
-    memset(rBatch(batch).data.compToEntityMap, 0xff, sizeof(RJ_Size) * newComponentCapacity);
+    RJ_ReturnResize(Entity, rBatch(batch).data.compToEntityMap, oldCapacity, newComponentCapacity, 0xff);
+    RJ_ReturnResize(Matrix4, rBatch(batch).data.objectMatrices, oldCapacity, newComponentCapacity, 0);
+
+    rBatch(batch).data.capacity = newComponentCapacity;
 
     return RJ_OK;
 }
-*/
 
 RJ_ResultWarn Renderer_ComponentCreate(RendererBatch batch, Entity entity)
 {
     rAssertBatch(batch);
 
-    if (rBatch(batch).data.count >= rBatch(batch).data.capacity)
+    if (rBatch(batch).data.count == rBatch(batch).data.capacity)
     {
-        RJ_DebugWarning("Maximum renderer batch %u component capacity of %u reached.", batch, rBatch(batch).data.capacity); // todo expand capacity
-        return RJ_ERROR_CAPACITY;
+        RJ_Result resizeResult = Renderer_BatchResize(batch, Maths_Max(rBatch(batch).data.capacity * RENDERER_RESIZE_MULTIPLIER, 1));
+
+        if (resizeResult != RJ_OK)
+        {
+            RJ_DebugWarning("Renderer batch %u component capacity of %u could not grow.", batch, rBatch(batch).data.capacity);
+            return resizeResult;
+        }
+    }
+
+    if (EntityMap_Reserve(&RENDERER.pairs.entityToPairMap, entity) != RJ_OK || EntityMap_Reserve(&RENDERER.motion.isMoving, entity) != RJ_OK)
+    {
+        RJ_DebugWarning("Renderer entity maps could not grow to Entity %u.", entity);
+        return RJ_ERROR_ALLOCATION;
     }
 
     Entity component = rBatch(batch).data.count;
 
     rEntity(((RendererEntityPair){batch, component})) = entity;
+    rPair(entity) = (RendererEntityPair){batch, component};
 
     rBatch(batch).data.count++;
 
+    // static entities never show up as changed, so the first matrix is written by the next update
+    Renderer_MotionAdd(entity);
+
     return RJ_OK;
 }
 
@@ -659,11 +815,12 @@ void Renderer_ComponentDestroy(Entity entity)
     rEntity(rPair(entity)) = RJ_INDEX_INVALID;
 
     rBatch(rPair(entity).batch).data.count--;
+    rPair(entity) = (RendererEntityPair){RJ_INDEX_INVALID, RJ_INDEX_INVALID};
 }
 
 bool Renderer_ComponentValidate(Entity entity)
 {
-    return (rPair(entity).batch < RENDERER.data.count && rPair(entity).component < rBatch(rPair(entity).batch).data.count);
+    return (EntityMap_Has(RENDERER.pairs.entityToPairMap, entity) && rPair(entity).batch < RENDERER.data.count && rPair(entity).component < rBatch(rPair(entity).batch).data.count);
 }
 
 #pragma endregion Renderer
@@ -1,92 +1,472 @@
 #include "tools/Entity.h"
 
 #include "utilities/ListArray.h"
+#include "utilities/Maths.h"
+
+#include <math.h>
 
 #pragma region Source Only
 
 #define ENTITY_FLAG_ACTIVE (1 << 0)
 
+/// @brief Byte alignment of the chunks, the world matrices come first so they are aligned too.
+#define ENTITY_MATRIX_ALIGNMENT 16
+
+/// @brief Every array of ENTITY_CHUNK_SIZE entities, allocated as one block that never moves.
+typedef struct ENTITY_CHUNK
+{
+    Matrix4 worldMatrices[ENTITY_CHUNK_SIZE];
+
+    // todo move to transform component
+    Vector3 positions[ENTITY_CHUNK_SIZE];
+    Vector3 previousPositions[ENTITY_CHUNK_SIZE]; // world positions at the start of the last fixed step, for interpolation
+    Vector3 rotations[ENTITY_CHUNK_SIZE];
+    Vector3 scales[ENTITY_CHUNK_SIZE];
+    Vector3 worldPositions[ENTITY_CHUNK_SIZE]; // translation of the world matrices, dense for the systems that only need positions
+
+    Entity parents[ENTITY_CHUNK_SIZE];       // RJ_INDEX_INVALID for roots
+    Entity firstChildren[ENTITY_CHUNK_SIZE]; // head of the child list of every entity
+    Entity nextSiblings[ENTITY_CHUNK_SIZE];  // links of the child list of the parent
+    Entity previousSiblings[ENTITY_CHUNK_SIZE];
+    Entity order[ENTITY_CHUNK_SIZE]; // slice of the transform order, which never holds more entities than there are slots
+
+    uint8_t flags[ENTITY_CHUNK_SIZE];
+    bool isDirty[ENTITY_CHUNK_SIZE]; // local transform changed since the last update
+    uint8_t changeBits[ENTITY_CHUNK_SIZE]; // bit of every listener whose list already holds the entity
+} ENTITY_CHUNK;
+
 struct ENTITY
 {
     struct ENTITY_DATA
     {
-        RJ_Size capacity;
+        RJ_Size capacity; // chunkCount * ENTITY_CHUNK_SIZE
         RJ_Size count;
         ListArray freeIndices; // RJ_Size
         // todo use another data structure like stack or queue
 
-        // todo move to transform component
-        Vector3 *positions;
-        Vector3 *rotations;
-        Vector3 *scales;
-        uint8_t *flags;
+        RJ_Size chunkCount;
+        ENTITY_CHUNK *chunks[ENTITY_MAX_CHUNK_COUNT];
+        EntitySpan spans[ENTITY_MAX_CHUNK_COUNT]; // handed out by Entity_GetSpans, filled when a chunk is added
     } data;
+
+    struct ENTITY_HIERARCHY
+    {
+        RJ_Size orderCount; // alive entities in the order, every parent before its children
+        bool isOrderDirty;  // links changed, order is rebuilt by the next update
+    } hierarchy;
+
+    struct ENTITY_CHANGES
+    {
+        uint8_t listenerMask; // bit of every created listener
+
+        Entity *lists[ENTITY_MAX_CHANGE_LISTENER_COUNT]; // entities whose world transform changed, at most one entry per entity so sized by the capacity
+        RJ_Size counts[ENTITY_MAX_CHANGE_LISTENER_COUNT];
+    } changes;
+
+    struct ENTITY_REMAP
+    {
+        RJ_Size count;
+        EntityRemapCallback callbacks[ENTITY_MAX_REMAP_CALLBACK_COUNT];
+        void *userData[ENTITY_MAX_REMAP_CALLBACK_COUNT];
+    } remap;
 } ENTITY = {0};
 
-#define ePosition(entity) (ENTITY.data.positions[entity])
-#define eRotation(entity) (ENTITY.data.rotations[entity])
-#define eScale(entity) (ENTITY.data.scales[entity])
-#define eFlag(entity) (ENTITY.data.flags[entity])
+#define eChunk(entity) (ENTITY.data.chunks[Entity_Chunk(entity)])
+
+#define ePosition(entity) (eChunk(entity)->positions[Entity_ChunkIndex(entity)])
+#define ePreviousPosition(entity) (eChunk(entity)->previousPositions[Entity_ChunkIndex(entity)])
+#define eRotation(entity) (eChunk(entity)->rotations[Entity_ChunkIndex(entity)])
+#define eScale(entity) (eChunk(entity)->scales[Entity_ChunkIndex(entity)])
+#define eFlag(entity) (eChunk(entity)->flags[Entity_ChunkIndex(entity)])
+
+#define eParent(entity) (eChunk(entity)->parents[Entity_ChunkIndex(entity)])
+#define eFirstChild(entity) (eChunk(entity)->firstChildren[Entity_ChunkIndex(entity)])
+#define eNextSibling(entity) (eChunk(entity)->nextSiblings[Entity_ChunkIndex(entity)])
+#define ePreviousSibling(entity) (eChunk(entity)->previousSiblings[Entity_ChunkIndex(entity)])
+#define eIsDirty(entity) (eChunk(entity)->isDirty[Entity_ChunkIndex(entity)])
+#define eWorldPosition(entity) (eChunk(entity)->worldPositions[Entity_ChunkIndex(entity)])
+#define eWorldMatrix(entity) (eChunk(entity)->worldMatrices[Entity_ChunkIndex(entity)])
+#define eChangeBits(entity) (eChunk(entity)->changeBits[Entity_ChunkIndex(entity)])
+
+#define eOrder(index) (eChunk(index)->order[Entity_ChunkIndex(index)])
 
 #define eIsActive(entity) (eFlag(entity) & ENTITY_FLAG_ACTIVE)
 #define eSetActive(entity, isActive) (eFlag(entity) = ((isActive) ? (eFlag(entity) | ENTITY_FLAG_ACTIVE) : (eFlag(entity) & (uint8_t)~ENTITY_FLAG_ACTIVE)))
 
 #define eAssertEntity(entity) RJ_DebugAssert((entity) < ENTITY.data.count + ENTITY.data.freeIndices.count && entity != RJ_INDEX_INVALID && eIsActive(entity), "Entity %u either exceeds maximum possible index %u, invalid or inactive.", (entity), ENTITY.data.count + ENTITY.data.freeIndices.count)
 
+/// @brief Frees the last chunk. Change lists keep their size, they are only shrunk when they are recreated.
+static void Entity_RemoveChunk(void)
+{
+    RJ_Size chunk = --ENTITY.data.chunkCount;
+
+    RJ_FreeAligned(ENTITY.data.chunks[chunk]);
+    ENTITY.data.chunks[chunk] = NULL;
+    ENTITY.data.spans[chunk] = (EntitySpan){0};
+
+    ENTITY.data.capacity -= ENTITY_CHUNK_SIZE;
+}
+
+/// @brief Adds a zeroed chunk after the last one and grows the change list of every listener to the new capacity.
+/// @return RJ_OK on success, RJ_ERROR_CAPACITY if ENTITY_MAX_CHUNK_COUNT chunks exist or RJ_ERROR_ALLOCATION if internal allocation fails.
+static RJ_Result Entity_AddChunk(void)
+{
+    if (ENTITY.data.chunkCount >= ENTITY_MAX_CHUNK_COUNT)
+    {
+        RJ_DebugWarning("Maximum entity chunk count of %u reached.", ENTITY_MAX_CHUNK_COUNT);
+        return RJ_ERROR_CAPACITY;
+    }
+
+    RJ_Size chunk = ENTITY.data.chunkCount;
+
+    RJ_ReturnAllocateAligned(ENTITY_CHUNK, ENTITY.data.chunks[chunk], 1, ENTITY_MATRIX_ALIGNMENT);
+
+    ENTITY.data.chunkCount++;
+    ENTITY.data.capacity += ENTITY_CHUNK_SIZE;
+
+    for (EntityChangeListener listener = 0; listener < ENTITY_MAX_CHANGE_LISTENER_COUNT; listener++)
+    {
+        if (!(ENTITY.changes.listenerMask & (1 << listener)))
+        {
+            continue;
+        }
+
+        Entity *list = realloc(ENTITY.changes.lists[listener], sizeof(Entity) * ENTITY.data.capacity);
+        if (list == NULL)
+        {
+            RJ_DebugWarning("Entity change list %u could not grow to %u entities.", listener, ENTITY.data.capacity);
+            Entity_RemoveChunk(); // lists already grown keep their size, which is harmless
+            return RJ_ERROR_ALLOCATION;
+        }
+
+        ENTITY.changes.lists[listener] = list;
+    }
+
+    ENTITY_CHUNK *data = ENTITY.data.chunks[chunk];
+    ENTITY.data.spans[chunk] = (EntitySpan){
+        .positions = data->positions,
+        .rotations = data->rotations,
+        .scales = data->scales,
+        .isDirty = data->isDirty,
+        .parents = data->parents,
+        .worldPositions = data->worldPositions,
+        .worldMatrices = data->worldMatrices,
+        .previousPositions = data->previousPositions,
+    };
+
+    RJ_DebugInfo("Entity chunk %u added, capacity is %u entities.", chunk, ENTITY.data.capacity);
+    return RJ_OK;
+}
+
+/// @brief Adds chunks until a slot count fits.
+/// @param slotCount Number of slots that must exist.
+/// @return RJ_OK on success or the error of the chunk that could not be added, the chunks added before it are kept.
+static RJ_Result Entity_ReserveSlots(RJ_Size slotCount)
+{
+    while (ENTITY.data.capacity < slotCount)
+    {
+        RJ_Result result = Entity_AddChunk();
+
+        if (result != RJ_OK)
+        {
+            return result;
+        }
+    }
+
+    return RJ_OK;
+}
+
+/// @brief Frees every buffer of the entity data and clears it. Buffers that are not allocated yet are NULL, so it is also used to clean up a failed initialization.
+static void Entity_FreeBuffers(void)
+{
+    if (ENTITY.data.freeIndices.data != NULL)
+    {
+        ListArray_Destroy(&ENTITY.data.freeIndices);
+    }
+
+    while (ENTITY.data.chunkCount > 0)
+    {
+        Entity_RemoveChunk();
+    }
+
+    for (EntityChangeListener listener = 0; listener < ENTITY_MAX_CHANGE_LISTENER_COUNT; listener++)
+    {
+        free(ENTITY.changes.lists[listener]);
+    }
+
+    memset(&ENTITY, 0, sizeof(ENTITY));
+}
+
+/// @brief Adds an entity to the change list of every listener that does not hold it yet.
+/// @param entity Entity whose world transform changed.
+static void Entity_MarkChanged(Entity entity)
+{
+    uint8_t missingBits = ENTITY.changes.listenerMask & (uint8_t)~eChangeBits(entity);
+
+    if (missingBits == 0)
+    {
+        return;
+    }
+
+    for (EntityChangeListener listener = 0; listener < ENTITY_MAX_CHANGE_LISTENER_COUNT; listener++)
+    {
+        if (missingBits & (1 << listener))
+        {
+            ENTITY.changes.lists[listener][ENTITY.changes.counts[listener]++] = entity;
+        }
+    }
+
+    eChangeBits(entity) |= missingBits;
+}
+
+/// @brief Computes the world matrix of an entity from its local transform and the world matrix of its parent, which must be up to date.
+/// @param entity Entity to compute.
+/// @note Rotations are radians applied in x, y, z order, matching the matrices the renderer used to build.
+static void Entity_ComputeWorldMatrix(Entity entity)
+{
+    Vector3 position = ePosition(entity);
+    Vector3 rotation = eRotation(entity);
+    Vector3 scale = eScale(entity);
+
+    float sinX = sinf(rotation.x);
+    float cosX = cosf(rotation.x);
+    float sinY = sinf(rotation.y);
+    float cosY = cosf(rotation.y);
+    float sinZ = sinf(rotation.z);
+    float cosZ = cosf(rotation.z);
+
+    // columns of translation * rotation x * rotation y * rotation z * scale
+    Matrix4 local = {.m = {
+                         {cosY * cosZ * scale.x, (cosX * sinZ + sinX * sinY * cosZ) * scale.x, (sinX * sinZ - cosX * sinY * cosZ) * scale.x, 0.0f},
+                         {-cosY * sinZ * scale.y, (cosX * cosZ - sinX * sinY * sinZ) * scale.y, (sinX * cosZ + cosX * sinY * sinZ) * scale.y, 0.0f},
+                         {sinY * scale.z, -sinX * cosY * scale.z, cosX * cosY * scale.z, 0.0f},
+                         {position.x, position.y, position.z, 1.0f},
+                     }};
+
+    Entity parent = eParent(entity);
+
+    if (parent == RJ_INDEX_INVALID)
+    {
+        eWorldMatrix(entity) = local;
+    }
+    else
+    {
+        const Matrix4 *parentMatrix = &eWorldMatrix(parent);
+        Matrix4 *world = &eWorldMatrix(entity);
+
+        for (RJ_Size column = 0; column < 4; column++)
+        {
+            for (RJ_Size row = 0; row < 4; row++)
+            {
+                world->m[column][row] = parentMatrix->m[0][row] * local.m[column][0] + parentMatrix->m[1][row] * local.m[column][1] +
+                                        parentMatrix->m[2][row] * local.m[column][2] + parentMatrix->m[3][row] * local.m[column][3];
+            }
+        }
+    }
+
+    eWorldPosition(entity) = Vector3_New(eWorldMatrix(entity).m[3][0], eWorldMatrix(entity).m[3][1], eWorldMatrix(entity).m[3][2]);
+    Entity_MarkChanged(entity);
+}
+
+/// @brief Removes an entity from the child list of its parent and makes it a root.
+/// @param entity Entity to detach.
+static void Entity_Unlink(Entity entity)
+{
+    Entity parent = eParent(entity);
+
+    if (parent == RJ_INDEX_INVALID)
+    {
+        return;
+    }
+
+    if (ePreviousSibling(entity) != RJ_INDEX_INVALID)
+    {
+        eNextSibling(ePreviousSibling(entity)) = eNextSibling(entity);
+    }
+    else
+    {
+        eFirstChild(parent) = eNextSibling(entity);
+    }
+
+    if (eNextSibling(entity) != RJ_INDEX_INVALID)
+    {
+        ePreviousSibling(eNextSibling(entity)) = ePreviousSibling(entity);
+    }
+
+    eParent(entity) = RJ_INDEX_INVALID;
+    eNextSibling(entity) = RJ_INDEX_INVALID;
+    ePreviousSibling(entity) = RJ_INDEX_INVALID;
+}
+
+/// @brief Rebuilds the transform order breadth first from the roots, so entities are sorted by depth and every parent comes before its children.
+static void Entity_SortTransforms(void)
+{
+    RJ_Size slotCount = ENTITY.data.count + ENTITY.data.freeIndices.count;
+    RJ_Size orderCount = 0;
+
+    for (Entity entity = 0; entity < slotCount; entity++)
+    {
+        if (eIsActive(entity) && eParent(entity) == RJ_INDEX_INVALID)
+        {
+            eOrder(orderCount) = entity;
+            orderCount++;
+        }
+    }
+
+    for (RJ_Size index = 0; index < orderCount; index++)
+    {
+        for (Entity child = eFirstChild(eOrder(index)); child != RJ_INDEX_INVALID; child = eNextSibling(child))
+        {
+            eOrder(orderCount) = child;
+            orderCount++;
+        }
+    }
+
+    ENTITY.hierarchy.orderCount = orderCount;
+    ENTITY.hierarchy.isOrderDirty = false;
+}
+
+/// @brief Sets up a new root entity at a slot that is not in use.
+/// @param entity Slot of the new entity.
+/// @param position Local position.
+/// @param rotation Local rotation.
+/// @param scale Local scale.
+static void Entity_Reset(Entity entity, Vector3 position, Vector3 rotation, Vector3 scale)
+{
+    ePosition(entity) = position;
+    ePreviousPosition(entity) = position;
+    eRotation(entity) = rotation;
+    eScale(entity) = scale;
+    eSetActive(entity, true);
+
+    eParent(entity) = RJ_INDEX_INVALID;
+    eFirstChild(entity) = RJ_INDEX_INVALID;
+    eNextSibling(entity) = RJ_INDEX_INVALID;
+    ePreviousSibling(entity) = RJ_INDEX_INVALID;
+    eIsDirty(entity) = false;
+    Entity_ComputeWorldMatrix(entity);
+
+    if (!ENTITY.hierarchy.isOrderDirty)
+    {
+        // a new root has no children, appending it keeps every parent before its children
+        eOrder(ENTITY.hierarchy.orderCount) = entity;
+        ENTITY.hierarchy.orderCount++;
+    }
+}
+
+/// @brief Copies the transforms of a batch into an array, or fills it when they are not given.
+/// @param destination First element to write.
+/// @param source Transforms to copy, can be NULL.
+/// @param fill Transform to fill with when the source is NULL.
+/// @param count Number of elements.
+static void Entity_CopyOrFill(Vector3 *destination, const Vector3 *source, Vector3 fill, RJ_Size count)
+{
+    if (source != NULL)
+    {
+        memcpy(destination, source, sizeof(Vector3) * count);
+        return;
+    }
+
+    for (RJ_Size index = 0; index < count; index++)
+    {
+        destination[index] = fill;
+    }
+}
+
+/// @brief Sets up a contiguous range of new root entities at slots that are not in use, writing every array in bulk.
+/// @param first First slot of the range.
+/// @param count Number of entities.
+/// @param positions Local positions, NULL for zero.
+/// @param rotations Local rotations, NULL for zero.
+/// @param scales Local scales, NULL for one.
+static void Entity_ResetRange(Entity first, RJ_Size count, const Vector3 *positions, const Vector3 *rotations, const Vector3 *scales)
+{
+    // written chunk by chunk, a range can cross chunk boundaries
+    for (RJ_Size done = 0; done < count;)
+    {
+        Entity start = first + done;
+        RJ_Size length = Maths_Min(count - done, ENTITY_CHUNK_SIZE - Entity_ChunkIndex(start));
+
+        Entity_CopyOrFill(&ePosition(start), positions != NULL ? positions + done : NULL, Vector3_Zero, length);
+        memcpy(&ePreviousPosition(start), &ePosition(start), sizeof(Vector3) * length);
+        Entity_CopyOrFill(&eRotation(start), rotations != NULL ? rotations + done : NULL, Vector3_Zero, length);
+        Entity_CopyOrFill(&eScale(start), scales != NULL ? scales + done : NULL, Vector3_One, length);
+        memset(&eFlag(start), ENTITY_FLAG_ACTIVE, sizeof(uint8_t) * length);
+
+        memset(&eParent(start), 0xff, sizeof(Entity) * length);
+        memset(&eFirstChild(start), 0xff, sizeof(Entity) * length);
+        memset(&eNextSibling(start), 0xff, sizeof(Entity) * length);
+        memset(&ePreviousSibling(start), 0xff, sizeof(Entity) * length);
+        memset(&eIsDirty(start), 0, sizeof(bool) * length);
+
+        done += length;
+    }
+
+    for (Entity entity = first; entity < first + count; entity++)
+    {
+        Entity_ComputeWorldMatrix(entity);
+    }
+
+    if (!ENTITY.hierarchy.isOrderDirty)
+    {
+        for (Entity entity = first; entity < first + count; entity++)
+        {
+            eOrder(ENTITY.hierarchy.orderCount) = entity;
+            ENTITY.hierarchy.orderCount++;
+        }
+    }
+}
+
+/// @brief Maps a hierarchy link through a remap table.
+/// @param remap New entity of every old entity.
+/// @param entity Old entity, RJ_INDEX_INVALID is kept as it is.
+static inline Entity Entity_RemapLink(const Entity *remap, Entity entity)
+{
+    return entity == RJ_INDEX_INVALID ? RJ_INDEX_INVALID : remap[entity];
+}
+
+/// @brief Detaches the children of an entity at their world position, removes it from the hierarchy and marks it inactive. The slot is not freed.
+/// @param entity Entity to deactivate.
+static void Entity_Deactivate(Entity entity)
+{
+    while (eFirstChild(entity) != RJ_INDEX_INVALID)
+    {
+        Entity child = eFirstChild(entity);
+
+        Entity_Unlink(child);
+        ePosition(child) = eWorldPosition(child);
+        eIsDirty(child) = true;
+    }
+
+    Entity_Unlink(entity);
+    ENTITY.hierarchy.isOrderDirty = true;
+
+    eSetActive(entity, false);
+}
+
 #pragma endregion Source Only
 
 RJ_ResultWarn Entity_Initialize(RJ_Size initialEntityCapacity)
 {
-    ENTITY.data.capacity = initialEntityCapacity;
+    ENTITY.data.capacity = 0;
     ENTITY.data.count = 0;
 
     ListArray_Create(&ENTITY.data.freeIndices, "Entity Free Indices", sizeof(RJ_Size), ENTITY_INITIAL_FREE_INDEX_ARRAY_SIZE);
 
-    RJ_ReturnAllocate(Vector3, ENTITY.data.positions, initialEntityCapacity,
-                      ListArray_Destroy(&ENTITY.data.freeIndices);
-                      ENTITY.data.capacity = 0;);
-
-    RJ_ReturnAllocate(Vector3, ENTITY.data.rotations, initialEntityCapacity,
-                      ListArray_Destroy(&ENTITY.data.freeIndices);
-                      free(ENTITY.data.positions);
-                      ENTITY.data.positions = NULL;
-                      ENTITY.data.capacity = 0;);
-
-    RJ_ReturnAllocate(Vector3, ENTITY.data.scales, initialEntityCapacity,
-                      ListArray_Destroy(&ENTITY.data.freeIndices);
-                      free(ENTITY.data.positions);
-                      free(ENTITY.data.rotations);
-                      ENTITY.data.positions = NULL;
-                      ENTITY.data.rotations = NULL;
-                      ENTITY.data.capacity = 0;);
-
-    RJ_ReturnAllocate(uint8_t, ENTITY.data.flags, initialEntityCapacity,
-                      ListArray_Destroy(&ENTITY.data.freeIndices);
-                      free(ENTITY.data.positions);
-                      free(ENTITY.data.rotations);
-                      free(ENTITY.data.scales);
-                      ENTITY.data.positions = NULL;
-                      ENTITY.data.rotations = NULL;
-                      ENTITY.data.scales = NULL;
-                      ENTITY.data.capacity = 0;);
-
-    RJ_DebugInfo("Entity data initialized with component capacity %u.", initialEntityCapacity);
+    RJ_Result result = Entity_ReserveSlots(Maths_Max(initialEntityCapacity, 1));
+    if (result != RJ_OK)
+    {
+        Entity_FreeBuffers();
+        return result;
+    }
+
+    RJ_DebugInfo("Entity data initialized with %u chunks, capacity %u entities.", ENTITY.data.chunkCount, ENTITY.data.capacity);
     return RJ_OK;
 }
 
 void Entity_Terminate()
 {
-    ENTITY.data.capacity = 0;
-    ENTITY.data.count = 0;
-    ListArray_Destroy(&ENTITY.data.freeIndices);
-
-    free(ENTITY.data.positions);
-    free(ENTITY.data.rotations);
-    free(ENTITY.data.scales);
-
-    ENTITY.data.positions = NULL;
-    ENTITY.data.rotations = NULL;
-    ENTITY.data.scales = NULL;
+    Entity_FreeBuffers();
 
     RJ_DebugInfo("Entity data terminated successfully.");
 }
@@ -98,49 +478,549 @@ bool Entity_IsInitialized(void)
 
 Entity Entity_Create(Vector3 position, Vector3 rotation, Vector3 scale)
 {
-    RJ_DebugAssert(ENTITY.data.count + ENTITY.data.freeIndices.count < ENTITY.data.capacity, "Maximum Entity capacity of %u reached.", ENTITY.data.capacity);
+    if (ENTITY.data.freeIndices.count == 0)
+    {
+        RJ_Result result = Entity_ReserveSlots(ENTITY.data.count + 1);
+        RJ_DebugAssert(result == RJ_OK, "Entity chunk could not be added at capacity %u.", ENTITY.data.capacity);
+    }
 
     Entity newEntity = ENTITY.data.freeIndices.count != 0 ? (Entity) * ((RJ_Size *)ListArray_Pop(&ENTITY.data.freeIndices)) : ENTITY.data.count;
 
-    ePosition(newEntity) = position;
-    eRotation(newEntity) = rotation;
-    eScale(newEntity) = scale;
-    eSetActive(newEntity, true);
+    Entity_Reset(newEntity, position, rotation, scale);
 
     ENTITY.data.count++;
 
     return newEntity;
 }
 
+RJ_ResultWarn Entity_CreateBatch(Entity *retEntities, RJ_Size count, const Vector3 *positions, const Vector3 *rotations, const Vector3 *scales)
+{
+    RJ_DebugAssertNullPointerCheck(retEntities);
+
+    RJ_Size slotCount = ENTITY.data.count + ENTITY.data.freeIndices.count;
+    RJ_Size reusedCount = 0;
+
+    if (slotCount + count > ENTITY.data.capacity)
+    {
+        // no room for a contiguous range in the allocated chunks, fill the most recently freed slots first and add chunks only for the rest
+        reusedCount = Maths_Min(count - (ENTITY.data.capacity - slotCount), ENTITY.data.freeIndices.count);
+
+        RJ_Result result = Entity_ReserveSlots(slotCount + count - reusedCount);
+        if (result != RJ_OK)
+        {
+            RJ_DebugWarning("Creating %u entities failed with %u entities.", count, ENTITY.data.count);
+            return result;
+        }
+
+        const RJ_Size *freeIndices = (const RJ_Size *)ENTITY.data.freeIndices.data;
+        RJ_Size freeCount = ENTITY.data.freeIndices.count;
+
+        for (RJ_Size index = 0; index < reusedCount; index++)
+        {
+            retEntities[index] = freeIndices[freeCount - 1 - index];
+            Entity_Reset(retEntities[index],
+                         positions != NULL ? positions[index] : Vector3_Zero,
+                         rotations != NULL ? rotations[index] : Vector3_Zero,
+                         scales != NULL ? scales[index] : Vector3_One);
+        }
+
+        if (reusedCount > 0)
+        {
+            ListArray_RemoveRange(&ENTITY.data.freeIndices, freeCount - reusedCount, reusedCount);
+        }
+    }
+
+    RJ_Size rangeCount = count - reusedCount;
+
+    if (rangeCount > 0)
+    {
+        Entity_ResetRange(slotCount, rangeCount,
+                          positions != NULL ? positions + reusedCount : NULL,
+                          rotations != NULL ? rotations + reusedCount : NULL,
+                          scales != NULL ? scales + reusedCount : NULL);
+
+        for (RJ_Size index = 0; index < rangeCount; index++)
+        {
+            retEntities[reusedCount + index] = slotCount + index;
+        }
+    }
+
+    ENTITY.data.count += count;
+
+    return RJ_OK;
+}
+
 void Entity_Destroy(Entity entity)
 {
     eAssertEntity(entity);
 
-    eSetActive(entity, false);
+    Entity_Deactivate(entity);
     ListArray_Add(&ENTITY.data.freeIndices, &entity);
 
     ENTITY.data.count--;
 }
 
+void Entity_DestroyBatch(const Entity *entities, RJ_Size count)
+{
+    RJ_DebugAssertNullPointerCheck(entities);
+
+    for (RJ_Size index = 0; index < count; index++)
+    {
+        eAssertEntity(entities[index]);
+        Entity_Deactivate(entities[index]);
+    }
+
+    if (ENTITY.data.freeIndices.count + count > ENTITY.data.freeIndices.capacity)
+    {
+        ListArray_Resize(&ENTITY.data.freeIndices, ENTITY.data.freeIndices.count + count);
+    }
+
+    // pushed in reverse so the next batch pops them back in the given order
+    for (RJ_Size index = count; index > 0; index--)
+    {
+        ListArray_Add(&ENTITY.data.freeIndices, &entities[index - 1]);
+    }
+
+    ENTITY.data.count -= count;
+}
+
+void Entity_SetParent(Entity entity, Entity parent)
+{
+    eAssertEntity(entity);
+
+    if (eParent(entity) == parent)
+    {
+        return;
+    }
+
+    if (parent != RJ_INDEX_INVALID)
+    {
+        eAssertEntity(parent);
+
+        for (Entity ancestor = parent; ancestor != RJ_INDEX_INVALID; ancestor = eParent(ancestor))
+        {
+            RJ_DebugAssert(ancestor != entity, "Entity %u can not be attached to its descendant %u.", entity, parent);
+        }
+    }
+
+    Entity_Unlink(entity);
+
+    if (parent != RJ_INDEX_INVALID)
+    {
+        eParent(entity) = parent;
+        eNextSibling(entity) = eFirstChild(parent);
+
+        if (eFirstChild(parent) != RJ_INDEX_INVALID)
+        {
+            ePreviousSibling(eFirstChild(parent)) = entity;
+        }
+
+        eFirstChild(parent) = entity;
+    }
+
+    eIsDirty(entity) = true;
+    ENTITY.hierarchy.isOrderDirty = true;
+}
+
+Entity Entity_GetParent(Entity entity)
+{
+    eAssertEntity(entity);
+    return eParent(entity);
+}
+
+void Entity_UpdateTransforms(void)
+{
+    if (ENTITY.hierarchy.isOrderDirty)
+    {
+        Entity_SortTransforms();
+    }
+
+    for (RJ_Size index = 0; index < ENTITY.hierarchy.orderCount; index++)
+    {
+        Entity entity = eOrder(index);
+        Entity parent = eParent(entity);
+
+        if (parent != RJ_INDEX_INVALID && eIsDirty(parent))
+        {
+            eIsDirty(entity) = true; // flags are cleared after the whole pass, so a changed parent marks its whole subtree
+        }
+
+        if (eIsDirty(entity))
+        {
+            Entity_ComputeWorldMatrix(entity);
+        }
+    }
+
+    RJ_Size slotCount = ENTITY.data.count + ENTITY.data.freeIndices.count;
+
+    for (RJ_Size chunk = 0; chunk * ENTITY_CHUNK_SIZE < slotCount; chunk++)
+    {
+        memset(ENTITY.data.chunks[chunk]->isDirty, 0, sizeof(bool) * Maths_Min(slotCount - chunk * ENTITY_CHUNK_SIZE, ENTITY_CHUNK_SIZE));
+    }
+}
+
+RJ_ResultWarn Entity_ChangeListenerCreate(EntityChangeListener *retListener)
+{
+    RJ_DebugAssertNullPointerCheck(retListener);
+
+    EntityChangeListener listener = 0;
+
+    while (listener < ENTITY_MAX_CHANGE_LISTENER_COUNT && (ENTITY.changes.listenerMask & (1 << listener)))
+    {
+        listener++;
+    }
+
+    if (listener == ENTITY_MAX_CHANGE_LISTENER_COUNT)
+    {
+        RJ_DebugWarning("Maximum entity change listener count of %u reached.", ENTITY_MAX_CHANGE_LISTENER_COUNT);
+        return RJ_ERROR_CAPACITY;
+    }
+
+    RJ_ReturnAllocate(Entity, ENTITY.changes.lists[listener], ENTITY.data.capacity);
+
+    ENTITY.changes.counts[listener] = 0;
+    ENTITY.changes.listenerMask |= (uint8_t)(1 << listener);
+
+    *retListener = listener;
+    return RJ_OK;
+}
+
+void Entity_ChangeListenerDestroy(EntityChangeListener listener)
+{
+    if (listener >= ENTITY_MAX_CHANGE_LISTENER_COUNT || !(ENTITY.changes.listenerMask & (1 << listener)))
+    {
+        return;
+    }
+
+    Entity_ClearChangedEntities(listener);
+
+    free(ENTITY.changes.lists[listener]);
+    ENTITY.changes.lists[listener] = NULL;
+
+    ENTITY.changes.listenerMask &= (uint8_t)~(1 << listener);
+}
+
+const Entity *Entity_GetChangedEntities(EntityChangeListener listener, RJ_Size *retCount)
+{
+    RJ_DebugAssertNullPointerCheck(retCount);
+    RJ_DebugAssert(listener < ENTITY_MAX_CHANGE_LISTENER_COUNT && (ENTITY.changes.listenerMask & (1 << listener)), "Entity change listener %u is not created.", listener);
+
+    *retCount = ENTITY.changes.counts[listener];
+    return ENTITY.changes.lists[listener];
+}
+
+void Entity_ClearChangedEntities(EntityChangeListener listener)
+{
+    RJ_DebugAssert(listener < ENTITY_MAX_CHANGE_LISTENER_COUNT && (ENTITY.changes.listenerMask & (1 << listener)), "Entity change listener %u is not created.", listener);
+
+    uint8_t keptBits = (uint8_t)~(1 << listener);
+
+    for (RJ_Size index = 0; index < ENTITY.changes.counts[listener]; index++)
+    {
+        eChangeBits(ENTITY.changes.lists[listener][index]) &= keptBits;
+    }
+
+    ENTITY.changes.counts[listener] = 0;
+}
+
+RJ_ResultWarn Entity_RemapCallbackAdd(EntityRemapCallback callback, void *userData)
+{
+    RJ_DebugAssertNullPointerCheck(callback);
+
+    if (ENTITY.remap.count >= ENTITY_MAX_REMAP_CALLBACK_COUNT)
+    {
+        RJ_DebugWarning("Maximum entity remap callback count of %u reached.", ENTITY_MAX_REMAP_CALLBACK_COUNT);
+        return RJ_ERROR_CAPACITY;
+    }
+
+    ENTITY.remap.callbacks[ENTITY.remap.count] = callback;
+    ENTITY.remap.userData[ENTITY.remap.count] = userData;
+    ENTITY.remap.count++;
+
+    return RJ_OK;
+}
+
+void Entity_RemapCallbackRemove(EntityRemapCallback callback, void *userData)
+{
+    for (RJ_Size index = 0; index < ENTITY.remap.count; index++)
+    {
+        if (ENTITY.remap.callbacks[index] == callback && ENTITY.remap.userData[index] == userData)
+        {
+            ENTITY.remap.count--;
+            ENTITY.remap.callbacks[index] = ENTITY.remap.callbacks[ENTITY.remap.count];
+            ENTITY.remap.userData[index] = ENTITY.remap.userData[ENTITY.remap.count];
+            return;
+        }
+    }
+}
+
+RJ_ResultWarn Entity_Compact(void)
+{
+    if (ENTITY.data.freeIndices.count == 0)
+    {
+        return RJ_OK;
+    }
+
+    RJ_Size slotCount = ENTITY.data.count + ENTITY.data.freeIndices.count;
+
+    Entity *remap = NULL;
+    RJ_ReturnAllocate(Entity, remap, slotCount);
+
+    RJ_Size aliveCount = 0;
+
+    for (Entity entity = 0; entity < slotCount; entity++)
+    {
+        remap[entity] = eIsActive(entity) ? aliveCount++ : RJ_INDEX_INVALID;
+    }
+
+    // entities keep their relative order, so every target is at or below its source and the arrays are moved in place front to back
+    for (Entity entity = 0; entity < slotCount; entity++)
+    {
+        Entity target = remap[entity];
+
+        if (target == RJ_INDEX_INVALID || target == entity)
+        {
+            continue;
+        }
+
+        ePosition(target) = ePosition(entity);
+        ePreviousPosition(target) = ePreviousPosition(entity);
+        eRotation(target) = eRotation(entity);
+        eScale(target) = eScale(entity);
+        eFlag(target) = eFlag(entity);
+
+        eParent(target) = eParent(entity);
+        eFirstChild(target) = eFirstChild(entity);
+        eNextSibling(target) = eNextSibling(entity);
+        ePreviousSibling(target) = ePreviousSibling(entity);
+        eIsDirty(target) = eIsDirty(entity);
+        eWorldPosition(target) = eWorldPosition(entity);
+        eWorldMatrix(target) = eWorldMatrix(entity);
+        eChangeBits(target) = eChangeBits(entity);
+    }
+
+    for (Entity entity = 0; entity < aliveCount; entity++)
+    {
+        eParent(entity) = Entity_RemapLink(remap, eParent(entity));
+        eFirstChild(entity) = Entity_RemapLink(remap, eFirstChild(entity));
+        eNextSibling(entity) = Entity_RemapLink(remap, eNextSibling(entity));
+        ePreviousSibling(entity) = Entity_RemapLink(remap, ePreviousSibling(entity));
+    }
+
+    for (RJ_Size done = aliveCount; done < slotCount;)
+    {
+        RJ_Size length = Maths_Min(slotCount - done, ENTITY_CHUNK_SIZE - Entity_ChunkIndex(done));
+
+        memset(&eFlag(done), 0, sizeof(uint8_t) * length);
+        memset(&eIsDirty(done), 0, sizeof(bool) * length);
+        memset(&eChangeBits(done), 0, sizeof(uint8_t) * length);
+
+        done += length;
+    }
+
+    // chunks above the alive entities are empty now, the first one is kept so the storage never runs dry
+    while (ENTITY.data.chunkCount > 1 && (ENTITY.data.chunkCount - 1) * ENTITY_CHUNK_SIZE >= aliveCount)
+    {
+        Entity_RemoveChunk();
+    }
+
+    if (!ENTITY.hierarchy.isOrderDirty)
+    {
+        for (RJ_Size index = 0; index < ENTITY.hierarchy.orderCount; index++)
+        {
+            eOrder(index) = remap[eOrder(index)];
+        }
+    }
+
+    for (EntityChangeListener listener = 0; listener < ENTITY_MAX_CHANGE_LISTENER_COUNT; listener++)
+    {
+        if (!(ENTITY.changes.listenerMask & (1 << listener)))
+        {
+            continue;
+        }
+
+        Entity *list = ENTITY.changes.lists[listener];
+        RJ_Size keptCount = 0;
+
+        for (RJ_Size index = 0; index < ENTITY.changes.counts[listener]; index++)
+        {
+            if (remap[list[index]] != RJ_INDEX_INVALID)
+            {
+                list[keptCount++] = remap[list[index]];
+            }
+        }
+
+        ENTITY.changes.counts[listener] = keptCount;
+    }
+
+    ListArray_Clear(&ENTITY.data.freeIndices);
+
+    for (RJ_Size index = 0; index < ENTITY.remap.count; index++)
+    {
+        ENTITY.remap.callbacks[index](ENTITY.remap.userData[index], remap, slotCount);
+    }
+
+    free(remap);
+
+    RJ_DebugInfo("Entities compacted from %u slots to %u.", slotCount, aliveCount);
+    return RJ_OK;
+}
+
+Vector3 Entity_GetWorldPosition(Entity entity)
+{
+    eAssertEntity(entity);
+    return eWorldPosition(entity);
+}
+
+Matrix4 Entity_GetWorldMatrix(Entity entity)
+{
+    eAssertEntity(entity);
+    return eWorldMatrix(entity);
+}
+
 void Entity_GetInternalData(RJ_Size *retCapacity, RJ_Size *retCount)
 {
-    if (retCapacity != NULL && ENTITY.data.flags != NULL)
+    if (retCapacity != NULL && ENTITY.data.chunkCount > 0)
     {
         *retCapacity = ENTITY.data.capacity;
     }
 
-    if (retCount != NULL && ENTITY.data.flags != NULL)
+    if (retCount != NULL && ENTITY.data.chunkCount > 0)
     {
         *retCount = ENTITY.data.count;
     }
 }
 
+const EntitySpan *Entity_GetSpans(RJ_Size *retSlotCount)
+{
+    if (retSlotCount != NULL)
+    {
+        *retSlotCount = ENTITY.data.count + ENTITY.data.freeIndices.count;
+    }
+
+    return ENTITY.data.spans;
+}
+
+void EntityMap_Create(EntityMap *retMap, RJ_Size sizeOfItem, uint8_t fillByte)
+{
+    RJ_DebugAssertNullPointerCheck(retMap);
+
+    *retMap = (EntityMap){
+        .sizeOfItem = sizeOfItem,
+        .fillByte = fillByte,
+        .chunkCount = 0,
+    };
+}
+
+void EntityMap_Destroy(EntityMap *map)
+{
+    RJ_DebugAssertNullPointerCheck(map);
+
+    for (RJ_Size chunk = 0; chunk < map->chunkCount; chunk++)
+    {
+        free(map->chunks[chunk]);
+        map->chunks[chunk] = NULL;
+    }
+
+    map->chunkCount = 0;
+}
+
+RJ_ResultWarn EntityMap_Reserve(EntityMap *map, Entity entity)
+{
+    RJ_DebugAssertNullPointerCheck(map);
+    RJ_DebugAssert(entity != RJ_INDEX_INVALID && Entity_Chunk(entity) < ENTITY_MAX_CHUNK_COUNT, "Entity %u can not be stored in an entity map.", entity);
+
+    while (map->chunkCount <= Entity_Chunk(entity))
+    {
+        void *chunk = malloc(map->sizeOfItem * ENTITY_CHUNK_SIZE);
+        if (chunk == NULL)
+        {
+            RJ_DebugWarning("Entity map chunk %u could not be allocated.", map->chunkCount);
+            return RJ_ERROR_ALLOCATION;
+        }
+
+        memset(chunk, map->fillByte, map->sizeOfItem * ENTITY_CHUNK_SIZE);
+        map->chunks[map->chunkCount++] = chunk;
+    }
+
+    return RJ_OK;
+}
+
+void EntityMap_Remap(EntityMap *map, const Entity *remap, RJ_Size slotCount)
+{
+    RJ_DebugAssertNullPointerCheck(map);
+    RJ_DebugAssertNullPointerCheck(remap);
+
+    RJ_Size itemSize = map->sizeOfItem;
+    RJ_Size aliveCount = 0;
+
+    // targets are at or below their sources like in Entity_Compact, so values are moved in place front to back
+    for (Entity entity = 0; entity < slotCount; entity++)
+    {
+        Entity target = remap[entity];
+
+        if (target == RJ_INDEX_INVALID)
+        {
+            continue;
+        }
+
+        aliveCount++;
+
+        if (!EntityMap_Has(*map, target))
+        {
+            continue;
+        }
+
+        uint8_t *targetItem = (uint8_t *)map->chunks[Entity_Chunk(target)] + Entity_ChunkIndex(target) * itemSize;
+
+        if (!EntityMap_Has(*map, entity))
+        {
+            memset(targetItem, map->fillByte, itemSize);
+        }
+        else if (target != entity)
+        {
+            memcpy(targetItem, (uint8_t *)map->chunks[Entity_Chunk(entity)] + Entity_ChunkIndex(entity) * itemSize, itemSize);
+        }
+    }
+
+    while (map->chunkCount > 0 && (map->chunkCount - 1) * ENTITY_CHUNK_SIZE >= aliveCount)
+    {
+        free(map->chunks[--map->chunkCount]);
+        map->chunks[map->chunkCount] = NULL;
+    }
+
+    // the slots of the last kept chunk above the live entities held moved values
+    if (map->chunkCount > 0 && aliveCount < map->chunkCount * ENTITY_CHUNK_SIZE)
+    {
+        uint8_t *tail = (uint8_t *)map->chunks[Entity_Chunk(aliveCount)] + Entity_ChunkIndex(aliveCount) * itemSize;
+        memset(tail, map->fillByte, (map->chunkCount * ENTITY_CHUNK_SIZE - aliveCount) * itemSize);
+    }
+}
+
 Vector3 Entity_GetPosition(Entity entity)
 {
     eAssertEntity(entity);
     return ePosition(entity);
 }
 
+Vector3 Entity_GetInterpolatedPosition(Entity entity, float alpha)
+{
+    eAssertEntity(entity);
+    return Vector3_Lerp(ePreviousPosition(entity), eWorldPosition(entity), alpha);
+}
+
+void Entity_StorePreviousPositions(void)
+{
+    Entity_UpdateTransforms();
+    RJ_Size slotCount = ENTITY.data.count + ENTITY.data.freeIndices.count;
+
+    for (RJ_Size chunk = 0; chunk * ENTITY_CHUNK_SIZE < slotCount; chunk++)
+    {
+        ENTITY_CHUNK *data = ENTITY.data.chunks[chunk];
+        memcpy(data->previousPositions, data->worldPositions, sizeof(Vector3) * Maths_Min(slotCount - chunk * ENTITY_CHUNK_SIZE, ENTITY_CHUNK_SIZE));
+    }
+}
+
 Vector3 Entity_GetRotation(Entity entity)
 {
     eAssertEntity(entity);
@@ -157,34 +1037,40 @@ void Entity_SetPosition(Entity entity, Vector3 position)
 {
     eAssertEntity(entity);
     ePosition(entity) = position;
+    eIsDirty(entity) = true;
 }
 
 void Entity_AddPosition(Entity entity, Vector3 position)
 {
     eAssertEntity(entity);
     ePosition(entity) = Vector3G_Sum(ePosition(entity), position);
+    eIsDirty(entity) = true;
 }
 
 void Entity_SetRotation(Entity entity, Vector3 rotation)
 {
     eAssertEntity(entity);
     eRotation(entity) = rotation;
+    eIsDirty(entity) = true;
 }
 
 void Entity_AddRotation(Entity entity, Vector3 rotation)
 {
     eAssertEntity(entity);
     eRotation(entity) = Vector3G_Sum(eRotation(entity), rotation);
+    eIsDirty(entity) = true;
 }
 
 void Entity_SetScale(Entity entity, Vector3 scale)
 {
     eAssertEntity(entity);
     eScale(entity) = scale;
+    eIsDirty(entity) = true;
 }
 
 void Entity_ScaleScale(Entity entity, Vector3 scale)
 {
     eAssertEntity(entity);
     eScale(entity) = Vector3G_ScaleV(eScale(entity), scale);
+    eIsDirty(entity) = true;
 }
@@ -0,0 +1,279 @@
+#include "utilities/ThreadPool.h"
+
+#if RJ_PLATFORM == RJ_PLATFORM_WINDOWS
+#include <windows.h>
+
+typedef HANDLE ThreadPool_Thread;
+typedef SRWLOCK ThreadPool_Mutex;
+typedef CONDITION_VARIABLE ThreadPool_Condition;
+
+#define ThreadPool_MutexInit(mutex) (InitializeSRWLock(mutex), true)
+#define ThreadPool_MutexDestroy(mutex) ((void)(mutex))
+#define ThreadPool_MutexLock(mutex) AcquireSRWLockExclusive(mutex)
+#define ThreadPool_MutexUnlock(mutex) ReleaseSRWLockExclusive(mutex)
+#define ThreadPool_ConditionInit(condition) (InitializeConditionVariable(condition), true)
+#define ThreadPool_ConditionDestroy(condition) ((void)(condition))
+#define ThreadPool_ConditionWait(condition, mutex) SleepConditionVariableSRW(condition, mutex, INFINITE, 0)
+#define ThreadPool_ConditionBroadcast(condition) WakeAllConditionVariable(condition)
+#define ThreadPool_ThreadJoin(thread) (WaitForSingleObject(thread, INFINITE), CloseHandle(thread))
+
+#elif RJ_PLATFORM_UNIX
+#include <pthread.h>
+
+typedef pthread_t ThreadPool_Thread;
+typedef pthread_mutex_t ThreadPool_Mutex;
+typedef pthread_cond_t ThreadPool_Condition;
+
+#define ThreadPool_MutexInit(mutex) (pthread_mutex_init(mutex, NULL) == 0)
+#define ThreadPool_MutexDestroy(mutex) pthread_mutex_destroy(mutex)
+#define ThreadPool_MutexLock(mutex) pthread_mutex_lock(mutex)
+#define ThreadPool_MutexUnlock(mutex) pthread_mutex_unlock(mutex)
+#define ThreadPool_ConditionInit(condition) (pthread_cond_init(condition, NULL) == 0)
+#define ThreadPool_ConditionDestroy(condition) pthread_cond_destroy(condition)
+#define ThreadPool_ConditionWait(condition, mutex) pthread_cond_wait(condition, mutex)
+#define ThreadPool_ConditionBroadcast(condition) pthread_cond_broadcast(condition)
+#define ThreadPool_ThreadJoin(thread) pthread_join(thread, NULL)
+
+#endif
+
+#define ThreadPool_Min(a, b) ((a) < (b) ? (a) : (b))
+
+#pragma region Source Only
+
+/// @brief A worker thread and the task index it runs.
+typedef struct ThreadPool_Worker
+{
+    ThreadPool *pool;
+    RJ_Size taskIndex;
+    ThreadPool_Thread thread;
+} ThreadPool_Worker;
+
+struct ThreadPool
+{
+    RJ_Size threadCount;
+    ThreadPool_Worker workers[THREAD_POOL_MAX_THREAD_COUNT]; // index 0 is unused, task 0 runs on the calling thread
+
+    ThreadPool_Mutex mutex;
+    ThreadPool_Condition startCondition;
+    ThreadPool_Condition doneCondition;
+
+    uint64_t generation; // incremented for every dispatched job, workers run once per increment
+    RJ_Size pendingCount;
+    bool isStopping;
+
+    ThreadPoolTask task;
+    void *userData;
+    RJ_Size itemCount;
+    RJ_Size rangeSize;
+};
+
+/// @brief Runs the range of a task index for the current job.
+/// @param pool Pool of the job.
+/// @param taskIndex Task index to run.
+static void ThreadPool_RunRange(ThreadPool *pool, RJ_Size taskIndex)
+{
+    RJ_Size first = ThreadPool_Min(taskIndex * pool->rangeSize, pool->itemCount);
+    RJ_Size count = ThreadPool_Min(pool->rangeSize, pool->itemCount - first);
+
+    pool->task(pool->userData, taskIndex, first, count);
+}
+
+/// @brief Worker loop, waits for a new generation, runs its range and reports back until the pool stops.
+/// @param worker Worker data of the thread.
+static void ThreadPool_WorkerLoop(ThreadPool_Worker *worker)
+{
+    ThreadPool *pool = worker->pool;
+    uint64_t seenGeneration = 0;
+
+    ThreadPool_MutexLock(&pool->mutex);
+
+    while (true)
+    {
+        while (!pool->isStopping && pool->generation == seenGeneration)
+        {
+            ThreadPool_ConditionWait(&pool->startCondition, &pool->mutex);
+        }
+
+        if (pool->isStopping)
+        {
+            break;
+        }
+
+        seenGeneration = pool->generation;
+        ThreadPool_MutexUnlock(&pool->mutex);
+
+        ThreadPool_RunRange(pool, worker->taskIndex);
+
+        ThreadPool_MutexLock(&pool->mutex);
+
+        if (--pool->pendingCount == 0)
+        {
+            ThreadPool_ConditionBroadcast(&pool->doneCondition);
+        }
+    }
+
+    ThreadPool_MutexUnlock(&pool->mutex);
+}
+
+#if RJ_PLATFORM == RJ_PLATFORM_WINDOWS
+
+static DWORD WINAPI ThreadPool_ThreadEntry(LPVOID worker)
+{
+    ThreadPool_WorkerLoop((ThreadPool_Worker *)worker);
+    return 0;
+}
+
+#define ThreadPool_ThreadStart(worker) (((worker)->thread = CreateThread(NULL, 0, ThreadPool_ThreadEntry, (worker), 0, NULL)) != NULL)
+
+#elif RJ_PLATFORM_UNIX
+
+static void *ThreadPool_ThreadEntry(void *worker)
+{
+    ThreadPool_WorkerLoop((ThreadPool_Worker *)worker);
+    return NULL;
+}
+
+#define ThreadPool_ThreadStart(worker) (pthread_create(&(worker)->thread, NULL, ThreadPool_ThreadEntry, (worker)) == 0)
+
+#endif
+
+/// @brief Signals the started workers to stop and joins them.
+/// @param pool Pool to stop.
+/// @param startedCount Number of threads started so far including the calling thread.
+static void ThreadPool_StopWorkers(ThreadPool *pool, RJ_Size startedCount)
+{
+    ThreadPool_MutexLock(&pool->mutex);
+    pool->isStopping = true;
+    ThreadPool_ConditionBroadcast(&pool->startCondition);
+    ThreadPool_MutexUnlock(&pool->mutex);
+
+    for (RJ_Size i = 1; i < startedCount; i++)
+    {
+        ThreadPool_ThreadJoin(pool->workers[i].thread);
+    }
+}
+
+#pragma endregion Source Only
+
+RJ_Result ThreadPool_Create(ThreadPool **retPool, RJ_Size threadCount)
+{
+    RJ_DebugAssertNullPointerCheck(retPool);
+    RJ_DebugAssert(threadCount > 0 && threadCount <= THREAD_POOL_MAX_THREAD_COUNT, "Thread count %u must be in [1, %u].", threadCount, THREAD_POOL_MAX_THREAD_COUNT);
+
+    ThreadPool *pool = NULL;
+    RJ_ReturnAllocate(ThreadPool, pool, 1);
+
+    pool->threadCount = threadCount;
+
+    if (!ThreadPool_MutexInit(&pool->mutex))
+    {
+        RJ_DebugWarning("Thread pool mutex creation failed.");
+        free(pool);
+        return RJ_ERROR_ALLOCATION;
+    }
+
+    if (!ThreadPool_ConditionInit(&pool->startCondition))
+    {
+        RJ_DebugWarning("Thread pool condition creation failed.");
+        ThreadPool_MutexDestroy(&pool->mutex);
+        free(pool);
+        return RJ_ERROR_ALLOCATION;
+    }
+
+    if (!ThreadPool_ConditionInit(&pool->doneCondition))
+    {
+        RJ_DebugWarning("Thread pool condition creation failed.");
+        ThreadPool_ConditionDestroy(&pool->startCondition);
+        ThreadPool_MutexDestroy(&pool->mutex);
+        free(pool);
+        return RJ_ERROR_ALLOCATION;
+    }
+
+    for (RJ_Size i = 1; i < threadCount; i++)
+    {
+        pool->workers[i].pool = pool;
+        pool->workers[i].taskIndex = i;
+
+        if (!ThreadPool_ThreadStart(&pool->workers[i]))
+        {
+            RJ_DebugWarning("Thread pool worker %u creation failed.", i);
+            ThreadPool_StopWorkers(pool, i);
+            ThreadPool_ConditionDestroy(&pool->doneCondition);
+            ThreadPool_ConditionDestroy(&pool->startCondition);
+            ThreadPool_MutexDestroy(&pool->mutex);
+            free(pool);
+            return RJ_ERROR_ALLOCATION;
+        }
+    }
+
+    *retPool = pool;
+
+    RJ_DebugInfo("Thread pool created with %u threads.", threadCount);
+    return RJ_OK;
+}
+
+void ThreadPool_Destroy(ThreadPool *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    ThreadPool_StopWorkers(pool, pool->threadCount);
+    ThreadPool_ConditionDestroy(&pool->doneCondition);
+    ThreadPool_ConditionDestroy(&pool->startCondition);
+    ThreadPool_MutexDestroy(&pool->mutex);
+
+    RJ_DebugInfo("Thread pool with %u threads destroyed.", pool->threadCount);
+    free(pool);
+}
+
+RJ_Size ThreadPool_GetThreadCount(const ThreadPool *pool)
+{
+    return pool == NULL ? 1 : pool->threadCount;
+}
+
+void ThreadPool_ParallelFor(ThreadPool *pool, RJ_Size itemCount, RJ_Size granularity, ThreadPoolTask task, void *userData)
+{
+    RJ_DebugAssertNullPointerCheck(task);
+    RJ_DebugAssert(granularity > 0, "Thread pool granularity can not be 0.");
+
+    RJ_Size threadCount = ThreadPool_GetThreadCount(pool);
+
+    if (pool == NULL || threadCount == 1 || itemCount <= granularity)
+    {
+        task(userData, 0, 0, itemCount);
+
+        for (RJ_Size i = 1; i < threadCount; i++)
+        {
+            task(userData, i, itemCount, 0);
+        }
+
+        return;
+    }
+
+    RJ_Size rangeSize = (itemCount + threadCount - 1) / threadCount;
+
+    ThreadPool_MutexLock(&pool->mutex);
+
+    pool->task = task;
+    pool->userData = userData;
+    pool->itemCount = itemCount;
+    pool->rangeSize = (rangeSize + granularity - 1) / granularity * granularity;
+    pool->pendingCount = threadCount - 1;
+    pool->generation++;
+
+    ThreadPool_ConditionBroadcast(&pool->startCondition);
+    ThreadPool_MutexUnlock(&pool->mutex);
+
+    ThreadPool_RunRange(pool, 0);
+
+    ThreadPool_MutexLock(&pool->mutex);
+
+    while (pool->pendingCount > 0)
+    {
+        ThreadPool_ConditionWait(&pool->doneCondition, &pool->mutex);
+    }
+
+    ThreadPool_MutexUnlock(&pool->mutex);
+}
@@ -1,5 +1,9 @@
 #include "utilities/Timer.h"
 
+#if RJ_PLATFORM == RJ_PLATFORM_WINDOWS
+#include <windows.h>
+#endif
+
 #define Timer_Min(a, b) ((a) < (b) ? (a) : (b))
 #define Timer_Max(a, b) ((a) > (b) ? (a) : (b))
 
@@ -35,6 +39,26 @@ void TimePoint_Update(TimePoint *timePoint)
     timePoint->nanoseconds = currentTime.tv_nsec;
 }
 
+uint64_t TimePoint_GetMonotonicNanoseconds(void)
+{
+#if RJ_PLATFORM == RJ_PLATFORM_WINDOWS
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    uint64_t ticksPerSecond = (uint64_t)frequency.QuadPart;
+    uint64_t ticks = (uint64_t)counter.QuadPart;
+
+    return ticks / ticksPerSecond * 1000000000ull + ticks % ticksPerSecond * 1000000000ull / ticksPerSecond;
+#else
+    struct timespec currentTime = {0, 0};
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+    return (uint64_t)currentTime.tv_sec * 1000000000ull + (uint64_t)currentTime.tv_nsec;
+#endif
+}
+
 float TimePoint_ToMilliseconds(const TimePoint *timePoint)
 {
     RJ_DebugAssert(timePoint != NULL, "Null pointer passed as parameter.");